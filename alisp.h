@@ -1,27 +1,51 @@
 #ifndef ALISP_H
 #define ALISP_H
 
+#include <stddef.h>
+
 // #define DEBUG
 
 // ---------------------------------------------------------------------- 
 // atom.c 
 
 /* Types of atomic objects */
-enum { NIL, NUMBER, SYMBOL, LIST, DICTIONARY, FUNCTION, STD_OP };
+enum { NIL, NUMBER, SYMBOL, LIST, DICTIONARY, FUNCTION, STD_OP, FUTURE, VECTOR, HASHMAP,
+       SET, F64ARRAY, MATRIX, PQUEUE, RANGE, GENERATOR, STRING, BUILDER };
 
 /* Standard operator types */
-enum { PRINT, PRINTLN, MATH1, MATH1_M, MATH2, MATH2_R, REL, COPY, TYPE,
-       LIST_NEW, LIST_GET, LIST_SET, LIST_LEN, LIST_ADD, LIST_INS, LIST_REM, LIST_MERGE };
+enum { PRINT, PRINTLN, FLUSH, MATH1, MATH1_M, MATH2, MATH2_R, REL, COPY, TYPE, FREEZE,
+       LIST_NEW, LIST_GET, LIST_SET, LIST_LEN, LIST_ADD, LIST_INS, LIST_REM, LIST_MERGE,
+       VEC_NEW, VEC_GET, VEC_SET, VEC_LEN, VEC_ADD, VEC_MERGE, VEC_FROM, VEC_LIST,
+       HM_NEW, HM_GET, HM_SET, HM_HAS, HM_DEL, HM_KEYS, HM_LEN,
+       SET_NEW, SET_ADD, SET_HAS, SET_REM, SET_UNION, SET_INTERSECT, SET_DIFFERENCE, SET_LEN,
+       SET_FROM, SET_LIST,
+       F64_NEW, F64_RANGE, F64_GET, F64_LEN, F64_LIST, F64_SUM, F64_DOT, F64_MIN, F64_MAX,
+       MAT_NEW, MAT_GET, MAT_ROWS, MAT_COLS, MAT_LIST, MAT_MUL, MAT_TRANSPOSE, MAT_SOLVE,
+       PQ_NEW, PQ_PUSH, PQ_POP, PQ_PEEK, PQ_LEN, RANGE_NEW, GEN_NEW, TO_LIST,
+       STR_CONCAT, STR_SUB, STR_LEN, STR_SPLIT, STR_JOIN, STR_FIND, SB_NEW, SB_ADD, SB_STR,
+       SB_LEN,
+       MAP, FILTER, REDUCE, FOLD, FOREACH, PMAP, PREDUCE, SORT, STABLE_SORT, BSEARCH,
+       LOWER_BOUND, NATIVE, SPAWN, AWAIT };
 
 typedef struct Atom atom_t;
+typedef struct Context alisp_ctx;
+typedef struct Buffer buf_t;
+typedef struct Future future_t;
+typedef struct Vector vec_t;
+
+/* Builtin implemented by the embedding program */
+typedef atom_t* (*native_t)(alisp_ctx*, int, atom_t**, void*);
 
 /* List */
 typedef struct List {
     atom_t*  bindlist;
     char     lock;
     int      len;
-    int      maxlen;
+    int      maxlen;    // slots from the first item to the end of the allocation
+    int      head;      // free slots before the first item
     atom_t** items;
+    atom_t*  base;      // list whose items a slice shares, NULL if the items are its own
+    int      slices;    // number of slices sharing the items
 } list_t;
 
 /* Dictionary */
@@ -35,6 +59,64 @@ typedef struct Dictionary {
     atom_t*  parent;
 } dict_t;
 
+/* Hash map */
+typedef struct Hashmap {
+    atom_t*   bindlist;
+    char      lock;
+    int       len;
+    int       maxlen;
+    atom_t**  keys;     // entries: keys owned by the map, values bound to it
+    atom_t**  vals;
+    unsigned* hashes;
+    int*      slots;    // entry number + 1 for every slot of the table, 0 if free
+    int       nslots;
+} hashmap_t;
+
+/* Priority queue */
+typedef struct PQueue {
+    atom_t*  bindlist;
+    char     lock;
+    char     busy;      // being ordered by the procedure
+    int      len;
+    int      maxlen;
+    atom_t** items;     // binary heap, bound to the queue
+    double*  prios;     // priorities of the items, unused with a procedure
+    atom_t*  proc;      // procedure ordering the items, or NULL
+} pqueue_t;
+
+/* String */
+#define STR_SMALL 16    // bytes of text kept inside a string, with the terminating zero
+
+typedef struct String {
+    int      len;
+    unsigned hash;      // hash of the text, 0 until it is needed
+    char*    data;      // text terminated by zero, in small or allocated
+    char     small[STR_SMALL];
+} string_t;
+
+/* Range */
+typedef struct Range {
+    double   start;
+    double   step;
+    int      len;       // number of items
+} range_t;
+
+/* Generator */
+typedef struct Generator {
+    atom_t*  bindlist;
+    char     lock;
+    atom_t*  proc;      // procedure making the next item of an item
+    atom_t*  init;      // first item
+} generator_t;
+
+/* F64 array */
+typedef struct F64Array {
+    int      len;
+    int      rows;      // shape of a matrix, rows x cols = len; 1 x len for an array
+    int      cols;
+    double*  data;      // aligned to F64_ALIGN
+} f64array_t;
+
 /* Function */
 typedef struct Function {
     atom_t* bindlist;
@@ -50,10 +132,23 @@ typedef struct Operator {
         double (*math1)(double);
         double (*math2)(double, double);
         double (*rel)(char, void*, void*);
+        struct {
+            native_t fn;
+            void*    data;
+        } native;
     } val;
     char type;
+    const char* name;   // name in the global environment
 } operator_t;
 
+/* Atom flags */
+enum { F_ARENA  = 1,            // allocated in a parse tree arena, not owned by the heap
+       F_STATIC = 2,            // statically allocated, shared by all contexts
+       F_SHARED = 4,            // inherited from the zygote process, read-only
+       F_FROZEN = 8 };          // immutable, lives as long as the process
+
+#define F_UNCOUNTED (F_ARENA | F_STATIC | F_SHARED | F_FROZEN)  // no binding bookkeeping
+
 /* Atomic object */
 typedef struct Atom {
     union {
@@ -63,8 +158,18 @@ typedef struct Atom {
         dict_t*     dict;
         function_t* func;
         operator_t* oper;
+        future_t*   fut;
+        vec_t*      vec;
+        hashmap_t*  hm;
+        pqueue_t*   pq;
+        range_t*    rng;
+        generator_t* gen;
+        string_t*   str;
+        buf_t*      buf;
+        f64array_t* arr;
     } val;
     char     type;
+    char     flags;
     unsigned bindings;
 } atom_t;
 
@@ -76,23 +181,78 @@ atom_t* func(atom_t*, atom_t*, atom_t*);
 void    atom_del(atom_t*);
 char*   atom_tostring(atom_t*, int);
 atom_t* atom_copy(atom_t*);
-atom_t* atom_cp(atom_t*, atom_t*, atom_t*);
 char*   atom_type(atom_t*);
 void    atom_bind(atom_t*, atom_t*);
 void    atom_unbind(atom_t*, atom_t*);
+void    atom_share(atom_t*, int);
+int     atom_freeze(atom_t*);
 int     atom_bound_in(atom_t*, atom_t*);
-void    atom_get_owners_r(atom_t*, atom_t*);
 int     atom_is_container(atom_t*);
+int     atom_true(atom_t*);
 void    assert_arg(atom_t*, const char*);
 
 #define atom_tostr(obj) atom_tostring(obj, 2)
 
+// ---------------------------------------------------------------------- 
+// arena.c
+
+#define ARENA_CHUNK 65536       // default chunk size
+#define ARENA_ALIGN 8           // alignment of allocations
+
+/* Arena chunk */
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t size;
+    size_t used;
+    char   mem[];
+} arena_chunk_t;
+
+/* Arena */
+typedef struct Arena {
+    arena_chunk_t* head;
+} arena_t;
+
+arena_t* arena_new(size_t);
+void*    arena_alloc(arena_t*, size_t);
+char*    arena_strdup(arena_t*, const char*, size_t);
+void     arena_reset(arena_t*);
+void     arena_adopt(arena_t*, arena_t*);
+void     arena_del(arena_t*);
+
+
+// ---------------------------------------------------------------------- 
+// pool.c
+
+typedef struct Pool pool_t;
+
+pool_t* pool_new(int);
+void    pool_submit(pool_t*, void (*)(void*), void*);
+void    pool_wait(pool_t*);
+int     pool_help(pool_t*);
+int     pool_size(pool_t*);
+void    pool_del(pool_t*);
+
+
+// ---------------------------------------------------------------------- 
+// task.c
+
+#define TASK_THREADS_ENV "ALISP_THREADS"   // overrides the number of task threads
+#define TASK_GRAIN       256               // fewest list items worth a task of pmap, preduce
+
+atom_t* task_spawn(alisp_ctx*, atom_t*, int, atom_t**);
+atom_t* task_await(alisp_ctx*, atom_t*, atom_t*);
+atom_t* task_map(alisp_ctx*, atom_t*, atom_t*, atom_t*);
+atom_t* task_reduce(alisp_ctx*, atom_t*, atom_t*, atom_t*, atom_t*);
+void    future_release(future_t*);
+
+
 // ---------------------------------------------------------------------- 
 // list.c
 
+#define LIST_SLICE_MIN 32   // fewest items worth sharing by a slice instead of copying
+
 atom_t* list();
 void    list_del(atom_t*);
-atom_t* list_cp(atom_t*, atom_t*, atom_t*);
 void    list_insert(atom_t*, int, atom_t*, char);
 int     list_idx(atom_t*, atom_t*);
 int     list_lookup(atom_t*, atom_t*, int*);
@@ -102,6 +262,10 @@ void    list_print(atom_t*, int);
 void    list_assert(atom_t*, const char*);
 int     list_len(atom_t*);
 int     list_maxlen(atom_t*);
+void    list_reserve(atom_t*, int);
+void    list_append(atom_t*, atom_t**, int);
+atom_t* list_slice(atom_t*, int, int);
+void    list_own(atom_t*);
 void    list_free(atom_t*);
 
 #define list_ins(list, idx, item)    list_insert(list, idx, item, 1)
@@ -112,12 +276,191 @@ void    list_free(atom_t*);
 #define list_rem_h(list, idx)        list_remove(list, idx, 0)
 
 
+// ---------------------------------------------------------------------- 
+// vec.c
+
+#define VEC_BITS  5                 // index bits per tree level
+#define VEC_WIDTH (1 << VEC_BITS)   // slots in a tree node
+
+atom_t* vec_new(atom_t**, int);
+int     vec_fill(atom_t*, atom_t**, int);
+atom_t* vec_share(atom_t*);
+atom_t* vec_get(atom_t*, int);
+atom_t* vec_set(atom_t*, int, atom_t*);
+atom_t* vec_add(atom_t*, atom_t**, int);
+atom_t* vec_slice(atom_t*, int, int);
+atom_t* vec_merge(atom_t**, int);
+atom_t* vec_from(atom_t*);
+atom_t* vec_list(atom_t*);
+atom_t* vec_item(atom_t*, int);
+int     vec_len(atom_t*);
+char*   vec_tostr(atom_t*, int);
+void    vec_release(vec_t*);
+
+
+// ---------------------------------------------------------------------- 
+// hashmap.c
+
+atom_t* hm_new(int);
+void    hm_del(atom_t*);
+int     hm_iskey(atom_t*);
+atom_t* hm_get(atom_t*, atom_t*);
+void    hm_set(atom_t*, atom_t*, atom_t*);
+int     hm_remove(atom_t*, atom_t*);
+int     hm_len(atom_t*);
+atom_t* hm_keys(atom_t*);
+char*   hm_tostr(atom_t*, int);
+atom_t* set_new(int);
+void    set_add(atom_t*, atom_t*);
+int     set_has(atom_t*, atom_t*);
+atom_t* set_copy(atom_t*);
+atom_t* set_union(atom_t*, atom_t*);
+atom_t* set_intersect(atom_t*, atom_t*);
+atom_t* set_difference(atom_t*, atom_t*);
+
+
+// ---------------------------------------------------------------------- 
+// pqueue.c
+
+atom_t* pq_new(atom_t*);
+void    pq_del(atom_t*);
+int     pq_len(atom_t*);
+atom_t* pq_proc(atom_t*);
+atom_t* pq_peek(atom_t*);
+void    pq_append(atom_t*, atom_t*, double);
+double  pq_prio(atom_t*, int);
+atom_t* pq_item(atom_t*, int);
+int     pq_push(alisp_ctx*, atom_t*, atom_t*, atom_t*, double);
+atom_t* pq_pop(alisp_ctx*, atom_t*, atom_t*);
+char*   pq_tostr(atom_t*, int);
+
+
+// ---------------------------------------------------------------------- 
+// str.c
+
+#define STR_MAX_LEN (1 << 30)       // most bytes of a string
+
+atom_t*  str_new(const char*, int);
+void     str_del(atom_t*);
+atom_t*  str_copy(atom_t*);
+int      str_len(atom_t*);
+char*    str_data(atom_t*);
+unsigned str_hash(atom_t*);
+int      str_eq(atom_t*, atom_t*);
+int      str_cmp(atom_t*, atom_t*);
+char*    str_tostr(atom_t*);
+atom_t*  str_concat(atom_t**, int);
+atom_t*  str_sub(atom_t*, int, int);
+int      str_find(atom_t*, atom_t*, int);
+atom_t*  str_split(atom_t*, atom_t*);
+atom_t*  str_join(atom_t*, atom_t*);
+atom_t*  sb_new();
+void     sb_del(atom_t*);
+int      sb_len(atom_t*);
+int      sb_add(atom_t*, atom_t*);
+atom_t*  sb_str(atom_t*);
+atom_t*  sb_copy(atom_t*);
+
+
+// ---------------------------------------------------------------------- 
+// range.c
+
+/* Walk through a lazy sequence */
+typedef struct Iter {
+    atom_t*  seq;
+    int      i;         // index of the next item of a range
+    atom_t*  item;      // last item of a generator, bound to env
+    atom_t*  env;
+} iter_t;
+
+atom_t* range_make(double, double, int);
+atom_t* range_new(double, double, double);
+void    range_del(atom_t*);
+atom_t* range_copy(atom_t*);
+int     range_len(atom_t*);
+double  range_item(atom_t*, int);
+double  range_step(atom_t*);
+atom_t* range_slice(atom_t*, int, int);
+char*   range_tostr(atom_t*);
+atom_t* gen_new(atom_t*, atom_t*);
+void    gen_set(atom_t*, atom_t*, atom_t*);
+void    gen_del(atom_t*);
+atom_t* gen_proc(atom_t*);
+atom_t* gen_init(atom_t*);
+int     seq_is(atom_t*);
+void    iter_init(iter_t*, alisp_ctx*, atom_t*);
+atom_t* iter_next(alisp_ctx*, atom_t*, iter_t*, int*);
+void    iter_done(iter_t*);
+atom_t* seq_map(alisp_ctx*, atom_t*, atom_t*, atom_t*, int);
+atom_t* seq_fold(alisp_ctx*, atom_t*, atom_t*, atom_t*, atom_t*);
+int     seq_foreach(alisp_ctx*, atom_t*, atom_t*, atom_t*);
+atom_t* seq_list(alisp_ctx*, atom_t*, atom_t*);
+int     seq_len(alisp_ctx*, atom_t*, atom_t*, int*);
+
+
+// ---------------------------------------------------------------------- 
+// f64array.c
+
+#define F64_SIMD_ENV "ALISP_SIMD"   // limits array kernels to: scalar, sse2, avx2
+#define F64_MAX_LEN  (1 << 28)      // most items of an array
+
+atom_t* f64_new(int);
+void    f64_del(atom_t*);
+int     f64_len(atom_t*);
+double* f64_data(atom_t*);
+int     f64_is(atom_t*);
+atom_t* f64_copy(atom_t*);
+atom_t* f64_from(atom_t*);
+atom_t* f64_range(double, double, double);
+atom_t* f64_list(atom_t*);
+atom_t* f64_math1(atom_t*, double (*)(double));
+atom_t* f64_math2(atom_t*, atom_t*, double (*)(double, double));
+double  f64_sum(atom_t*);
+double  f64_dot(atom_t*, atom_t*);
+double  f64_vdot(const double*, const double*, int);
+void    f64_madd(double*, int, const double*, int, const double*, int, int, int, int);
+double  f64_min(atom_t*);
+double  f64_max(atom_t*);
+char*   f64_tostr(atom_t*);
+
+
+// ---------------------------------------------------------------------- 
+// matrix.c
+
+atom_t* mat_new(int, int);
+int     mat_rows(atom_t*);
+int     mat_cols(atom_t*);
+atom_t* mat_from(atom_t*);
+atom_t* mat_list(atom_t*);
+atom_t* mat_mul(atom_t*, atom_t*);
+atom_t* mat_transpose(atom_t*);
+atom_t* mat_solve(atom_t*, atom_t*);
+char*   mat_tostr(atom_t*);
+
+
+// ---------------------------------------------------------------------- 
+// sort.c
+
+/* Comparison of items by a procedure */
+typedef struct Order {
+    alisp_ctx* ctx;
+    atom_t*    expr;
+    atom_t*    proc;    // NULL to compare like <
+    int        desc;    // compare like > instead
+    int        err;     // comparison failed, stop
+} order_t;
+
+void    order_init(order_t*, alisp_ctx*, atom_t*, atom_t*);
+int     order_less(order_t*, atom_t*, atom_t*);
+atom_t* sort_items(alisp_ctx*, atom_t*, atom_t*, atom_t**, int, int);
+int     search_items(alisp_ctx*, atom_t*, atom_t*, atom_t**, int, atom_t*, int, int*);
+
+
 // ---------------------------------------------------------------------- 
 // dict.c
 
 atom_t*  dict(int, atom_t*);
 void     dict_del(atom_t*);
-atom_t*  dict_cp(atom_t*, atom_t*, atom_t*);
 void     dict_add(atom_t*, char*, atom_t*);
 atom_t*  dict_get(atom_t*, char*);
 atom_t*  dict_find(atom_t*, char*);
@@ -130,29 +473,80 @@ void     dict_assert(atom_t*, const char*);
 // ---------------------------------------------------------------------- 
 // globenv.c
 
-extern atom_t* global_env;
-extern atom_t* active_env;
+void globenv_init(alisp_ctx*);
+void globenv_del(alisp_ctx*);
+
+
+// ---------------------------------------------------------------------- 
+// image.c
+
+#define IMG_VERSION 2           // heap image format version
+
+int     image_dump(alisp_ctx*, buf_t*);
+int     image_dump_values(alisp_ctx*, atom_t*, int, buf_t*);
+int     image_restore(alisp_ctx*, const char*, size_t);
+atom_t* image_restore_values(alisp_ctx*, const char*, size_t);
+int     image_save(alisp_ctx*, const char*);
+int     image_load(alisp_ctx*, const char*);
+
+
+// ---------------------------------------------------------------------- 
+// ptrmap.c
+
+/* Pointer map */
+typedef struct PtrMap {
+    const void** keys;
+    void**       vals;
+    size_t       len;
+    size_t       max;
+} ptrmap_t;
 
-void globenv_init(void);
-void globenv_del(void);
+ptrmap_t* ptrmap_new(size_t);
+void*     ptrmap_get(const ptrmap_t*, const void*);
+void      ptrmap_put(ptrmap_t*, const void*, void*);
+void      ptrmap_del(ptrmap_t*);
 
 
 // ---------------------------------------------------------------------- 
 // main.c 
 
-extern char* input;
+void repl(alisp_ctx*);
+void magic(alisp_ctx*);
+
+
+// ---------------------------------------------------------------------- 
+// server.c
+
+#define SERVE_MAXREQ (64 << 20)  // largest request accepted by the server, bytes
+#define SERVE_TIMEOUT 5          // seconds a worker waits for the rest of a request
+
+int serve(alisp_ctx*, const char*, int);
+
 
-void script(const char*);
-void repl(void);
-void magic(void);
+// ---------------------------------------------------------------------- 
+// zygote.c
+
+int zygote(alisp_ctx*, int);
+
+
+// ---------------------------------------------------------------------- 
+// api.c
+
+int script(alisp_ctx*, const char*);
 
 
 // ---------------------------------------------------------------------- 
 // eval.c apply.c
 
-atom_t* eval(atom_t*, atom_t*, atom_t**);
-atom_t* apply(atom_t*, atom_t*, atom_t*);
-atom_t* apply_op(atom_t*, atom_t*, int, atom_t**);
+atom_t* eval(alisp_ctx*, atom_t*, atom_t*, atom_t**);
+atom_t* apply(alisp_ctx*, atom_t*, atom_t*, atom_t*);
+atom_t* apply_argv(alisp_ctx*, atom_t*, atom_t*, int, atom_t**);
+atom_t* call(alisp_ctx*, atom_t*, atom_t*);
+atom_t* map_items(alisp_ctx*, atom_t*, atom_t*, atom_t**, int);
+atom_t* filter_items(alisp_ctx*, atom_t*, atom_t*, atom_t**, int);
+atom_t* fold_items(alisp_ctx*, atom_t*, atom_t*, atom_t*, atom_t**, int);
+int     foreach_items(alisp_ctx*, atom_t*, atom_t*, atom_t**, int);
+atom_t* apply_op(alisp_ctx*, atom_t*, atom_t*, int, atom_t**);
 
 
 // ---------------------------------------------------------------------- 
@@ -161,22 +555,116 @@ atom_t* apply_op(atom_t*, atom_t*, int, atom_t**);
 #define DELIM       "()"        // delimiters
 #define RESERVED    "\"#$"      // can't be used in symbolic names
 
+#define PARSE_CHUNK 65536       // minimal chunk of source for a parallel parse job
+
 /* Token. */
 typedef struct {
     char*       val;
     const char* pos;
+    int         n;              // number of subexpressions, for '('
 } token_t;
 
+/* Parser state. */
+typedef struct {
+    const char* input;          // text to parse
+    const char* end;            // end of text
+    const char* context;        // text that error positions refer to
+    token_t**   tokens;         // list of tokens
+    token_t**   tok;            // token pointer
+    unsigned    ntok;           // number of tokens
+    arena_t*    arena;          // parse tree arena
+    const char* errtype;        // first error encountered
+    const char* errmsg;
+    const char* errpos;
+} parser_t;
+
 /* Parse */
-atom_t* parse(void);
-atom_t* read_from_tokens(void);
-atom_t* make_atom(token_t*);
+atom_t* parse(const char*, arena_t*);
+atom_t* parse_parallel(const char*, arena_t*, pool_t*);
+atom_t* read_top(parser_t*, int);
+atom_t* read_from_tokens(parser_t*);
+atom_t* make_atom(parser_t*, token_t*);
+int     count_subexpr(parser_t*);
+int     split_top(const char*, const char*, size_t, const char**, int);
+atom_t* node_new(arena_t*, char);
+atom_t* node_num(arena_t*, double);
+atom_t* node_sym(arena_t*, const char*, size_t);
+atom_t* node_str(arena_t*, const char*, size_t);
+atom_t* node_list(arena_t*, int);
+
+/* Parser state */
+void parser_init(parser_t*, const char*, const char*, const char*, arena_t*);
+void parser_error(parser_t*, const char*, const char*, const char*);
+int  parser_report(parser_t*);
 
 /* Tokenize */
-void     tokenize(void);
+void     tokenize(parser_t*);
 token_t* tok_new(char*, const char*);
-unsigned tok_len(void);
-void     tokens_del(void);
+void     tokens_del(parser_t*);
+
+
+// ---------------------------------------------------------------------- 
+// cache.c
+
+#define ALC_VERSION     2       // cache file format version
+#define CACHE_MAXDEPTH  10000   // maximal nesting of a cached parse tree
+
+char*   cache_path(const char*, unsigned long long);
+void    cache_save(const char*, const char*, size_t, atom_t*);
+atom_t* cache_load(const char*, const char*, size_t, arena_t*);
+
+
+// ---------------------------------------------------------------------- 
+// output.c
+
+#define OUT_BUFSIZE 65536       // output buffer size
+#define OUT_FD      1           // default output: stdout
+
+/* Output buffering modes */
+enum { OUT_FULL, OUT_LINE, OUT_MEMORY };  // OUT_MEMORY: keep all output in the buffer
+
+/* Output buffer */
+typedef struct Output {
+    char*  buf;
+    size_t len;
+    size_t max;
+    int    mode;
+    int    fd;
+} output_t;
+
+void out_init(void);
+void out_open(output_t*, int);
+void out_close(output_t*);
+void out_setmode(int);
+void out_flush(void);
+void out_write(const char*, size_t);
+void out_str(const char*);
+void out_char(char);
+void out_num(double);
+void out_printf(const char*, ...);
+
+
+// ---------------------------------------------------------------------- 
+// context.c
+
+/* Interpreter context */
+struct Context {
+    atom_t*  global_env;        // global environment
+    atom_t*  active_env;        // environment of the expression being evaluated
+    arena_t* arena;             // parse tree arena for REPL input
+    char*    input;             // REPL input line
+    int      parse_jobs;        // number of threads for parsing scripts
+    pool_t*  pool;              // parser threads
+    int      use_cache;         // load and save parse trees of scripts in .alc files
+    output_t out;               // output buffer
+};
+
+extern __thread alisp_ctx* ctx_cur;
+
+alisp_ctx* ctx_new(void);
+alisp_ctx* ctx_set(alisp_ctx*);
+void       ctx_set_jobs(alisp_ctx*, int);
+void       ctx_del(alisp_ctx*);
 
 
 // ---------------------------------------------------------------------- 
@@ -192,16 +680,29 @@ void safe_memory_free(void**);
 #define safe_free(ptr) safe_memory_free((void**) &(ptr))
 
 /* Strings */
-char* strip_quotes(const char*);
-char* add_quotes(const char*);
 int   streq(const char*, const char*);
 
+/* Byte buffers */
+struct Buffer {
+    char*  data;
+    size_t len;
+    size_t max;
+};
+
+void buf_put(buf_t*, const void*, size_t);
+void buf_putv(buf_t*, unsigned long long);
+int  buf_getv(const char**, const char*, unsigned long long*);
+
+/* Hashing */
+unsigned long long hash_bytes(const char*, size_t);
+
 
 // ---------------------------------------------------------------------- 
 // operators.c
 
 atom_t* op_print();
 atom_t* op_println();
+atom_t* op_flush();
 atom_t* op_math1(double (*op)(double));
 atom_t* op_math1m(double (*op)(double));
 atom_t* op_math2(double (*op)(double, double));
@@ -209,6 +710,7 @@ atom_t* op_math2r(double (*op)(double, double));
 atom_t* op_rel(double (*op)(char, void*, void*));
 atom_t* op_copy();
 atom_t* op_type();
+atom_t* op_freeze();
 atom_t* op_list();
 atom_t* op_list_get();
 atom_t* op_list_set();
@@ -217,6 +719,80 @@ atom_t* op_list_add();
 atom_t* op_list_ins();
 atom_t* op_list_rem();
 atom_t* op_list_merge();
+atom_t* op_vec();
+atom_t* op_vec_get();
+atom_t* op_vec_set();
+atom_t* op_vec_len();
+atom_t* op_vec_add();
+atom_t* op_vec_merge();
+atom_t* op_vec_from();
+atom_t* op_vec_list();
+atom_t* op_hashmap();
+atom_t* op_hm_get();
+atom_t* op_hm_set();
+atom_t* op_hm_has();
+atom_t* op_hm_del();
+atom_t* op_hm_keys();
+atom_t* op_hm_len();
+atom_t* op_set();
+atom_t* op_set_add();
+atom_t* op_set_has();
+atom_t* op_set_rem();
+atom_t* op_set_union();
+atom_t* op_set_intersect();
+atom_t* op_set_difference();
+atom_t* op_pq_new();
+atom_t* op_pq_push();
+atom_t* op_pq_pop();
+atom_t* op_pq_peek();
+atom_t* op_pq_len();
+atom_t* op_range();
+atom_t* op_generator();
+atom_t* op_to_list();
+atom_t* op_concat();
+atom_t* op_substr();
+atom_t* op_str_len();
+atom_t* op_split();
+atom_t* op_join();
+atom_t* op_find();
+atom_t* op_sb_new();
+atom_t* op_sb_add();
+atom_t* op_sb_str();
+atom_t* op_sb_len();
+atom_t* op_set_len();
+atom_t* op_set_from();
+atom_t* op_set_list();
+atom_t* op_f64array();
+atom_t* op_f64_range();
+atom_t* op_f64_get();
+atom_t* op_f64_len();
+atom_t* op_f64_list();
+atom_t* op_sum();
+atom_t* op_dot();
+atom_t* op_min();
+atom_t* op_max();
+atom_t* op_matrix();
+atom_t* op_mat_get();
+atom_t* op_mat_rows();
+atom_t* op_mat_cols();
+atom_t* op_mat_list();
+atom_t* op_matmul();
+atom_t* op_transpose();
+atom_t* op_solve();
+atom_t* op_map();
+atom_t* op_filter();
+atom_t* op_reduce();
+atom_t* op_fold();
+atom_t* op_foreach();
+atom_t* op_pmap();
+atom_t* op_preduce();
+atom_t* op_sort();
+atom_t* op_stable_sort();
+atom_t* op_bsearch();
+atom_t* op_lower_bound();
+atom_t* op_native(native_t, void*);
+atom_t* op_spawn();
+atom_t* op_await();
 
 double op_add(double, double);
 double op_sub(double, double);
@@ -0,0 +1,280 @@
+/*
+Embedding API.
+Implementation of libalisp.h on top of interpreter contexts, and running of script
+files, shared by the interpreter executable and the library.
+
+API calls make their context current for the calling thread and restore the previous
+current context and active environment on return, so they can be nested: a native
+builtin may call back into the interpreter.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alisp.h"
+#include "libalisp.h"
+
+/*
+--------------------------------------
+script
+
+    Run a script. Return 0 if it failed to load, parse or evaluate.
+--------------------------------------
+*/
+int script(alisp_ctx* ctx, const char* filename) {
+    if (!filename) {
+        errmsg("Script", "no file name given", NULL, NULL);
+        return 0;
+    }
+
+    FILE *f;
+    if ((f = fopen(filename, "r")) == NULL) {
+        errmsg("Script", "failed to open file", filename, filename);
+        return 0;
+    }
+
+    // Get the size of the file
+    fseek(f, 0L, SEEK_END);
+    long bufsize = ftell(f);
+    if (bufsize == -1) {
+        errmsg("Script", "failed to read file", filename, filename);
+        fclose(f);
+        return 0;
+    }
+
+    char* src = malloc(sizeof(char) * (bufsize + 1));
+
+    // Read the entire file into memory
+    fseek(f, 0L, SEEK_SET);
+    size_t i = fread(src, sizeof(char), bufsize, f);
+    if (ferror(f)) {
+        errmsg("Script", "failed to read file", filename, filename);
+        fclose(f);
+        safe_free(src);
+        return 0;
+    } else
+        src[i] = '\0';
+    fclose(f);
+
+    if (strlen(src) == 0) {
+        safe_free(src);
+        return 1;
+    }
+
+#ifdef DEBUG
+printf("....  script:                  Building parse tree\n");
+#endif
+
+    // Parse
+    arena_t* arena = arena_new(bufsize * 2);
+    atom_t* parse_tree = ctx->use_cache ? cache_load(filename, src, i, arena) : NULL;
+
+    if (!parse_tree) {
+        parse_tree = ctx->pool ? parse_parallel(src, arena, ctx->pool) :
+            parse(src, arena);
+        if (parse_tree && ctx->use_cache)
+            cache_save(filename, src, i, parse_tree);
+    }
+
+    if (!parse_tree) {
+        arena_del(arena);
+        safe_free(src);
+        return 0;
+    }
+
+#ifdef DEBUG
+printf("....  script:                  Evaluating parse tree\n");
+#endif
+
+    // Evaluate
+    atom_t* v = eval(ctx, parse_tree, ctx->global_env, NULL);
+
+#ifdef DEBUG
+printf("....  script:                  Deallocating parse tree\n");
+#endif
+
+    arena_del(arena);
+    safe_free(src);
+    return v != NULL;
+}
+
+
+// ---------------------------------------------------------------------- 
+// Contexts
+
+/* Make an interpreter. */
+alisp_ctx* alisp_new() {
+    out_init();
+    alisp_ctx* prev = ctx_cur;
+    alisp_ctx* ctx = ctx_new();
+    ctx_set(prev);
+    return ctx;
+}
+
+/* Deallocate an interpreter, flushing its output. */
+void alisp_free(alisp_ctx* ctx) {
+    ctx_del(ctx);
+}
+
+/* Write pending output of an interpreter. */
+void alisp_flush(alisp_ctx* ctx) {
+    alisp_ctx* prev = ctx_set(ctx);
+    out_flush();
+    ctx_set(prev);
+}
+
+
+// ---------------------------------------------------------------------- 
+// Evaluation
+
+/*
+--------------------------------------
+alisp_eval
+
+    Parse and evaluate source text in the global environment.  Return the value of
+    the last expression, or NULL on error.
+--------------------------------------
+*/
+alisp_value* alisp_eval(alisp_ctx* ctx, const char* src) {
+    alisp_ctx* prev = ctx_set(ctx);
+    atom_t* env = ctx->active_env;
+
+    // Parse into a private arena: the call may be nested in evaluation of another tree
+    arena_t* arena = arena_new(strlen(src) * 2);
+    atom_t* parse_tree = parse(src, arena);
+    atom_t* v = parse_tree ? eval(ctx, parse_tree, ctx->global_env, NULL) : NULL;
+    arena_del(arena);
+
+    ctx->active_env = env;
+    ctx_set(prev);
+    return v;
+}
+
+/* Run a script file. Return 0 on error. */
+int alisp_run(alisp_ctx* ctx, const char* filename) {
+    alisp_ctx* prev = ctx_set(ctx);
+    atom_t* env = ctx->active_env;
+    int ok = script(ctx, filename);
+    ctx->active_env = env;
+    ctx_set(prev);
+    return ok;
+}
+
+/*
+--------------------------------------
+alisp_call
+
+    Apply a function or builtin to arguments.  Arguments not referenced by the
+    interpreter are released by the call.  Return the result, or NULL on error.
+--------------------------------------
+*/
+alisp_value* alisp_call(alisp_ctx* ctx, alisp_value* fn, int argc, alisp_value** argv) {
+    if (!fn || (fn->type != FUNCTION && fn->type != STD_OP)) {
+        alisp_error(ctx, "object is not callable");
+        for (int i = 0; i < argc; ++i)
+            alisp_release(ctx, argv[i]);
+        return NULL;
+    }
+
+    alisp_ctx* prev = ctx_set(ctx);
+    atom_t* args = list();
+    for (int i = 0; i < argc; ++i)
+        list_add(args, argv[i]);
+    atom_t* v = call(ctx, fn, args);
+    ctx_set(prev);
+    return v;
+}
+
+
+// ---------------------------------------------------------------------- 
+// Global environment
+
+/* Return value of a global variable, or NULL if it is not defined. */
+alisp_value* alisp_get(alisp_ctx* ctx, const char* name) {
+    return dict_get(ctx->global_env, (char*)name);
+}
+
+/* Define or reassign a global variable. The interpreter takes the value. */
+int alisp_set(alisp_ctx* ctx, const char* name, alisp_value* val) {
+    if (!name || !*name || !val)
+        return 0;
+    alisp_ctx* prev = ctx_set(ctx);
+    dict_add(ctx->global_env, (char*)name, val);
+    ctx_set(prev);
+    return 1;
+}
+
+/*
+--------------------------------------
+alisp_register
+
+    Define a global builtin implemented by a native function.  The function gets
+    the arguments and returns a new value, one of the arguments, or NULL after
+    reporting an error with alisp_error.
+--------------------------------------
+*/
+int alisp_register(alisp_ctx* ctx, const char* name, alisp_native fn, void* data) {
+    if (!fn || !alisp_set(ctx, name, op_native(fn, data)))
+        return 0;
+
+    // Builtins are known by name in images
+    int idx;
+    dict_lookup(ctx->global_env, (char*)name, &idx);
+    dict_t* d = ctx->global_env->val.dict;
+    d->vals[idx]->val.oper->name = d->keys[idx];
+    return 1;
+}
+
+
+// ---------------------------------------------------------------------- 
+// Values
+
+alisp_value* alisp_nil() {
+    return &nilobj;
+}
+
+alisp_value* alisp_number(double x) {
+    return num(x);
+}
+
+/* Make a string value. */
+alisp_value* alisp_string(const char* s) {
+    return str_new(s, strlen(s));
+}
+
+int alisp_type(const alisp_value* val) {
+    return val->type;
+}
+
+/* Return value of a number, or 0 for other types. */
+double alisp_tonumber(const alisp_value* val) {
+    return val->type == NUMBER ? *val->val.num : 0;
+}
+
+/* Return text of a symbol or string, or NULL for other types. */
+const char* alisp_tosymbol(const alisp_value* val) {
+    if (val->type == STRING)
+        return val->val.str->data;
+    return val->type == SYMBOL ? val->val.sym : NULL;
+}
+
+/* Return newly allocated printed form of a value. */
+char* alisp_tostr(const alisp_value* val) {
+    return atom_tostr((atom_t*)val);
+}
+
+/* Report an error from a native builtin. */
+void alisp_error(alisp_ctx* ctx, const char* msg) {
+    alisp_ctx* prev = ctx_set(ctx);
+    errmsg("Native", msg, NULL, NULL);
+    ctx_set(prev);
+}
+
+/* Release a value. Does nothing for values referenced by the interpreter. */
+void alisp_release(alisp_ctx* ctx, alisp_value* val) {
+    if (!val)
+        return;
+    alisp_ctx* prev = ctx_set(ctx);
+    atom_del(val);
+    ctx_set(prev);
+}
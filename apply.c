@@ -7,23 +7,27 @@ Apply a procedure to arguments.
 #include <string.h>
 #include "alisp.h"
 
+/* Apply a procedure to a list of arguments. */
+atom_t* apply(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t* args) {
+    return apply_argv(ctx, expr, proc, list_len(args), args->val.list->items);
+}
+
 /*
 --------------------------------------
-apply
+apply_argv
 
-    Apply a procedure to arguments.
+    Apply a procedure to an array of arguments.  Arguments must be protected by the
+    caller.
 --------------------------------------
 */
-atom_t* apply(atom_t* expr, atom_t* proc, atom_t* args) {
+atom_t* apply_argv(alisp_ctx* ctx, atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
 
-    int argc = list_len(args);
-    atom_t** argv = args->val.list->items;
-    atom_t* env = active_env;
+    atom_t* env = ctx->active_env;
 
     // -------------------------------------
     // standard operator
     if (proc->type == STD_OP) {
-        return apply_op(expr, proc, argc, argv);
+        return apply_op(ctx, expr, proc, argc, argv);
 
     // -------------------------------------
     // function
@@ -53,8 +57,8 @@ safe_free(dbg_s2);
 #endif
 
         // Evaluate body in the environment
-        atom_t* v = eval(proc->val.func->body, fenv, NULL);
-        active_env = env;
+        atom_t* v = eval(ctx, proc->val.func->body, fenv, NULL);
+        ctx->active_env = env;
 
 #ifdef DEBUG
 dbg_s = atom_tostr(v);
@@ -78,6 +82,133 @@ safe_free(dbg_s);
 }
 
 
+/*
+--------------------------------------
+call
+
+    Apply a procedure to a list of arguments made by the caller, the way eval applies
+    a procedure call: procedure and arguments are protected while applying, and the
+    result while the argument list is deallocated.  Return the result.
+--------------------------------------
+*/
+atom_t* call(alisp_ctx* ctx, atom_t* proc, atom_t* args) {
+    atom_t* env = ctx->active_env;
+    atom_bind(proc, env);
+    atom_bind(args, env);
+    atom_t* v = apply(ctx, args, proc, args);
+    ctx->active_env = env;
+    atom_unbind(proc, env);
+    atom_unbind(args, env);
+    if (v)
+        atom_bind(v, env);
+    atom_del(args);
+    if (v)
+        atom_unbind(v, env);
+    return v;
+}
+
+
+/*
+--------------------------------------
+map_items
+
+    Return the list of a procedure applied to every item, or NULL on error.  Items
+    must be protected by the caller.
+--------------------------------------
+*/
+atom_t* map_items(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t** items, int n) {
+    atom_t* env = ctx->active_env;
+    atom_t* v = list();
+    list_reserve(v, n);
+    atom_bind(v, env);  // protect results while the procedure is applied
+    for (int i = 0; i < n; ++i) {
+        atom_t* r = apply_argv(ctx, expr, proc, 1, &items[i]);
+        if (!r) {
+            atom_unbind(v, env);
+            atom_del(v);
+            return NULL;
+        }
+        list_add(v, r);
+    }
+    atom_unbind(v, env);
+    return v;
+}
+
+/*
+--------------------------------------
+filter_items
+
+    Return the list of items a predicate is true for, or NULL on error.  Items must be
+    protected by the caller.
+--------------------------------------
+*/
+atom_t* filter_items(alisp_ctx* ctx, atom_t* expr, atom_t* pred, atom_t** items, int n) {
+    atom_t* env = ctx->active_env;
+    atom_t* v = list();
+    atom_bind(v, env);
+    for (int i = 0; i < n; ++i) {
+        atom_t* r = apply_argv(ctx, expr, pred, 1, &items[i]);
+        if (!r) {
+            atom_unbind(v, env);
+            atom_del(v);
+            return NULL;
+        }
+        if (atom_true(r))
+            list_add(v, items[i]);
+        atom_del(r);
+    }
+    atom_unbind(v, env);
+    return v;
+}
+
+/*
+--------------------------------------
+fold_items
+
+    Fold items with a procedure of the accumulator and an item, starting at acc.
+    Return the result, or NULL on error.  Items must be protected by the caller.
+--------------------------------------
+*/
+atom_t* fold_items(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t* acc, atom_t** items,
+                   int n) {
+    atom_t* env = ctx->active_env;
+    atom_t* args[2];
+    for (int i = 0; i < n; ++i) {
+        args[0] = acc;
+        args[1] = items[i];
+        atom_bind(acc, env);  // protect the accumulator until the next one is made
+        atom_t* r = apply_argv(ctx, expr, proc, 2, args);
+        if (r)
+            atom_bind(r, env);
+        atom_unbind(acc, env);
+        atom_del(acc);
+        if (!r)
+            return NULL;
+        atom_unbind(r, env);
+        acc = r;
+    }
+    return acc;
+}
+
+/*
+--------------------------------------
+foreach_items
+
+    Apply a procedure to every item for its effects. Return 0 on error.  Items must
+    be protected by the caller.
+--------------------------------------
+*/
+int foreach_items(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t** items, int n) {
+    for (int i = 0; i < n; ++i) {
+        atom_t* r = apply_argv(ctx, expr, proc, 1, &items[i]);
+        if (!r)
+            return 0;
+        atom_del(r);
+    }
+    return 1;
+}
+
+
 /*
 --------------------------------------
 apply_op
@@ -85,7 +216,7 @@ apply_op
     Apply a standard operator to arguments.
 --------------------------------------
 */
-atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
+atom_t* apply_op(alisp_ctx* ctx, atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
 
     operator_t* oper = proc->val.oper;
     char optype = oper->type;
@@ -93,17 +224,32 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
     // -------------------------------------
     // print, println
     if (optype == PRINT || optype == PRINTLN) {
-        char* s;
+        atom_t* a;
         for (int i = 0; i < argc; ++i) {
-            if (argv[i]->type != SYMBOL || argv[i]->val.sym[0] != '"')
-                s = atom_tostr(argv[i]);
-            else
-                s = strip_quotes(argv[i]->val.sym);
-            printf("%s", s);
-            safe_free(s);
+            a = argv[i];
+            if (a->type == STRING) {
+                out_write(str_data(a), str_len(a));  // without the quotes
+            } else if (a->type == NUMBER) {
+                out_num(*a->val.num);
+            } else {
+                char* s = atom_tostr(a);
+                out_str(s);
+                safe_free(s);
+            }
         }
         if (optype == PRINTLN)
-            putchar('\n');
+            out_char('\n');
+        return &nilobj;
+
+    // -------------------------------------
+    // flush            (flush)
+    } else if (optype == FLUSH) {
+        if (argc != 0) {
+            errmsg("Syntax", "too many arguments: (flush)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        out_flush();
         return &nilobj;
     
     // -------------------------------------
@@ -118,13 +264,19 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Syntax", "too many arguments", NULL, NULL);
             list_print(expr, 0);
             return NULL;
-        } else if (argv[0]->type != NUMBER) {
+        } else if (argv[0]->type != NUMBER && (!f64_is(argv[0]) || optype == MATH1_M)) {
             errmsg("Semantic", "wrong type of argument", NULL, NULL);
             list_print(expr, 0);
             return NULL;
+        } else if (optype == MATH1_M && (argv[0]->flags & F_FROZEN)) {
+            errmsg("Semantic", "value is frozen", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
         }
 
-        if (optype == MATH1) {
+        if (f64_is(argv[0])) {
+            return f64_math1(argv[0], oper->val.math1);  // broadcast
+        } else if (optype == MATH1) {
             return num(oper->val.math1(*argv[0]->val.num));
         } else {
             *argv[0]->val.num = oper->val.math1(*argv[0]->val.num);
@@ -138,12 +290,19 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Syntax", "wrong number of arguments", NULL, NULL);
             list_print(expr, 0);
             return NULL;
-        } else if (argv[0]->type != NUMBER || argv[1]->type != NUMBER) {
+        } else if ((argv[0]->type != NUMBER && !f64_is(argv[0])) ||
+                   (argv[1]->type != NUMBER && !f64_is(argv[1]))) {
             errmsg("Semantic", "wrong type of argument", NULL, NULL);
             list_print(expr, 0);
             return NULL;
         }
 
+        if (f64_is(argv[0]) || f64_is(argv[1])) {
+            atom_t* v = f64_math2(argv[0], argv[1], oper->val.math2);  // broadcast
+            if (!v)
+                list_print(expr, 0);
+            return v;
+        }
         return num(oper->val.math2(*argv[0]->val.num, *argv[1]->val.num));
 
     // -------------------------------------
@@ -155,14 +314,32 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             return NULL;
         }
 
-        int i;
+        int i, arrays = 0;
         for (i = 0; i < argc; ++i)
-            if (argv[i]->type != NUMBER) {
+            if (f64_is(argv[i]))
+                arrays = 1;
+            else if (argv[i]->type != NUMBER) {
                 errmsg("Semantic", "wrong type of argument", NULL, NULL);
                 list_print(expr, 0);
                 return NULL;
             }
-        
+
+        // Arrays: broadcast, reducing the same way
+        if (arrays) {
+            atom_t* zero = num(0);
+            atom_t* v = argc == 1 ? f64_math2(zero, argv[0], oper->val.math2) : argv[0];
+            for (i = 1; v && i < argc; ++i) {
+                atom_t* r = f64_math2(v, argv[i], oper->val.math2);
+                if (v != argv[0])
+                    atom_del(v);
+                v = r;
+            }
+            atom_del(zero);
+            if (!v)
+                list_print(expr, 0);
+            return v;
+        }
+
         // One argument: treat as (0, arg)
         if (argc == 1)
             return num(oper->val.math2(0, *argv[0]->val.num));
@@ -180,8 +357,8 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Syntax", "wrong number of arguments", NULL, NULL);
             list_print(expr, 0);
             return NULL;
-        } else if ((argv[0]->type != NUMBER || argv[1]->type != NUMBER) &&
-                   (argv[0]->type != SYMBOL || argv[1]->type != SYMBOL)) {
+        } else if (argv[0]->type != argv[1]->type || (argv[0]->type != NUMBER &&
+                   argv[0]->type != STRING && argv[0]->type != SYMBOL)) {
             errmsg("Semantic", "wrong type of argument", NULL, NULL);
             list_print(expr, 0);
             return NULL;
@@ -189,6 +366,8 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
 
         if (argv[0]->type == NUMBER)
             return num(oper->val.rel(NUMBER, argv[0]->val.num, argv[1]->val.num));
+        else if (argv[0]->type == STRING)
+            return num(oper->val.rel(STRING, argv[0], argv[1]));
         else
             return num(oper->val.rel(SYMBOL, argv[0]->val.sym, argv[1]->val.sym));
 
@@ -210,10 +389,21 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             list_print(expr, 0);
             return NULL;
         }
-        char* s = add_quotes(atom_type(argv[0]));
-        atom_t* v = sym(s);
-        safe_free(s);
-        return v;
+        char* s = atom_type(argv[0]);
+        return str_new(s, strlen(s));
+
+    // -------------------------------------
+    // freeze           (freeze object)
+    } else if (optype == FREEZE) {
+        if (argc != 1) {
+            errmsg("Syntax", "wrong number of arguments: (freeze object)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (!atom_freeze(argv[0])) {
+            list_print(expr, 0);
+            return NULL;
+        }
+        return argv[0];
 
     // -------------------------------------
     // list             (list [items...])
@@ -232,13 +422,13 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
                 NULL, NULL);
             list_print(expr, 0);
             return NULL;
-        } else if (argv[0]->type != LIST) {
+        } else if (argv[0]->type != LIST && argv[0]->type != RANGE) {
             errmsg("Semantic", "not a list", NULL, NULL);
             list_print(expr, 0);
             return NULL;
         }
         atom_t* obj = argv[0];
-        int llen = list_len(obj);
+        int llen = obj->type == RANGE ? range_len(obj) : list_len(obj);
         // Return single item
         if (argc == 2) {  
             // Evaluate index
@@ -255,6 +445,8 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
                 list_print(expr, 0);
                 return NULL;
             }
+            if (obj->type == RANGE)
+                return num(range_item(obj, idx));
             return obj->val.list->items[idx];
         }
         // Return list, that is sublist in range [index, index2)
@@ -280,11 +472,10 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             (int)(*index2->val.num);
         if (idx2 > llen)
             idx2 = llen;
-        // Assemble new list
-        atom_t* v = list();
-        for (int i = idx; i < idx2; ++i)
-            list_add(v, obj->val.list->items[i]);
-        return v;
+        if (obj->type == RANGE)
+            return range_slice(obj, idx, idx2);
+        // Share the items until either list is changed
+        return list_slice(obj, idx, idx2);
 
     // -------------------------------------
     // list_set         (list_set list index item)
@@ -297,6 +488,10 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Semantic", "not a list", NULL, NULL);
             list_print(expr, 0);
             return NULL;
+        } else if (argv[0]->flags & F_FROZEN) {
+            errmsg("Semantic", "list is frozen", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
         }
         atom_t* obj = argv[0];
         atom_t* index = argv[1];
@@ -324,12 +519,15 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Syntax", "wrong number of arguments: (list_len list)", NULL, NULL);
             list_print(expr, 0);
             return NULL;
-        } else if (argv[0]->type != LIST) {
+        } else if (argv[0]->type != LIST && !seq_is(argv[0])) {
             errmsg("Semantic", "not a list", NULL, NULL);
             list_print(expr, 0);
             return NULL;
+        } else if (argv[0]->type == LIST) {
+            return num(list_len(argv[0]));
         }
-        return num(list_len(argv[0]));
+        int n;
+        return seq_len(ctx, expr, argv[0], &n) ? num(n) : NULL;
 
     // -------------------------------------
     // list_add         (list_add list item [...])
@@ -342,6 +540,10 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Semantic", "not a list", NULL, NULL);
             list_print(expr, 0);
             return NULL;
+        } else if (argv[0]->flags & F_FROZEN) {
+            errmsg("Semantic", "list is frozen", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
         }
         for (int i = 1; i < argc; ++i)
             list_add(argv[0], argv[i]);
@@ -358,6 +560,10 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Semantic", "not a list", NULL, NULL);
             list_print(expr, 0);
             return NULL;
+        } else if (argv[0]->flags & F_FROZEN) {
+            errmsg("Semantic", "list is frozen", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
         }
         int llen = list_len(argv[0]);
         // Evaluate index
@@ -386,6 +592,10 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             errmsg("Semantic", "not a list", NULL, NULL);
             list_print(expr, 0);
             return NULL;
+        } else if (argv[0]->flags & F_FROZEN) {
+            errmsg("Semantic", "list is frozen", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
         }
         int llen = list_len(argv[0]);
         // Evaluate index
@@ -414,19 +624,980 @@ atom_t* apply_op(atom_t* expr, atom_t* proc, int argc, atom_t** argv) {
             list_print(expr, 0);
             return NULL;
         }
-        int i, j;
+        int i;
         for (i = 0; i < argc; ++i)
             if (argv[i]->type != LIST) {
                 errmsg("Semantic", "not a list", NULL, NULL);
                 list_print(expr, 0);
                 return NULL;
             }
-        // Merge
+        // Merge into a list of the total size
+        int n = 0;
+        for (i = 0; i < argc; ++i)
+            n += list_len(argv[i]);
         atom_t* v = list();
+        list_reserve(v, n);
         for (i = 0; i < argc; ++i)
-            for (j = 0; j < list_len(argv[i]); ++j)
-                list_add(v, argv[i]->val.list->items[j]);
+            list_append(v, argv[i]->val.list->items, list_len(argv[i]));
+        return v;
+
+    // -------------------------------------
+    // vec              (vec [items...])
+    // vec_from         (vec_from list)
+    } else if (optype == VEC_NEW || optype == VEC_FROM) {
+        if (optype == VEC_FROM && (argc != 1 || argv[0]->type != LIST)) {
+            errmsg(argc != 1 ? "Syntax" : "Semantic", argc != 1 ?
+                "wrong number of arguments: (vec_from list)" : "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        atom_t* v = optype == VEC_NEW ? vec_new(argv, argc) : vec_from(argv[0]);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // vec_get          (vec_get vec index [index2])
+    // vec_set          (vec_set vec index item)
+    } else if (optype == VEC_GET || optype == VEC_SET) {
+        if (optype == VEC_GET ? argc < 2 || argc > 3 : argc != 3) {
+            errmsg("Syntax", optype == VEC_GET ?
+                "wrong number of arguments: (vec_get vec index [index2])" :
+                "wrong number of arguments: (vec_set vec index item)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != VECTOR) {
+            errmsg("Semantic", "not a vector", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[1]->type != NUMBER || (optype == VEC_GET && argc == 3 &&
+                   argv[2]->type != NUMBER)) {
+            errmsg("Semantic", "index is not a number", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        int len = vec_len(argv[0]);
+        int idx = (int)*argv[1]->val.num < 0 ? len + (int)(*argv[1]->val.num) :
+            (int)(*argv[1]->val.num);
+        // Slice in range [index, index2)
+        if (optype == VEC_GET && argc == 3) {
+            int idx2 = (int)*argv[2]->val.num < 0 ? len + (int)(*argv[2]->val.num) :
+                (int)(*argv[2]->val.num);
+            return vec_slice(argv[0], idx < 0 ? 0 : idx, idx2 > len ? len : idx2);
+        }
+        if (idx < 0 || idx >= len) {
+            errmsg("Semantic", "index is out of range", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        if (optype == VEC_GET)
+            return vec_get(argv[0], idx);
+        atom_t* v = vec_set(argv[0], idx, argv[2]);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // vec_len          (vec_len vec)
+    // vec_list         (vec_list vec)
+    } else if (optype == VEC_LEN || optype == VEC_LIST) {
+        if (argc != 1) {
+            errmsg("Syntax", optype == VEC_LEN ? "wrong number of arguments: (vec_len vec)" :
+                "wrong number of arguments: (vec_list vec)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != VECTOR) {
+            errmsg("Semantic", "not a vector", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return optype == VEC_LEN ? num(vec_len(argv[0])) : vec_list(argv[0]);
+
+    // -------------------------------------
+    // vec_add          (vec_add vec item [...])
+    } else if (optype == VEC_ADD) {
+        if (argc < 2) {
+            errmsg("Syntax", "too few arguments: (vec_add vec item [...])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != VECTOR) {
+            errmsg("Semantic", "not a vector", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        atom_t* v = vec_add(argv[0], argv + 1, argc - 1);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // vec_merge        (vec_merge vec1 vec2 [...])
+    } else if (optype == VEC_MERGE) {
+        if (argc < 2) {
+            errmsg("Syntax", "too few arguments: (vec_merge vec1 vec2 [...])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 0; i < argc; ++i)
+            if (argv[i]->type != VECTOR) {
+                errmsg("Semantic", "not a vector", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        return vec_merge(argv, argc);
+
+    // -------------------------------------
+    // hashmap          (hashmap [key value ...])
+    } else if (optype == HM_NEW) {
+        if (argc % 2) {
+            errmsg("Syntax", "wrong number of arguments: (hashmap [key value ...])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 0; i < argc; i += 2)
+            if (!hm_iskey(argv[i])) {
+                errmsg("Semantic", "key is not a number or a string", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        atom_t* m = hm_new(argc / 2);
+        for (int i = 0; i < argc; i += 2)
+            hm_set(m, argv[i], argv[i + 1]);
+        return m;
+
+    // -------------------------------------
+    // hm_get           (hm_get map key [default])
+    // hm_set           (hm_set map key value)
+    // hm_has           (hm_has map key)
+    // hm_del           (hm_del map key)
+    } else if (optype == HM_GET || optype == HM_SET || optype == HM_HAS || optype == HM_DEL) {
+        if (optype == HM_GET ? argc < 2 || argc > 3 : argc != (optype == HM_SET ? 3 : 2)) {
+            errmsg("Syntax", optype == HM_GET ? "wrong number of arguments: (hm_get map key [default])" :
+                optype == HM_SET ? "wrong number of arguments: (hm_set map key value)" :
+                optype == HM_HAS ? "wrong number of arguments: (hm_has map key)" :
+                "wrong number of arguments: (hm_del map key)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != HASHMAP) {
+            errmsg("Semantic", "not a hash map", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (!hm_iskey(argv[1])) {
+            errmsg("Semantic", "key is not a number or a string", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if ((optype == HM_SET || optype == HM_DEL) && (argv[0]->flags & F_FROZEN)) {
+            errmsg("Semantic", "hash map is frozen", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        if (optype == HM_SET) {
+            hm_set(argv[0], argv[1], argv[2]);
+            return argv[2];
+        } else if (optype == HM_DEL) {
+            hm_remove(argv[0], argv[1]);
+            return argv[0];
+        }
+        atom_t* v = hm_get(argv[0], argv[1]);
+        if (optype == HM_HAS)
+            return num(v != NULL);
+        return v ? v : argc == 3 ? argv[2] : &nilobj;
+
+    // -------------------------------------
+    // hm_keys          (hm_keys map)
+    // hm_len           (hm_len map)
+    } else if (optype == HM_KEYS || optype == HM_LEN) {
+        if (argc != 1) {
+            errmsg("Syntax", optype == HM_KEYS ? "wrong number of arguments: (hm_keys map)" :
+                "wrong number of arguments: (hm_len map)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != HASHMAP) {
+            errmsg("Semantic", "not a hash map", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return optype == HM_KEYS ? hm_keys(argv[0]) : num(hm_len(argv[0]));
+
+    // -------------------------------------
+    // set              (set [items...])
+    // set_from         (set_from list)
+    } else if (optype == SET_NEW || optype == SET_FROM) {
+        if (optype == SET_FROM && (argc != 1 || argv[0]->type != LIST)) {
+            errmsg(argc != 1 ? "Syntax" : "Semantic", argc != 1 ?
+                "wrong number of arguments: (set_from list)" : "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        atom_t** items = optype == SET_NEW ? argv : argv[0]->val.list->items;
+        int n = optype == SET_NEW ? argc : list_len(argv[0]);
+        for (int i = 0; i < n; ++i)
+            if (!hm_iskey(items[i])) {
+                errmsg("Semantic", "set items must be numbers or strings", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        atom_t* v = set_new(n);
+        for (int i = 0; i < n; ++i)
+            set_add(v, items[i]);
+        return v;
+
+    // -------------------------------------
+    // set_add          (set_add set item [...])
+    // set_rem          (set_rem set item [...])
+    // set_has          (set_has set item)
+    } else if (optype == SET_ADD || optype == SET_REM || optype == SET_HAS) {
+        if (optype == SET_HAS ? argc != 2 : argc < 2) {
+            errmsg("Syntax", optype == SET_ADD ? "too few arguments: (set_add set item [...])" :
+                optype == SET_REM ? "too few arguments: (set_rem set item [...])" :
+                "wrong number of arguments: (set_has set item)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != SET) {
+            errmsg("Semantic", "not a set", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (optype != SET_HAS && (argv[0]->flags & F_FROZEN)) {
+            errmsg("Semantic", "set is frozen", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 1; i < argc; ++i)
+            if (!hm_iskey(argv[i])) {
+                errmsg("Semantic", "set items must be numbers or strings", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        if (optype == SET_HAS)
+            return num(set_has(argv[0], argv[1]));
+        for (int i = 1; i < argc; ++i)
+            if (optype == SET_ADD)
+                set_add(argv[0], argv[i]);
+            else
+                hm_remove(argv[0], argv[i]);
+        return argv[0];
+
+    // -------------------------------------
+    // union            (union set1 set2 [...])
+    // intersect        (intersect set1 set2 [...])
+    // difference       (difference set1 set2 [...])
+    } else if (optype == SET_UNION || optype == SET_INTERSECT || optype == SET_DIFFERENCE) {
+        if (argc < 2) {
+            errmsg("Syntax", optype == SET_UNION ? "too few arguments: (union set1 set2 [...])" :
+                optype == SET_INTERSECT ? "too few arguments: (intersect set1 set2 [...])" :
+                "too few arguments: (difference set1 set2 [...])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 0; i < argc; ++i)
+            if (argv[i]->type != SET) {
+                errmsg("Semantic", "not a set", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        atom_t* v = argv[0];
+        for (int i = 1; i < argc; ++i) {
+            atom_t* r = optype == SET_UNION ? set_union(v, argv[i]) :
+                optype == SET_INTERSECT ? set_intersect(v, argv[i]) : set_difference(v, argv[i]);
+            if (v != argv[0])
+                atom_del(v);
+            v = r;
+        }
         return v;
+
+    // -------------------------------------
+    // set_len          (set_len set)
+    // set_list         (set_list set)
+    } else if (optype == SET_LEN || optype == SET_LIST) {
+        if (argc != 1) {
+            errmsg("Syntax", optype == SET_LEN ? "wrong number of arguments: (set_len set)" :
+                "wrong number of arguments: (set_list set)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != SET) {
+            errmsg("Semantic", "not a set", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return optype == SET_LEN ? num(hm_len(argv[0])) : hm_keys(argv[0]);
+
+    // -------------------------------------
+    // pq_new           (pq_new [procedure])
+    } else if (optype == PQ_NEW) {
+        if (argc > 1) {
+            errmsg("Syntax", "wrong number of arguments: (pq_new [procedure])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argc == 1 && argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return pq_new(argc ? argv[0] : NULL);
+
+    // -------------------------------------
+    // pq_push          (pq_push queue item priority), (pq_push queue item)
+    } else if (optype == PQ_PUSH) {
+        if (argc < 2 || argc > 3) {
+            errmsg("Syntax", "wrong number of arguments: (pq_push queue item [priority])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != PQUEUE) {
+            errmsg("Semantic", "not a priority queue", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (pq_proc(argv[0]) ? argc != 2 : argc != 3) {
+            errmsg("Semantic", pq_proc(argv[0]) ? "queue is ordered by procedure, not priorities" :
+                "priority is missing", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argc == 3 && argv[2]->type != NUMBER) {
+            errmsg("Semantic", "priority is not a number", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        if (!pq_push(ctx, expr, argv[0], argv[1], argc == 3 ? *argv[2]->val.num : 0))
+            return NULL;
+        return argv[0];
+
+    // -------------------------------------
+    // pq_pop           (pq_pop queue)
+    // pq_peek          (pq_peek queue)
+    // pq_len           (pq_len queue)
+    } else if (optype == PQ_POP || optype == PQ_PEEK || optype == PQ_LEN) {
+        if (argc != 1) {
+            errmsg("Syntax", optype == PQ_POP ? "wrong number of arguments: (pq_pop queue)" :
+                optype == PQ_PEEK ? "wrong number of arguments: (pq_peek queue)" :
+                "wrong number of arguments: (pq_len queue)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != PQUEUE) {
+            errmsg("Semantic", "not a priority queue", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (optype == PQ_LEN) {
+            return num(pq_len(argv[0]));
+        } else if (pq_len(argv[0]) == 0) {
+            errmsg("Semantic", "queue is empty", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return optype == PQ_POP ? pq_pop(ctx, expr, argv[0]) : pq_peek(argv[0]);
+
+    // -------------------------------------
+    // range            (range stop), (range start stop [step])
+    } else if (optype == RANGE_NEW) {
+        if (argc < 1 || argc > 3) {
+            errmsg("Syntax", "wrong number of arguments: (range [start] stop [step])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 0; i < argc; ++i)
+            if (argv[i]->type != NUMBER) {
+                errmsg("Semantic", "wrong type of argument", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        atom_t* v = argc == 1 ? range_new(0, *argv[0]->val.num, 1) :
+            range_new(*argv[0]->val.num, *argv[1]->val.num, argc == 3 ? *argv[2]->val.num : 1);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // generator        (generator procedure init)
+    } else if (optype == GEN_NEW) {
+        if (argc != 2) {
+            errmsg("Syntax", "wrong number of arguments: (generator procedure init)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return gen_new(argv[0], argv[1]);
+
+    // -------------------------------------
+    // to_list          (to_list sequence)
+    } else if (optype == TO_LIST) {
+        if (argc != 1) {
+            errmsg("Syntax", "wrong number of arguments: (to_list sequence)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type == LIST) {
+            return argv[0];
+        } else if (!seq_is(argv[0])) {
+            errmsg("Semantic", "not a sequence", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return seq_list(ctx, expr, argv[0]);
+
+    // -------------------------------------
+    // concat           (concat string [...])
+    } else if (optype == STR_CONCAT) {
+        for (int i = 0; i < argc; ++i)
+            if (argv[i]->type != STRING) {
+                errmsg("Semantic", "not a string", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        atom_t* v = str_concat(argv, argc);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // substr           (substr string index [index2])
+    // str_len          (str_len string)
+    } else if (optype == STR_SUB || optype == STR_LEN) {
+        if (optype == STR_SUB ? argc < 2 || argc > 3 : argc != 1) {
+            errmsg("Syntax", optype == STR_SUB ?
+                "wrong number of arguments: (substr string index [index2])" :
+                "wrong number of arguments: (str_len string)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != STRING) {
+            errmsg("Semantic", "not a string", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (optype == STR_LEN) {
+            return num(str_len(argv[0]));
+        }
+        for (int i = 1; i < argc; ++i)
+            if (argv[i]->type != NUMBER) {
+                errmsg("Semantic", "index is not a number", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        // Substring in range [index, index2), or to the end
+        int len = str_len(argv[0]);
+        int idx = (int)*argv[1]->val.num;
+        int idx2 = argc == 3 ? (int)*argv[2]->val.num : len;
+        return str_sub(argv[0], idx < 0 ? len + idx : idx, idx2 < 0 ? len + idx2 : idx2);
+
+    // -------------------------------------
+    // split            (split string separator)
+    // find             (find string substring [index])
+    } else if (optype == STR_SPLIT || optype == STR_FIND) {
+        if (optype == STR_SPLIT ? argc != 2 : argc < 2 || argc > 3) {
+            errmsg("Syntax", optype == STR_SPLIT ?
+                "wrong number of arguments: (split string separator)" :
+                "wrong number of arguments: (find string substring [index])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != STRING || argv[1]->type != STRING) {
+            errmsg("Semantic", "not a string", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argc == 3 && argv[2]->type != NUMBER) {
+            errmsg("Semantic", "index is not a number", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (optype == STR_FIND) {
+            int idx = argc == 3 ? (int)*argv[2]->val.num : 0;
+            return num(str_find(argv[0], argv[1], idx < 0 ? str_len(argv[0]) + idx : idx));
+        }
+        atom_t* v = str_split(argv[0], argv[1]);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // join             (join list [separator])
+    } else if (optype == STR_JOIN) {
+        if (argc < 1 || argc > 2) {
+            errmsg("Syntax", "wrong number of arguments: (join list [separator])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != LIST) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argc == 2 && argv[1]->type != STRING) {
+            errmsg("Semantic", "not a string", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        atom_t* sep = argc == 2 ? argv[1] : str_new("", 0);
+        atom_t* v = str_join(argv[0], sep);
+        if (argc == 1)
+            atom_del(sep);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // sb_new           (sb_new)
+    } else if (optype == SB_NEW) {
+        if (argc != 0) {
+            errmsg("Syntax", "too many arguments: (sb_new)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return sb_new();
+
+    // -------------------------------------
+    // sb_add           (sb_add builder item [...])
+    } else if (optype == SB_ADD) {
+        if (argc < 2) {
+            errmsg("Syntax", "too few arguments: (sb_add builder item [...])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != BUILDER) {
+            errmsg("Semantic", "not a string builder", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 1; i < argc; ++i)
+            if (!sb_add(argv[0], argv[i])) {
+                list_print(expr, 0);
+                return NULL;
+            }
+        return argv[0];
+
+    // -------------------------------------
+    // sb_str           (sb_str builder)
+    // sb_len           (sb_len builder)
+    } else if (optype == SB_STR || optype == SB_LEN) {
+        if (argc != 1) {
+            errmsg("Syntax", optype == SB_STR ? "wrong number of arguments: (sb_str builder)" :
+                "wrong number of arguments: (sb_len builder)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != BUILDER) {
+            errmsg("Semantic", "not a string builder", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return optype == SB_STR ? sb_str(argv[0]) : num(sb_len(argv[0]));
+
+    // -------------------------------------
+    // f64array         (f64array list)
+    // f64_list         (f64_list array)
+    // f64_len          (f64_len array)
+    } else if (optype == F64_NEW || optype == F64_LIST || optype == F64_LEN) {
+        if (argc != 1) {
+            errmsg("Syntax", optype == F64_NEW ? "wrong number of arguments: (f64array list)" :
+                optype == F64_LIST ? "wrong number of arguments: (f64_list array)" :
+                "wrong number of arguments: (f64_len array)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (optype == F64_NEW ? argv[0]->type != LIST && argv[0]->type != RANGE :
+                   argv[0]->type != F64ARRAY) {
+            errmsg("Semantic", optype == F64_NEW ? "not a list or a range" : "not an array", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        if (optype == F64_LIST)
+            return f64_list(argv[0]);
+        else if (optype == F64_LEN)
+            return num(f64_len(argv[0]));
+        atom_t* v = f64_from(argv[0]);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // f64_range        (f64_range start stop [step])
+    } else if (optype == F64_RANGE) {
+        if (argc < 2 || argc > 3) {
+            errmsg("Syntax", "wrong number of arguments: (f64_range start stop [step])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 0; i < argc; ++i)
+            if (argv[i]->type != NUMBER) {
+                errmsg("Semantic", "wrong type of argument", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        atom_t* v = f64_range(*argv[0]->val.num, *argv[1]->val.num,
+                              argc == 3 ? *argv[2]->val.num : 1);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // f64_get          (f64_get array index)
+    } else if (optype == F64_GET) {
+        if (argc != 2) {
+            errmsg("Syntax", "wrong number of arguments: (f64_get array index)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != F64ARRAY) {
+            errmsg("Semantic", "not an array", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[1]->type != NUMBER) {
+            errmsg("Semantic", "index is not a number", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        int len = f64_len(argv[0]);
+        int idx = (int)*argv[1]->val.num < 0 ? len + (int)(*argv[1]->val.num) :
+            (int)(*argv[1]->val.num);
+        if (idx < 0 || idx >= len) {
+            errmsg("Semantic", "index is out of range", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return num(f64_data(argv[0])[idx]);
+
+    // -------------------------------------
+    // sum              (sum array), (sum matrix)
+    // dot              (dot array1 array2)
+    } else if (optype == F64_SUM || optype == F64_DOT) {
+        if (argc != (optype == F64_SUM ? 1 : 2)) {
+            errmsg("Syntax", optype == F64_SUM ? "wrong number of arguments: (sum array)" :
+                "wrong number of arguments: (dot array1 array2)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        for (int i = 0; i < argc; ++i)
+            if (optype == F64_SUM ? !f64_is(argv[i]) : argv[i]->type != F64ARRAY) {
+                errmsg("Semantic", "not an array", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        if (optype == F64_SUM)
+            return num(f64_sum(argv[0]));
+        else if (f64_len(argv[0]) != f64_len(argv[1])) {
+            errmsg("Semantic", "arrays differ in length", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return num(f64_dot(argv[0], argv[1]));
+
+    // -------------------------------------
+    // min              (min array), (min matrix), (min x [...])
+    // max              (max array), (max matrix), (max x [...])
+    } else if (optype == F64_MIN || optype == F64_MAX) {
+        if (argc == 0) {
+            errmsg("Syntax", "no arguments", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argc == 1 && f64_is(argv[0])) {
+            if (!f64_len(argv[0])) {
+                errmsg("Semantic", "array is empty", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+            return num(optype == F64_MIN ? f64_min(argv[0]) : f64_max(argv[0]));
+        }
+        for (int i = 0; i < argc; ++i)
+            if (argv[i]->type != NUMBER) {
+                errmsg("Semantic", "wrong type of argument", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        double res = *argv[0]->val.num;
+        for (int i = 1; i < argc; ++i) {
+            double x = *argv[i]->val.num;
+            res = optype == F64_MIN ? (x < res ? x : res) : (x > res ? x : res);
+        }
+        return num(res);
+
+    // -------------------------------------
+    // matrix           (matrix rows cols [items]), (matrix list_of_rows)
+    } else if (optype == MAT_NEW) {
+        if (argc == 1 && argv[0]->type == LIST) {
+            atom_t* v = mat_from(argv[0]);
+            if (!v)
+                list_print(expr, 0);
+            return v;
+        } else if (argc < 2 || argc > 3) {
+            errmsg("Syntax", "wrong number of arguments: (matrix rows cols [items])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != NUMBER || argv[1]->type != NUMBER ||
+                   (argc == 3 && argv[2]->type != LIST && argv[2]->type != F64ARRAY)) {
+            errmsg("Semantic", "wrong type of argument", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        double rows = *argv[0]->val.num, cols = *argv[1]->val.num;
+        if (!(rows >= 0 && cols >= 0 && rows * cols <= F64_MAX_LEN)) {
+            errmsg("Semantic", "matrix is too large", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        atom_t* v = mat_new((int)rows, (int)cols);
+        if (argc == 3) {
+            atom_t* items = argv[2]->type == LIST ? f64_from(argv[2]) : argv[2];
+            if (items && f64_len(items) != f64_len(v))
+                errmsg("Semantic", "number of items differs from matrix size", NULL, NULL);
+            else if (items)
+                memcpy(f64_data(v), f64_data(items), f64_len(v) * sizeof(double));
+            if (!items || f64_len(items) != f64_len(v)) {
+                atom_del(v);
+                v = NULL;
+                list_print(expr, 0);
+            }
+            if (items && items != argv[2])
+                atom_del(items);
+        }
+        return v;
+
+    // -------------------------------------
+    // mat_get          (mat_get matrix row col)
+    } else if (optype == MAT_GET) {
+        if (argc != 3) {
+            errmsg("Syntax", "wrong number of arguments: (mat_get matrix row col)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != MATRIX) {
+            errmsg("Semantic", "not a matrix", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[1]->type != NUMBER || argv[2]->type != NUMBER) {
+            errmsg("Semantic", "index is not a number", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        int row = (int)*argv[1]->val.num, col = (int)*argv[2]->val.num;
+        if (row < 0 || row >= mat_rows(argv[0]) || col < 0 || col >= mat_cols(argv[0])) {
+            errmsg("Semantic", "index is out of range", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return num(f64_data(argv[0])[row * mat_cols(argv[0]) + col]);
+
+    // -------------------------------------
+    // mat_rows         (mat_rows matrix)
+    // mat_cols         (mat_cols matrix)
+    // mat_list         (mat_list matrix)
+    // transpose        (transpose matrix)
+    } else if (optype == MAT_ROWS || optype == MAT_COLS || optype == MAT_LIST ||
+               optype == MAT_TRANSPOSE) {
+        if (argc != 1) {
+            errmsg("Syntax", optype == MAT_ROWS ? "wrong number of arguments: (mat_rows matrix)" :
+                optype == MAT_COLS ? "wrong number of arguments: (mat_cols matrix)" :
+                optype == MAT_LIST ? "wrong number of arguments: (mat_list matrix)" :
+                "wrong number of arguments: (transpose matrix)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != MATRIX) {
+            errmsg("Semantic", "not a matrix", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return optype == MAT_ROWS ? num(mat_rows(argv[0])) :
+            optype == MAT_COLS ? num(mat_cols(argv[0])) :
+            optype == MAT_LIST ? mat_list(argv[0]) : mat_transpose(argv[0]);
+
+    // -------------------------------------
+    // matmul           (matmul matrix matrix_or_array)
+    // solve            (solve matrix matrix_or_array)
+    } else if (optype == MAT_MUL || optype == MAT_SOLVE) {
+        if (argc != 2) {
+            errmsg("Syntax", optype == MAT_MUL ? "wrong number of arguments: (matmul a b)" :
+                "wrong number of arguments: (solve a b)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != MATRIX || !f64_is(argv[1])) {
+            errmsg("Semantic", "wrong type of argument", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        atom_t* v = optype == MAT_MUL ? mat_mul(argv[0], argv[1]) : mat_solve(argv[0], argv[1]);
+        if (!v)
+            list_print(expr, 0);
+        return v;
+
+    // -------------------------------------
+    // map              (map procedure list)
+    // filter           (filter procedure list)
+    // foreach          (foreach procedure list)
+    } else if (optype == MAP || optype == FILTER || optype == FOREACH) {
+        if (argc != 2) {
+            errmsg("Syntax", optype == MAP ? "wrong number of arguments: (map procedure list)" :
+                optype == FILTER ? "wrong number of arguments: (filter procedure list)" :
+                "wrong number of arguments: (foreach procedure list)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[1]->type != LIST && !seq_is(argv[1])) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (seq_is(argv[1])) {
+            if (optype == FOREACH)
+                return seq_foreach(ctx, expr, argv[0], argv[1]) ? &nilobj : NULL;
+            return seq_map(ctx, expr, argv[0], argv[1], optype == FILTER);
+        }
+        atom_t** items = argv[1]->val.list->items;
+        int n = list_len(argv[1]);
+        if (optype == MAP)
+            return map_items(ctx, expr, argv[0], items, n);
+        else if (optype == FILTER)
+            return filter_items(ctx, expr, argv[0], items, n);
+        return foreach_items(ctx, expr, argv[0], items, n) ? &nilobj : NULL;
+
+    // -------------------------------------
+    // reduce           (reduce procedure list)
+    } else if (optype == REDUCE) {
+        if (argc != 2) {
+            errmsg("Syntax", "wrong number of arguments: (reduce procedure list)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (seq_is(argv[1])) {
+            return seq_fold(ctx, expr, argv[0], NULL, argv[1]);
+        } else if (argv[1]->type != LIST) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (list_len(argv[1]) == 0) {
+            errmsg("Semantic", "list is empty", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        atom_t** items = argv[1]->val.list->items;
+        return fold_items(ctx, expr, argv[0], items[0], items + 1, list_len(argv[1]) - 1);
+
+    // -------------------------------------
+    // fold             (fold procedure init list)
+    } else if (optype == FOLD) {
+        if (argc != 3) {
+            errmsg("Syntax", "wrong number of arguments: (fold procedure init list)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (seq_is(argv[2])) {
+            return seq_fold(ctx, expr, argv[0], argv[1], argv[2]);
+        } else if (argv[2]->type != LIST) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return fold_items(ctx, expr, argv[0], argv[1], argv[2]->val.list->items,
+            list_len(argv[2]));
+
+    // -------------------------------------
+    // pmap             (pmap procedure list)
+    } else if (optype == PMAP) {
+        if (argc != 2) {
+            errmsg("Syntax", "wrong number of arguments: (pmap procedure list)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[1]->type != LIST) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return task_map(ctx, expr, argv[0], argv[1]);
+
+    // -------------------------------------
+    // preduce          (preduce procedure init list)
+    } else if (optype == PREDUCE) {
+        if (argc != 3) {
+            errmsg("Syntax", "wrong number of arguments: (preduce procedure init list)",
+                NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[2]->type != LIST) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return task_reduce(ctx, expr, argv[0], argv[1], argv[2]);
+
+    // -------------------------------------
+    // sort             (sort list [procedure])
+    // stable_sort      (stable_sort list [procedure])
+    } else if (optype == SORT || optype == STABLE_SORT) {
+        if (argc < 1 || argc > 2) {
+            errmsg("Syntax", optype == SORT ? "wrong number of arguments: (sort list [procedure])" :
+                "wrong number of arguments: (stable_sort list [procedure])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != LIST) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argc == 2 && argv[1]->type != FUNCTION && argv[1]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return sort_items(ctx, expr, argc == 2 ? argv[1] : NULL, argv[0]->val.list->items,
+            list_len(argv[0]), optype == STABLE_SORT);
+
+    // -------------------------------------
+    // bsearch          (bsearch list item [procedure])
+    // lower_bound      (lower_bound list item [procedure])
+    } else if (optype == BSEARCH || optype == LOWER_BOUND) {
+        if (argc < 2 || argc > 3) {
+            errmsg("Syntax", optype == BSEARCH ? "wrong number of arguments: (bsearch list item [procedure])" :
+                "wrong number of arguments: (lower_bound list item [procedure])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != LIST) {
+            errmsg("Semantic", "not a list", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argc == 3 && argv[2]->type != FUNCTION && argv[2]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        int idx;
+        if (!search_items(ctx, expr, argc == 3 ? argv[2] : NULL, argv[0]->val.list->items,
+                          list_len(argv[0]), argv[1], optype == BSEARCH, &idx))
+            return NULL;
+        return num(idx);
+
+    // -------------------------------------
+    // spawn            (spawn procedure [args...])
+    } else if (optype == SPAWN) {
+        if (argc < 1) {
+            errmsg("Syntax", "too few arguments: (spawn procedure [args...])", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUNCTION && argv[0]->type != STD_OP) {
+            errmsg("Semantic", "object is not callable", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return task_spawn(ctx, expr, argc, argv);
+
+    // -------------------------------------
+    // await            (await future)
+    } else if (optype == AWAIT) {
+        if (argc != 1) {
+            errmsg("Syntax", "wrong number of arguments: (await future)", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        } else if (argv[0]->type != FUTURE) {
+            errmsg("Semantic", "not a future", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+        return task_await(ctx, expr, argv[0]);
+
+    // -------------------------------------
+    // builtin of the embedding program
+    } else if (optype == NATIVE) {
+        return oper->val.native.fn(ctx, argc, argv, oper->val.native.data);
     }
 
     printf("\x1b[95m" "Fatal error: apply_op: unknown operator!\n" "\x1b[0m");
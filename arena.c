@@ -0,0 +1,105 @@
+/*
+Arena: bump allocator for objects that share a lifetime.
+Memory is taken from a chain of chunks and given back all at once by arena_reset or
+arena_del.  Individual allocations are never freed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alisp.h"
+
+/* Make a chunk with at least size bytes of free space. */
+static arena_chunk_t* chunk_new(size_t size, arena_chunk_t* next) {
+    arena_chunk_t* c = malloc(sizeof(arena_chunk_t) + size);
+    if (!c) {
+        printf("\x1b[95m" "Fatal error: arena: out of memory!\n" "\x1b[0m");
+        exit(EXIT_FAILURE);
+    }
+    c->next = next;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+/*
+--------------------------------------
+arena_new
+
+    Make an arena. First chunk holds at least size bytes.
+--------------------------------------
+*/
+arena_t* arena_new(size_t size) {
+    arena_t* a = malloc(sizeof(arena_t));
+    a->head = chunk_new(size < ARENA_CHUNK ? ARENA_CHUNK : size, NULL);
+    return a;
+}
+
+/*
+--------------------------------------
+arena_alloc
+
+    Allocate size bytes from the arena.
+--------------------------------------
+*/
+void* arena_alloc(arena_t* a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    arena_chunk_t* c = a->head;
+    if (c->used + size > c->size) {
+        // Grow geometrically, so large parses take few chunks
+        size_t n = c->size * 2;
+        while (n < size)
+            n *= 2;
+        c = a->head = chunk_new(n, c);
+    }
+    void* p = c->mem + c->used;
+    c->used += size;
+    return p;
+}
+
+/* Copy a string into the arena. */
+char* arena_strdup(arena_t* a, const char* s, size_t len) {
+    char* p = arena_alloc(a, len + 1);
+    memcpy(p, s, len);
+    p[len] = '\0';
+    return p;
+}
+
+/*
+--------------------------------------
+arena_reset
+
+    Release everything allocated from the arena. Keeps the newest chunk for reuse.
+--------------------------------------
+*/
+void arena_reset(arena_t* a) {
+    arena_chunk_t *c = a->head->next, *tmp;
+    while (c) {
+        tmp = c->next;
+        free(c);
+        c = tmp;
+    }
+    a->head->next = NULL;
+    a->head->used = 0;
+}
+
+/* Take over all memory of another arena, which is deallocated. */
+void arena_adopt(arena_t* a, arena_t* other) {
+    if (!other)
+        return;
+    arena_chunk_t* c = other->head;
+    while (c->next)
+        c = c->next;
+    c->next = a->head->next;    // keep a's current chunk in front for allocation
+    a->head->next = other->head;
+    free(other);
+}
+
+/* Deallocate an arena. */
+void arena_del(arena_t* a) {
+    if (!a)
+        return;
+    arena_reset(a);
+    free(a->head);
+    free(a);
+}
@@ -5,9 +5,15 @@ Atomic object: basic Alisp data type.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "alisp.h"
 
-atom_t nilobj = {{}, NIL, 1};
+atom_t nilobj = {{}, NIL, F_STATIC, 1};
+
+/* Frozen objects are never deallocated, their roots are kept here */
+static atom_t**        frozen = NULL;
+static size_t          frozen_len = 0, frozen_max = 0;
+static pthread_mutex_t frozen_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /*
 --------------------------------------
@@ -21,6 +27,7 @@ atom_t* num(double x) {
     obj->val.num = malloc(sizeof(double));
     *obj->val.num = x;
     obj->type = NUMBER;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -37,6 +44,7 @@ atom_t* sym(const char* s) {
     obj->val.sym = malloc(strlen(s) + 1);
     strcpy(obj->val.sym, s);
     obj->type = SYMBOL;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -66,6 +74,7 @@ atom_t* func(atom_t* params, atom_t* body, atom_t* env) {
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.func = function;
     obj->type = FUNCTION;
+    obj->flags = 0;
     obj->bindings = 0;
 
     // Bind members
@@ -73,13 +82,21 @@ atom_t* func(atom_t* params, atom_t* body, atom_t* env) {
     atom_bind(function->body, obj);
     
     // Bind enclosing environments
-    for (atom_t* e = env; e && e != global_env; e = e->val.dict->parent)
+    for (atom_t* e = env; e && e != ctx_cur->global_env; e = e->val.dict->parent)
         atom_bind(e, obj);
 
     return obj;
 
 }
 
+/* Is an environment in use by the evaluation going on? */
+static int env_active(atom_t* env) {
+    for (atom_t* e = ctx_cur->active_env; e; e = e->val.dict->parent)
+        if (e == env)
+            return 1;
+    return 0;
+}
+
 /*
 --------------------------------------
 func_del
@@ -103,10 +120,11 @@ safe_free(dbg_s);
     atom_t *env, *tmp;
     f->lock = 1;  // lock current object
 
-    // Deallocate enclosing environments
-    for (env = f->env; env && env != global_env;) {
+    // Deallocate enclosing environments, except those being evaluated in: their
+    // callers deallocate them
+    for (env = f->env; env && env != ctx_cur->global_env;) {
         atom_unbind(env, obj);
-        if (!env->val.dict->lock) {
+        if (!env->val.dict->lock && !env_active(env)) {
             tmp = env;
             env = env->val.dict->parent;
             atom_del(tmp);
@@ -136,8 +154,8 @@ void atom_del(atom_t* a) {
     assert_arg(a, "atom_del");
     
     // Check if object is good for deletion
-    if ((a->type == NIL) || (atom_is_container(a) && a->val.list->lock) ||
-        (a->bindings && (!atom_is_container(a) || atom_bound_in(a, active_env))))
+    if ((a->type == NIL) || (a->flags & F_UNCOUNTED) || (atom_is_container(a) && a->val.list->lock) ||
+        (a->bindings && (!atom_is_container(a) || atom_bound_in(a, ctx_cur->active_env))))
         return;
 
 #ifdef DEBUG
@@ -157,6 +175,46 @@ char* dbg_s = atom_tostr(a);
     case FUNCTION:
         func_del(a);
         break;
+
+    case FUTURE:
+        future_release(a->val.fut);
+        safe_free(a);
+        break;
+
+    case VECTOR:
+        vec_release(a->val.vec);
+        safe_free(a);
+        break;
+
+    case HASHMAP:
+    case SET:
+        hm_del(a);
+        break;
+
+    case PQUEUE:
+        pq_del(a);
+        break;
+
+    case F64ARRAY:
+    case MATRIX:
+        f64_del(a);
+        break;
+
+    case RANGE:
+        range_del(a);
+        break;
+
+    case GENERATOR:
+        gen_del(a);
+        break;
+
+    case STRING:
+        str_del(a);
+        break;
+
+    case BUILDER:
+        sb_del(a);
+        break;
     
     default:
         safe_free(a->val.num);
@@ -222,6 +280,66 @@ char* atom_tostring(atom_t* obj, int depth) {
         strcpy(tmp, "<Operator>");
         break;
 
+    case FUTURE:
+        sprintf(tmp, "<Future at 0x%lx>", (size_t)obj);
+        break;
+
+    case VECTOR:
+        if (depth)
+            return vec_tostr(obj, depth);
+        else
+            strcpy(tmp, "[...]");
+        break;
+
+    case HASHMAP:
+        if (depth)
+            return hm_tostr(obj, depth);
+        else
+            strcpy(tmp, "{...}");
+        break;
+
+    case SET:
+        if (depth)
+            return hm_tostr(obj, depth);
+        else
+            strcpy(tmp, "#{...}");
+        break;
+
+    case PQUEUE:
+        if (depth)
+            return pq_tostr(obj, depth);
+        else
+            strcpy(tmp, "pq{...}");
+        break;
+
+    case F64ARRAY:
+        if (depth)
+            return f64_tostr(obj);
+        else
+            strcpy(tmp, "f64[...]");
+        break;
+
+    case MATRIX:
+        if (depth)
+            return mat_tostr(obj);
+        else
+            strcpy(tmp, "mat[...]");
+        break;
+
+    case RANGE:
+        return range_tostr(obj);
+
+    case GENERATOR:
+        sprintf(tmp, "<Generator at 0x%lx>", (size_t)obj);
+        break;
+
+    case STRING:
+        return str_tostr(obj);
+
+    case BUILDER:
+        sprintf(tmp, "<String builder at 0x%lx>", (size_t)obj);
+        break;
+
     default:
         sprintf(tmp, "<Object at 0x%lx>", (size_t)obj);
         break;
@@ -232,25 +350,17 @@ char* atom_tostring(atom_t* obj, int depth) {
     return s;
 }
 
-/*
---------------------------------------
-atom_copy
-
-    Return a deep copy of an object.
---------------------------------------
-*/
-atom_t* atom_copy(atom_t* obj) {
-    assert_arg(obj, "atom_copy");
-    atom_t* objects = list();
-    atom_t* copies = list();
-    atom_t* copy = atom_cp(obj, objects, copies);
-    list_free(objects);
-    list_free(copies);
-    return copy;
-}
-
-/* Recursively copy object. */
-atom_t* atom_cp(atom_t* obj, atom_t* objects, atom_t* copies) {
+/* Copier state */
+typedef struct {
+    ptrmap_t* copies;   // container -> its copy
+    atom_t**  stack;    // pairs of containers and their copies waiting for contents
+    size_t    len;
+    size_t    max;
+} copier_t;
+
+/* Copy an object. Containers are copied empty and queued to be filled. */
+static atom_t* atom_cp(copier_t* c, atom_t* obj) {
+    atom_t* copy;
     switch(obj->type) {
 
     case NIL:
@@ -262,16 +372,57 @@ atom_t* atom_cp(atom_t* obj, atom_t* objects, atom_t* copies) {
     case SYMBOL:
         return sym(obj->val.sym);
 
-    case LIST:
-        return list_cp(obj, objects, copies);
+    case SET:
+        return set_copy(obj);
 
+    case F64ARRAY:
+    case MATRIX:
+        return f64_copy(obj);
+
+    case RANGE:
+        return range_copy(obj);
+
+    case STRING:
+        return str_copy(obj);
+
+    case BUILDER:
+        return sb_copy(obj);
+
+    case LIST:
     case DICTIONARY:
-        return dict_cp(obj, objects, copies);
+    case HASHMAP:
+    case PQUEUE:
+    case GENERATOR:
+        if ((copy = ptrmap_get(c->copies, obj)))
+            return copy;  // object already has a copy
+        if (obj->type == LIST) {
+            copy = list();
+            list_reserve(copy, list_len(obj));
+        } else if (obj->type == HASHMAP)
+            copy = hm_new(hm_len(obj));
+        else if (obj->type == PQUEUE)
+            copy = pq_new(NULL);
+        else if (obj->type == GENERATOR)
+            copy = gen_new(NULL, NULL);
+        else
+            copy = dict(obj->val.dict->maxlen, obj->val.dict->parent);
+        ptrmap_put(c->copies, obj, copy);
+        if (c->len + 2 > c->max) {
+            c->max *= 2;
+            c->stack = realloc(c->stack, c->max * sizeof(atom_t*));
+        }
+        c->stack[c->len++] = obj;
+        c->stack[c->len++] = copy;
+        return copy;
     
     case FUNCTION:
         return func(obj->val.func->params, obj->val.func->body, obj->val.func->env);
 
+    case VECTOR:
+        return vec_share(obj);  // vectors never change, the copy can share
+
     case STD_OP:
+    case FUTURE:
         errmsg("Semantic", "copying protected object", NULL, NULL);
         return NULL;
 
@@ -281,6 +432,65 @@ atom_t* atom_cp(atom_t* obj, atom_t* objects, atom_t* copies) {
     }
 }
 
+/*
+--------------------------------------
+atom_copy
+
+    Return a deep copy of an object, or NULL if it has something that can't be
+    copied.  Shared structure and cycles are preserved.  Containers are filled from
+    an explicit stack, so deep nesting doesn't exhaust the C stack.
+--------------------------------------
+*/
+atom_t* atom_copy(atom_t* obj) {
+    assert_arg(obj, "atom_copy");
+    copier_t c = {ptrmap_new(64), malloc(64 * sizeof(atom_t*)), 0, 64};
+    atom_t* copy = atom_cp(&c, obj);
+    int ok = copy != NULL;
+
+    while (ok && c.len) {
+        atom_t* dst = c.stack[--c.len];
+        atom_t* src = c.stack[--c.len];
+        atom_t* v;
+        if (src->type == LIST) {
+            for (int i = 0; ok && i < src->val.list->len; ++i)
+                if ((ok = (v = atom_cp(&c, src->val.list->items[i])) != NULL))
+                    list_add(dst, v);
+        } else if (src->type == HASHMAP) {
+            hashmap_t* m = src->val.hm;
+            for (int i = 0; ok && i < m->len; ++i)
+                if ((ok = (v = atom_cp(&c, m->vals[i])) != NULL))
+                    hm_set(dst, m->keys[i], v);
+        } else if (src->type == PQUEUE) {
+            pqueue_t* q = src->val.pq;
+            if (q->proc && (ok = (v = atom_cp(&c, q->proc)) != NULL)) {
+                dst->val.pq->proc = v;
+                atom_bind(v, dst);
+            }
+            for (int i = 0; ok && i < q->len; ++i)
+                if ((ok = (v = atom_cp(&c, q->items[i])) != NULL))
+                    pq_append(dst, v, q->prios[i]);
+        } else if (src->type == GENERATOR) {
+            if ((ok = (v = atom_cp(&c, gen_proc(src))) != NULL))
+                gen_set(dst, v, NULL);
+            if (ok && (ok = (v = atom_cp(&c, gen_init(src))) != NULL))
+                gen_set(dst, NULL, v);
+        } else {
+            dict_t* d = src->val.dict;
+            for (int i = 0; ok && i < d->len; ++i)
+                if ((ok = (v = atom_cp(&c, d->vals[i])) != NULL))
+                    dict_add(dst, d->keys[i], v);
+        }
+    }
+
+    if (!ok && copy) {
+        atom_del(copy);  // partial copy, everything made is reachable from it
+        copy = NULL;
+    }
+    ptrmap_del(c.copies);
+    safe_free(c.stack);
+    return copy;
+}
+
 
 /*
 --------------------------------------
@@ -299,6 +509,17 @@ char* atom_type(atom_t* obj) {
     case  4: return "DICTIONARY";
     case  5: return "FUNCTION";
     case  6: return "STD_OP";
+    case  7: return "FUTURE";
+    case  8: return "VECTOR";
+    case  9: return "HASHMAP";
+    case 10: return "SET";
+    case 11: return "F64ARRAY";
+    case 12: return "MATRIX";
+    case 13: return "PQUEUE";
+    case 14: return "RANGE";
+    case 15: return "GENERATOR";
+    case 16: return "STRING";
+    case 17: return "BUILDER";
     default: return "UNRECOGNIZED";
     }
 }
@@ -311,6 +532,8 @@ atom_bind
 --------------------------------------
 */
 void atom_bind(atom_t* obj, atom_t* container) {
+    if (obj->flags & F_UNCOUNTED)
+        return;  // parse tree node, static or shared object, not counted
     ++obj->bindings;
     if (atom_is_container(obj)) {
         if (!obj->val.list->bindlist)
@@ -327,6 +550,8 @@ atom_unbind
 --------------------------------------
 */
 void atom_unbind(atom_t* obj, atom_t* container) {
+    if (obj->flags & F_UNCOUNTED)
+        return;
     --obj->bindings;
     if (atom_is_container(obj) && obj->val.list->bindlist) {
         int idx = list_idx(obj->val.list->bindlist, container);
@@ -340,64 +565,197 @@ void atom_unbind(atom_t* obj, atom_t* container) {
 
 /*
 --------------------------------------
-atom_bound_in
+atom_share
 
-    Search if an object is reachable via a chain of enclosed environments.
+    Mark an object and everything reachable from it as shared, or clear the mark.
+    Shared objects are never bound, unbound or deallocated, so using them doesn't
+    write to their memory and forked processes keep sharing their pages.
 --------------------------------------
 */
-int atom_bound_in(atom_t* obj, atom_t* env) {
-    if (!obj || !atom_is_container(obj)) {
-        printf("\x1b[95m" "Fatal error: bound_in: bad object!\n" "\x1b[0m");
-        exit(EXIT_FAILURE);
-    } else if (!env || env->type != DICTIONARY) {
-        printf("\x1b[95m" "Fatal error: bound_in: bad environment!\n" "\x1b[0m");
-        exit(EXIT_FAILURE);
+void atom_share(atom_t* obj, int on) {
+    size_t len = 0, max = 256;
+    atom_t** stack = malloc(max * sizeof(atom_t*));
+    stack[len++] = obj;
+
+    while (len) {
+        atom_t* a = stack[--len];
+        if (on ? a->flags & F_UNCOUNTED : !(a->flags & F_SHARED))
+            continue;  // already done, or not counted anyway
+        a->flags ^= F_SHARED;
+
+        // Push members: items, values and parent of a dictionary, parts of a function
+        atom_t** items = NULL;
+        int n = 0;
+        if (a->type == LIST) {
+            items = a->val.list->items;
+            n = a->val.list->len;
+        } else if (a->type == DICTIONARY) {
+            items = a->val.dict->vals;
+            n = a->val.dict->len;
+        } else if (a->type == HASHMAP) {
+            items = a->val.hm->vals;
+            n = a->val.hm->len;
+        } else if (a->type == PQUEUE) {
+            items = a->val.pq->items;
+            n = a->val.pq->len;
+        }
+        if (len + n + 3 > max) {
+            while (len + n + 3 > max)
+                max *= 2;
+            stack = realloc(stack, max * sizeof(atom_t*));
+        }
+        for (int i = 0; i < n; ++i)
+            stack[len++] = items[i];
+        if (a->type == DICTIONARY && a->val.dict->parent)
+            stack[len++] = a->val.dict->parent;
+        if (a->type == PQUEUE && a->val.pq->proc)
+            stack[len++] = a->val.pq->proc;
+        if (a->type == GENERATOR) {
+            stack[len++] = a->val.gen->proc;
+            stack[len++] = a->val.gen->init;
+        }
+        if (a->type == FUNCTION) {
+            stack[len++] = a->val.func->params;
+            stack[len++] = a->val.func->body;
+            stack[len++] = a->val.func->env;
+        }
     }
-    
-    atom_t* owners = list();
-    atom_get_owners_r(obj, owners);
-    int bound = 0;
-    atom_t* e;
-    
-    for (int i = 0; !bound && i < owners->val.list->len; ++i)
-        for (e = env; e; e = e->val.dict->parent)
-            if (owners->val.list->items[i] == e) {
-                bound = 1;
-                break;
+    safe_free(stack);
+}
+
+/*
+--------------------------------------
+atom_freeze
+
+    Make an object and everything reachable from it immutable.  Only data can be
+    frozen: numbers, strings, symbols, lists, vectors, hash maps, sets, arrays,
+    matrices, ranges and dictionaries that are not environments.
+    Frozen objects are never bound, unbound or deallocated, so they can be read by
+    any number of contexts and threads at once.  Return 0 if something can't be
+    frozen, then nothing is.
+--------------------------------------
+*/
+int atom_freeze(atom_t* obj) {
+    size_t len = 0, max = 256;
+    atom_t** stack = malloc(max * sizeof(atom_t*));
+    ptrmap_t* seen = ptrmap_new(256);
+    const char* err = NULL;
+    stack[len++] = obj;
+
+    // Collect everything reachable, checking that it is data
+    while (len && !err) {
+        atom_t* a = stack[--len];
+        if (a->type == NIL || (a->flags & (F_FROZEN | F_STATIC)) || ptrmap_get(seen, a))
+            continue;
+        ptrmap_put(seen, a, a);
+
+        atom_t** items = NULL;
+        int n = 0;
+        if (a->type == LIST) {
+            items = a->val.list->items;
+            n = a->val.list->len;
+        } else if (a->type == DICTIONARY) {
+            if (a->val.dict->parent)
+                err = "environments can't be frozen";
+            items = a->val.dict->vals;
+            n = a->val.dict->len;
+        } else if (a->type == HASHMAP) {
+            items = a->val.hm->vals;
+            n = a->val.hm->len;
+        } else if (a->type != NUMBER && a->type != SYMBOL && a->type != VECTOR &&
+                   a->type != SET && a->type != RANGE && a->type != STRING && !f64_is(a))
+            err = "only data can be frozen";
+
+        if (len + n > max) {
+            while (len + n > max)
+                max *= 2;
+            stack = realloc(stack, max * sizeof(atom_t*));
+        }
+        for (int i = 0; i < n; ++i)
+            stack[len++] = items[i];
+    }
+
+    // Mark, bindings of frozen containers are not tracked any more
+    if (!err && seen->len) {
+        for (size_t i = 0; i < seen->max; ++i) {
+            atom_t* a = (atom_t*)seen->keys[i];
+            if (a && a->type == LIST)
+                list_own(a);  // no items shared with slices
+        }
+        for (size_t i = 0; i < seen->max; ++i) {
+            atom_t* a = (atom_t*)seen->keys[i];
+            if (!a)
+                continue;
+            a->flags |= F_FROZEN;
+            if (atom_is_container(a)) {
+                list_free(a->val.list->bindlist);
+                a->val.list->bindlist = NULL;
             }
-    
-    list_free(owners);
-    return bound;
+        }
+        pthread_mutex_lock(&frozen_lock);
+        if (frozen_len == frozen_max) {
+            frozen_max = frozen_max ? frozen_max * 2 : 64;
+            frozen = realloc(frozen, frozen_max * sizeof(atom_t*));
+        }
+        frozen[frozen_len++] = obj;
+        pthread_mutex_unlock(&frozen_lock);
+    } else if (err)
+        errmsg("Semantic", err, NULL, NULL);
+
+    ptrmap_del(seen);
+    safe_free(stack);
+    return !err;
 }
 
 /*
 --------------------------------------
-atom_get_owners_r
+atom_bound_in
 
-    Create a list of all objects through which a given object can be reached.
+    Search if an object is reachable via a chain of enclosed environments.  An object
+    unreachable but not on a cycle of its owners counts as bound too: the owners still
+    refer to it and release it when they are deallocated themselves.
 --------------------------------------
 */
-void atom_get_owners_r(atom_t* obj, atom_t* ownlist) {
-    if (!(obj && atom_is_container(obj))) {
-        printf("\x1b[95m" "Fatal error: get_owners: bad object!\n" "\x1b[0m");
+int atom_bound_in(atom_t* obj, atom_t* env) {
+    if (!obj || !atom_is_container(obj)) {
+        printf("\x1b[95m" "Fatal error: bound_in: bad object!\n" "\x1b[0m");
         exit(EXIT_FAILURE);
-    } else if (!(ownlist && ownlist->type == LIST)) {
-        printf("\x1b[95m" "Fatal error: get_owners: bad list!\n" "\x1b[0m");
+    } else if (!env || env->type != DICTIONARY) {
+        printf("\x1b[95m" "Fatal error: bound_in: bad environment!\n" "\x1b[0m");
         exit(EXIT_FAILURE);
     }
 
-    if (!obj->val.list->bindlist)
-        return;
-    list_t* bl = obj->val.list->bindlist->val.list;
-    atom_t* item;
-
-    for (int i = 0; i < bl->len; ++i) {
-        item = bl->items[i];
-        if (list_idx(ownlist, item) == -1) {
-            list_add_h(ownlist, item);   // add item itself
-            atom_get_owners_r(item, ownlist);  // add item owners
+    // Walk the owners, and their owners, from the bind lists
+    size_t len = 0, max = 16;
+    atom_t** stack = malloc(max * sizeof(atom_t*));
+    ptrmap_t* seen = ptrmap_new(8);
+    int bound = 0, cycle = 0;
+    stack[len++] = obj;
+
+    while (len && !bound) {
+        atom_t* a = stack[--len];
+        atom_t* bl = a->val.list->bindlist;
+        if (!bl)
+            continue;
+        for (int i = 0; i < bl->val.list->len; ++i) {
+            atom_t* o = bl->val.list->items[i];
+            if (ptrmap_get(seen, o))
+                continue;
+            ptrmap_put(seen, o, o);
+            cycle |= o == obj;
+            for (atom_t* e = env; e; e = e->val.dict->parent)
+                bound |= o == e;
+            if (len == max) {
+                max *= 2;
+                stack = realloc(stack, max * sizeof(atom_t*));
+            }
+            stack[len++] = o;
         }
     }
+
+    ptrmap_del(seen);
+    safe_free(stack);
+    return bound || !cycle;
 }
 
 /*
@@ -408,7 +766,30 @@ atom_is_container
 --------------------------------------
 */
 int atom_is_container(atom_t* obj) {
-    return obj->type == LIST || obj->type == DICTIONARY || obj->type == FUNCTION;
+    return obj->type == LIST || obj->type == DICTIONARY || obj->type == FUNCTION ||
+           obj->type == HASHMAP || obj->type == PQUEUE || obj->type == GENERATOR;
+}
+
+/*
+--------------------------------------
+atom_true
+
+    Check if an object counts as true: anything but NIL, zero, empty strings and
+    empty collections.
+--------------------------------------
+*/
+int atom_true(atom_t* obj) {
+    return !(obj->type == NIL ||
+             (obj->type == NUMBER && *obj->val.num == 0) ||
+             (obj->type == SYMBOL && strlen(obj->val.sym) == 0) ||
+             (obj->type == STRING && str_len(obj) == 0) ||
+             (obj->type == BUILDER && sb_len(obj) == 0) ||
+             (obj->type == LIST && list_len(obj) == 0) ||
+             (obj->type == VECTOR && vec_len(obj) == 0) ||
+             ((obj->type == HASHMAP || obj->type == SET) && hm_len(obj) == 0) ||
+             (obj->type == PQUEUE && pq_len(obj) == 0) ||
+             (obj->type == RANGE && range_len(obj) == 0) ||
+             (f64_is(obj) && f64_len(obj) == 0));
 }
 
 /*
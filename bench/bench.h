@@ -0,0 +1,47 @@
+/*
+Harness of the benchmarks: a clock, evaluation that stops the benchmark on error and
+timing of expressions, on a context of the embedding library.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libalisp.h"
+
+/* Current time in seconds. */
+static inline double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Evaluate source text, exit on error. */
+static inline alisp_value* run(alisp_ctx* ctx, const char* src) {
+    alisp_value* v = alisp_eval(ctx, src);
+    if (!v) {
+        alisp_flush(ctx);
+        fprintf(stderr, "evaluation failed: %s\n", src);
+        exit(EXIT_FAILURE);
+    }
+    return v;
+}
+
+/* Evaluate an expression reps times. Return the time of one evaluation. */
+static inline double bench_time(alisp_ctx* ctx, const char* src, int reps) {
+    double t = now();
+    for (int i = 0; i < reps; ++i)
+        alisp_release(ctx, run(ctx, src));
+    return (now() - t) / reps;
+}
+
+/* Time an expression evaluated reps times, per item of n. */
+static inline void bench(alisp_ctx* ctx, const char* name, const char* src, int n, int reps) {
+    double t = bench_time(ctx, src, reps);
+    printf("%-28s %9.3f ms  %8.2f ns/item\n", name, t * 1e3, t * 1e9 / n);
+}
+
+#endif
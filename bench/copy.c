@@ -0,0 +1,56 @@
+/*
+Deep copy benchmark.
+Time of (copy x) for a nested list of 10^5 nodes, built wide (1000 lists of 100
+numbers) and deep (every list holding the previous one and a number).
+
+    $ make bench/copy && bench/copy [repeats]
+*/
+
+#include "bench.h"
+
+/* Make a source text of (list 0 1 ... n-1). */
+static char* iota(int n) {
+    char* s = malloc(16 + n * 8);
+    int len = sprintf(s, "(list");
+    for (int i = 0; i < n; ++i)
+        len += sprintf(s + len, " %d", i);
+    strcpy(s + len, ")");
+    return s;
+}
+
+/* Time copies of a global variable. */
+static void bench_copy(alisp_ctx* ctx, const char* name, int repeats) {
+    char src[64];
+    sprintf(src, "(copy %s)", name);
+    double t = bench_time(ctx, src, repeats);
+    printf("%-6s %8.2f ms/copy  %6.1f ns/node\n", name, t * 1e3, t * 1e9 / 1e5);
+}
+
+int main(int argc, char* argv[]) {
+    int repeats = argc > 1 ? atoi(argv[1]) : 10;
+    alisp_ctx* ctx = alisp_new();
+
+    char* s = iota(100);
+    char* src = malloc(strlen(s) + 64);
+    sprintf(src, "(def row %s)", s);
+    run(ctx, src);
+    free(src);
+    free(s);
+
+    s = iota(1000);
+    src = malloc(strlen(s) + 64);
+    sprintf(src, "(def idx %s)", s);
+    run(ctx, src);
+    free(src);
+    free(s);
+
+    run(ctx, "(def wide (map (func (i) (copy row)) idx))");
+    run(ctx, "(def deep (fold (func (acc i) (list acc i)) (list) "
+             "(reduce list_merge (map (func (i) (copy idx)) (list_get row 0 50)))))");
+    run(ctx, "(list_len deep)");
+
+    bench_copy(ctx, "wide", repeats);
+    bench_copy(ctx, "deep", repeats);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+/*
+Embedding benchmark.
+Per-call latency of evaluating through libalisp in-process against spawning a new
+./alisp process for every evaluation.
+
+    $ make bench/embed && bench/embed [calls]
+*/
+
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "bench.h"
+
+extern char** environ;
+
+/* Builtin: (native_add a b) */
+static alisp_value* native_add(alisp_ctx* ctx, int argc, alisp_value** argv, void* data) {
+    if (argc != 2 || alisp_type(argv[0]) != ALISP_NUMBER || alisp_type(argv[1]) != ALISP_NUMBER) {
+        alisp_error(ctx, "native_add expects two numbers");
+        return NULL;
+    }
+    ++*(long*)data;
+    return alisp_number(alisp_tonumber(argv[0]) + alisp_tonumber(argv[1]));
+}
+
+static const char* prelude =
+    "(def fact (func (n) (if (< n 2) 1 (* n (fact (- n 1))))))";
+
+int main(int argc, char* argv[]) {
+    int calls = argc > 1 ? atoi(argv[1]) : 100000;
+    int spawns = calls / 100 > 10 ? calls / 100 : 10;
+    double t, sum = 0;
+    long native_calls = 0;
+
+    alisp_ctx* ctx = alisp_new();
+    alisp_eval(ctx, prelude);
+    alisp_register(ctx, "native_add", native_add, &native_calls);
+    alisp_value* fact = alisp_get(ctx, "fact");
+
+    // Parse and evaluate source text
+    t = now();
+    for (int i = 0; i < calls; ++i) {
+        alisp_value* v = alisp_eval(ctx, "(fact 10)");
+        sum += alisp_tonumber(v);
+        alisp_release(ctx, v);
+    }
+    double t_eval = (now() - t) / calls;
+
+    // Call a function with native arguments
+    t = now();
+    for (int i = 0; i < calls; ++i) {
+        alisp_value* args[] = {alisp_number(10)};
+        alisp_value* v = alisp_call(ctx, fact, 1, args);
+        sum += alisp_tonumber(v);
+        alisp_release(ctx, v);
+    }
+    double t_call = (now() - t) / calls;
+
+    // Call a native builtin from Alisp
+    t = now();
+    for (int i = 0; i < calls; ++i) {
+        alisp_value* v = alisp_eval(ctx, "(native_add 1 2)");
+        sum += alisp_tonumber(v);
+        alisp_release(ctx, v);
+    }
+    double t_native = (now() - t) / calls;
+    alisp_free(ctx);
+
+    // Spawn the interpreter for every evaluation
+    char path[] = "/tmp/alisp_embed_XXXXXX";
+    int fd = mkstemp(path);
+    const char* src = "(def fact (func (n) (if (< n 2) 1 (* n (fact (- n 1))))))\n(fact 10)\n";
+    if (fd < 0 || write(fd, src, strlen(src)) != (ssize_t)strlen(src)) {
+        perror("bench/embed");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, 1, "/dev/null", O_WRONLY, 0);
+    char* args[] = {"./alisp", "--no-cache", path, NULL};
+    t = now();
+    for (int i = 0; i < spawns; ++i) {
+        pid_t pid;
+        int status;
+        if (posix_spawn(&pid, args[0], &fa, NULL, args, environ)) {
+            perror("bench/embed: ./alisp");
+            return EXIT_FAILURE;
+        }
+        waitpid(pid, &status, 0);
+    }
+    double t_spawn = (now() - t) / spawns;
+    posix_spawn_file_actions_destroy(&fa);
+    unlink(path);
+
+    printf("alisp_eval  (fact 10)         %10.2f us/call\n", t_eval * 1e6);
+    printf("alisp_call  fact 10           %10.2f us/call\n", t_call * 1e6);
+    printf("alisp_eval  (native_add 1 2)  %10.2f us/call\n", t_native * 1e6);
+    printf("spawn ./alisp (fact 10)       %10.2f us/call  (%.0fx eval)\n",
+           t_spawn * 1e6, t_spawn / t_eval);
+    printf("checksum %g, native calls %ld\n", sum, native_calls);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,37 @@
+/*
+F64 array benchmark.
+Arrays against lists of numbers for elementwise arithmetic and reductions over n
+items.  Array operations are repeated to be measurable; set ALISP_SIMD to scalar,
+sse2 or avx2 to compare the kernels of instruction sets.
+
+    $ make bench/f64 && bench/f64 [n]
+*/
+
+#include "bench.h"
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    alisp_ctx* ctx = alisp_new();
+    char src[128];
+
+    sprintf(src, "(def a (f64_range 0 %d))", n);
+    run(ctx, src);
+    run(ctx, "(def b (+ (sin a) 2))");
+    run(ctx, "(def la (f64_list a))");
+    run(ctx, "(def lb (f64_list b))");
+    run(ctx, "(def add (func (x y) (+ x y)))");
+
+    const char* simd = getenv("ALISP_SIMD");
+    printf("n = %d, kernels: %s\n", n, simd ? simd : "widest");
+    bench(ctx, "scale: array",         "(* a 2)", n, 100);
+    bench(ctx, "scale: list",          "(map (func (x) (* x 2)) la)", n, 1);
+    bench(ctx, "add: arrays",          "(+ a b)", n, 100);
+    bench(ctx, "sqrt: array",          "(sqrt b)", n, 100);
+    bench(ctx, "sqrt: list",           "(map sqrt lb)", n, 1);
+    bench(ctx, "sum: array",           "(sum a)", n, 100);
+    bench(ctx, "sum: list",            "(reduce add la)", n, 1);
+    bench(ctx, "dot: arrays",          "(dot a b)", n, 100);
+    bench(ctx, "max: array",           "(max b)", n, 100);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
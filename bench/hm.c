@@ -0,0 +1,61 @@
+/*
+Hash map benchmark.
+Hash maps against lists of (key value) pairs for grouping and joining: n items counted
+into n/10 groups by key, and n lookups of keys in a table of n/10 entries.  Pairs are
+found by filtering the list.  Sets against lists for removing duplicates from the n
+items, and for intersecting the n/10 distinct keys with every other one of them.
+
+    $ make bench/hm && bench/hm [n]
+*/
+
+#include "bench.h"
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000;
+    int groups = n / 10 > 1 ? n / 10 : 1;
+    alisp_ctx* ctx = alisp_new();
+
+    // (def keys (list k0 k1 ... kn-1)), keys of groups in scrambled order
+    char* src = malloc(32 + n * 12);
+    int len = sprintf(src, "(def keys (list");
+    for (int i = 0; i < n; ++i)
+        len += sprintf(src + len, " %d", (int)((i * 7919L) % groups));
+    strcpy(src + len, "))");
+    run(ctx, src);
+    free(src);
+
+    // Pair of a key in a list of pairs, or NULL
+    run(ctx, "(def pair_find (func (l k) "
+             "(def ps (filter (func (p) (== (list_get p 0) k)) l)) "
+             "(if ps (list_get ps 0) NULL)))");
+    run(ctx, "(def pair_bump (func (l k) (def p (pair_find l k)) "
+             "(if (null? p) (list_add l (list k 1)) (list_set p 1 (+ 1 (list_get p 1)))) l))");
+    run(ctx, "(def hm_bump (func (m k) (hm_set m k (+ 1 (hm_get m k 0))) m))");
+    run(ctx, "(def tm (fold hm_bump (hashmap) keys))");
+    run(ctx, "(def tl (fold pair_bump (list) keys))");
+    run(ctx, "(def has (func (l k) (filter (func (x) (== x k)) l)))");
+    run(ctx, "(def dl (fold (func (acc k) (if (has acc k) acc (list_add acc k))) (list) keys))");
+    run(ctx, "(def el (filter (func (k) (not (% k 2))) dl))");
+    run(ctx, "(def ds (set_from dl))");
+    run(ctx, "(def es (set_from el))");
+
+    printf("n = %d, %d groups\n", n, groups);
+    bench(ctx, "group: hashmap",
+          "(fold hm_bump (hashmap) keys)", n, 1);
+    bench(ctx, "group: list of pairs",
+          "(fold pair_bump (list) keys)", n, 1);
+    bench(ctx, "join: hm_get",
+          "(map (func (k) (hm_get tm k)) keys)", n, 1);
+    bench(ctx, "join: list of pairs",
+          "(map (func (k) (list_get (pair_find tl k) 1)) keys)", n, 1);
+    bench(ctx, "dedup: set_from",
+          "(set_list (set_from keys))", n, 1);
+    bench(ctx, "dedup: list",
+          "(fold (func (acc k) (if (has acc k) acc (list_add acc k))) (list) keys)", n, 1);
+    bench(ctx, "intersect: sets",
+          "(intersect ds es)", groups, 1);
+    bench(ctx, "intersect: lists",
+          "(filter (func (k) (has el k)) dl)", groups, 1);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/*
+Load generator for the evaluation server.
+Sends the same request over a number of connections, one request in flight per
+connection, and reports throughput and latency percentiles.
+
+    $ ./alisp prelude.al --serve /tmp/alisp.sock --workers 4 &
+    $ make bench/loadgen && bench/loadgen /tmp/alisp.sock [-c conns] [-n requests] [-e expr]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+typedef struct {
+    const char* path;
+    const char* expr;
+    int         n;          // requests to send
+    double*     lat;        // latency of every request, seconds
+    int         errors;     // responses with error status
+    int         failed;     // connection failure
+    char*       sample;     // result of the first request
+} client_t;
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int read_all(int fd, void* buf, size_t n) {
+    char* p = buf;
+    while (n) {
+        ssize_t k = read(fd, p, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return 0;
+        p += k;
+        n -= k;
+    }
+    return 1;
+}
+
+static int write_all(int fd, const void* buf, size_t n) {
+    const char* p = buf;
+    while (n) {
+        ssize_t k = write(fd, p, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return 0;
+        p += k;
+        n -= k;
+    }
+    return 1;
+}
+
+/* Read a length-prefixed byte string. */
+static char* read_bytes(int fd) {
+    uint32_t len;
+    if (!read_all(fd, &len, sizeof(len)))
+        return NULL;
+    len = ntohl(len);
+    char* s = malloc(len + 1);
+    if (!read_all(fd, s, len)) {
+        free(s);
+        return NULL;
+    }
+    s[len] = '\0';
+    return s;
+}
+
+static void* client(void* arg) {
+    client_t* c = arg;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, c->path, sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+        perror("loadgen: connect");
+        c->failed = 1;
+        return NULL;
+    }
+
+    size_t len = strlen(c->expr);
+    char* req = malloc(len + 4);
+    uint32_t nlen = htonl((uint32_t)len);
+    memcpy(req, &nlen, 4);
+    memcpy(req + 4, c->expr, len);
+
+    for (int i = 0; i < c->n; ++i) {
+        double t = now();
+        char status;
+        char *out = NULL, *val = NULL;
+        if (!write_all(fd, req, len + 4) || !read_all(fd, &status, 1) ||
+            !(out = read_bytes(fd)) || !(val = read_bytes(fd))) {
+            fprintf(stderr, "loadgen: connection closed by server\n");
+            free(out);
+            c->failed = 1;
+            break;
+        }
+        c->lat[i] = now() - t;
+        c->errors += status != 0;
+        if (!c->sample) {
+            c->sample = malloc(strlen(out) + strlen(val) + 2);
+            sprintf(c->sample, "%s%s", out, val);
+        }
+        free(out);
+        free(val);
+    }
+
+    free(req);
+    close(fd);
+    return NULL;
+}
+
+static int cmp(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = NULL;
+    const char* expr = "(+ 1 2)";
+    int conns = 4, total = 100000;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-c") && i + 1 < argc)
+            conns = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            total = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+            expr = argv[++i];
+        else
+            path = argv[i];
+    }
+    if (!path || conns < 1 || total < conns) {
+        fprintf(stderr, "Usage: loadgen socket [-c connections] [-n requests] [-e expr]\n");
+        return EXIT_FAILURE;
+    }
+
+    int per = total / conns;
+    total = per * conns;
+    double* lat = calloc(total, sizeof(double));
+    client_t* cl = calloc(conns, sizeof(client_t));
+    pthread_t* th = malloc(conns * sizeof(pthread_t));
+
+    double t = now();
+    for (int i = 0; i < conns; ++i) {
+        cl[i] = (client_t){path, expr, per, lat + i * per, 0, 0, NULL};
+        pthread_create(&th[i], NULL, client, &cl[i]);
+    }
+    int errors = 0, failed = 0;
+    for (int i = 0; i < conns; ++i) {
+        pthread_join(th[i], NULL);
+        errors += cl[i].errors;
+        failed |= cl[i].failed;
+    }
+    t = now() - t;
+    if (failed)
+        return EXIT_FAILURE;
+
+    qsort(lat, total, sizeof(double), cmp);
+    printf("result:      %s\n", cl[0].sample ? cl[0].sample : "");
+    printf("requests:    %d over %d connections, %d errors\n", total, conns, errors);
+    printf("throughput:  %.0f req/s\n", total / t);
+    printf("latency:     p50 %.1f us, p99 %.1f us, max %.1f us\n",
+           lat[total / 2] * 1e6, lat[(int)(total * 0.99)] * 1e6, lat[total - 1] * 1e6);
+
+    for (int i = 0; i < conns; ++i)
+        free(cl[i].sample);
+    free(cl);
+    free(th);
+    free(lat);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+/*
+Matrix benchmark.
+Product of two n x n matrices, in GFLOP/s (2 n^3 operations), against the same
+product of nested lists in Alisp, dot products of rows and columns.  Also transpose
+and solving a system of n equations.  The list product is slow, it runs for small n
+only; set ALISP_SIMD to scalar, sse2 or avx2 to compare the kernels of instruction
+sets.
+
+    $ make bench/mat && bench/mat [n ...]
+*/
+
+#include "bench.h"
+
+#define LIST_MAX_N 64   // largest n of the list product
+
+/* Time an expression evaluated reps times, in GFLOP/s of flops per evaluation. */
+static void bench_flops(alisp_ctx* ctx, const char* name, const char* src, double flops,
+                        int reps) {
+    double t = bench_time(ctx, src, reps);
+    if (flops)
+        printf("%-28s %9.3f ms  %9.4f GFLOP/s\n", name, t * 1e3, flops / t * 1e-9);
+    else
+        printf("%-28s %9.3f ms\n", name, t * 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    static int sizes[] = {64, 128, 256, 512};
+    alisp_ctx* ctx = alisp_new();
+    char src[256];
+
+    run(ctx, "(def a 0)");
+    run(ctx, "(def b 0)");
+    run(ctx, "(def v 0)");
+    run(ctx, "(def la 0)");
+    run(ctx, "(def lbt 0)");
+    run(ctx, "(def dot_l (func (r c) (fold (func (acc i) (+ acc (* (list_get r i) "
+             "(list_get c i)))) 0 (f64_list (f64_range 0 (list_len r))))))");
+    run(ctx, "(def matmul_l (func (x yt) (map (func (r) (map (func (c) (dot_l r c)) yt)) x)))");
+
+    const char* simd = getenv("ALISP_SIMD");
+    printf("kernels: %s\n", simd ? simd : "widest");
+    for (int i = 0; i < (argc > 1 ? argc - 1 : 4); ++i) {
+        int n = argc > 1 ? atoi(argv[i + 1]) : sizes[i];
+        double flops = 2.0 * n * n * n;
+        int reps = n <= 128 ? 20 : n <= 256 ? 5 : 1;
+
+        sprintf(src, "(= a (matrix %d %d (sin (f64_range 0 %d))))", n, n, n * n);
+        alisp_release(ctx, run(ctx, src));
+        sprintf(src, "(= b (matrix %d %d (+ (cos (f64_range 0 %d)) 2)))", n, n, n * n);
+        alisp_release(ctx, run(ctx, src));
+        sprintf(src, "(= v (sin (f64_range 1 %d)))", n + 1);
+        alisp_release(ctx, run(ctx, src));
+        printf("n = %d\n", n);
+        bench_flops(ctx, "matmul: matrices", "(matmul a b)", flops, reps);
+        bench_flops(ctx, "matmul: matrix, array", "(matmul a v)", 2.0 * n * n, reps);
+        bench_flops(ctx, "transpose: matrix", "(transpose a)", 0, reps);
+        bench_flops(ctx, "solve: matrix, array", "(solve b v)", 2.0 / 3 * n * n * n, reps);
+        if (n <= LIST_MAX_N) {
+            alisp_release(ctx, run(ctx, "(= la (mat_list a))"));
+            alisp_release(ctx, run(ctx, "(= lbt (mat_list (transpose b)))"));
+            bench_flops(ctx, "matmul: lists", "(matmul_l la lbt)", flops, 1);
+        }
+    }
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+/*
+Priority queue benchmark.
+Priority queues against sorted lists for n pushes followed by n pops of the first
+item.  The sorted list finds the place of an item by binary search (lower_bound) and
+inserts it with list_ins, which moves the items after it.
+
+    $ make bench/pq && bench/pq [n]
+*/
+
+#include "bench.h"
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 20000;
+    alisp_ctx* ctx = alisp_new();
+
+    // (def prios (list p0 p1 ... pn-1)), priorities in scrambled order
+    char* src = malloc(32 + n * 12);
+    int len = sprintf(src, "(def prios (list");
+    for (int i = 0; i < n; ++i)
+        len += sprintf(src + len, " %ld", (i * 7919L) % n);
+    strcpy(src + len, "))");
+    run(ctx, src);
+    free(src);
+
+    run(ctx, "(def drain (func (q) (foreach (func (p) (pq_pop q)) prios) q))");
+    run(ctx, "(def sl_push (func (l p) (list_ins l (lower_bound l p) p)))");
+    run(ctx, "(def sl_pop (func (l) (def x (list_get l 0)) (list_rem l 0) x))");
+    run(ctx, "(def sl_drain (func (l) (foreach (func (p) (sl_pop l)) prios) l))");
+
+    printf("n = %d\n", n);
+    bench(ctx, "pq, priorities",
+          "(drain (fold (func (q p) (pq_push q p p)) (pq_new) prios))", n, 1);
+    bench(ctx, "pq, <",
+          "(drain (fold (func (q p) (pq_push q p)) (pq_new <) prios))", n, 1);
+    bench(ctx, "pq, procedure",
+          "(drain (fold (func (q p) (pq_push q p)) (pq_new (func (a b) (< a b))) prios))", n, 1);
+    bench(ctx, "sorted list, list_ins",
+          "(sl_drain (fold sl_push (list) prios))", n, 1);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
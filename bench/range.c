@@ -0,0 +1,37 @@
+/*
+Lazy sequence benchmark.
+Ranges and generators against lists of the same numbers for folding, mapping and
+filtering n numbers.  The lists are made by f64_list beforehand, so their time is of
+walking the items only; "made and folded" adds making the list every time, which is
+what a range saves along with the memory.
+
+    $ make bench/range && bench/range [n]
+*/
+
+#include "bench.h"
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    alisp_ctx* ctx = alisp_new();
+    char src[256];
+
+    sprintf(src, "(def n %d)", n);
+    run(ctx, src);
+    run(ctx, "(def nums (f64_list (f64_range 0 n)))");
+    run(ctx, "(def r (range n))");
+    run(ctx, "(def g (generator (func (x) (if (< x (- n 1)) (+ x 1) NULL)) 0))");
+    run(ctx, "(def sq (func (x) (* x x)))");
+    run(ctx, "(def odd (func (x) (% x 2)))");
+
+    printf("n = %d\n", n);
+    bench(ctx, "fold, list", "(fold + 0 nums)", n, 1);
+    bench(ctx, "fold, list made and folded", "(fold + 0 (f64_list (f64_range 0 n)))", n, 1);
+    bench(ctx, "fold, range", "(fold + 0 r)", n, 1);
+    bench(ctx, "fold, generator", "(fold + 0 g)", n, 1);
+    bench(ctx, "map, list", "(map sq nums)", n, 1);
+    bench(ctx, "map, range", "(map sq r)", n, 1);
+    bench(ctx, "filter, list", "(filter odd nums)", n, 1);
+    bench(ctx, "filter, range", "(filter odd r)", n, 1);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
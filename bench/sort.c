@@ -0,0 +1,64 @@
+/*
+Sort benchmark.
+Sorting n numbers and strings with the builtins, and the first few hundred numbers
+against an insertion sort written in Alisp over list_get and list_set.  Binary search
+of every number against a linear search, over the first few hundred too.  Default
+order of numbers is a radix sort; passing > sorts them by comparisons.
+
+    $ make bench/sort && bench/sort [n]
+*/
+
+#include "bench.h"
+
+#define SLOW_MAX 300    // items for the sort and search in Alisp
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    int m = n < SLOW_MAX ? n : SLOW_MAX;
+    alisp_ctx* ctx = alisp_new();
+    char buf[64];
+
+    // (def nums (list x0 x1 ... xn-1)) and the same as strings, in scrambled order
+    char* src = malloc(32 + n * 16);
+    int len = sprintf(src, "(def nums (list");
+    for (int i = 0; i < n; ++i)
+        len += sprintf(src + len, " %ld", (i * 7919L) % n - n / 2);
+    strcpy(src + len, "))");
+    run(ctx, src);
+    len = sprintf(src, "(def strs (list");
+    for (int i = 0; i < n; ++i)
+        len += sprintf(src + len, " \"s%ld\"", (i * 7919L) % n);
+    strcpy(src + len, "))");
+    run(ctx, src);
+    free(src);
+
+    // Insertion sort in place: shift greater items right, then put x at j + 1
+    run(ctx, "(def lset (func (l i x) (list_set l i x) l))");
+    run(ctx, "(def shift (func (l x j) "
+             "(if (and (>= j 0) (> (list_get l j) x)) "
+             "(shift (lset l (+ j 1) (list_get l j)) x (- j 1)) (lset l (+ j 1) x))))");
+    run(ctx, "(def isort (func (l i) "
+             "(if (< i (list_len l)) (isort (shift l (list_get l i) (- i 1)) (+ i 1)) l)))");
+    sprintf(buf, "(def few (list_get nums 0 %d))", m);
+    run(ctx, buf);
+    run(ctx, "(def sorted (sort few))");
+    run(ctx, "(def lsearch (func (l x) (list_len (filter (func (y) (< y x)) l))))");
+
+    printf("n = %d\n", n);
+    bench(ctx, "numbers: sort",              "(sort nums)", n, 1);
+    bench(ctx, "numbers: sort >",            "(sort nums >)", n, 1);
+    bench(ctx, "numbers: stable_sort >",     "(stable_sort nums >)", n, 1);
+    bench(ctx, "numbers: sort by func",      "(sort nums (func (a b) (< a b)))", n, 1);
+    bench(ctx, "strings: sort",              "(sort strs)", n, 1);
+    bench(ctx, "strings: stable_sort",       "(stable_sort strs)", n, 1);
+    printf("n = %d\n", m);
+    bench(ctx, "numbers: sort",              "(sort few)", m, 1);
+    bench(ctx, "numbers: sort by func",      "(sort few (func (a b) (< a b)))", m, 1);
+    bench(ctx, "numbers: insertion sort",    "(isort (copy few) 1)", m, 1);
+    bench(ctx, "search: lower_bound",
+          "(map (func (x) (lower_bound sorted x)) few)", m, 1);
+    bench(ctx, "search: linear",
+          "(map (func (x) (lsearch sorted x)) few)", m, 1);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,37 @@
+/*
+String benchmark.
+Building text of n pieces with a string builder against concatenating a string to the
+one before, which copies all the text every time; and searching and splitting text of
+n words with find and split against walking it a byte at a time with substr.  The
+walks are timed on n / 10 pieces, since they are slower by far.
+
+    $ make bench/str && bench/str [n]
+*/
+
+#include "bench.h"
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    alisp_ctx* ctx = alisp_new();
+    char src[256];
+
+    sprintf(src, "(def n %d)", n);
+    run(ctx, src);
+    run(ctx, "(def m (/ n 10))");
+    run(ctx, "(def add (func (b i) (sb_add b \"word\" i \" \")))");
+    run(ctx, "(def text (sb_str (fold add (sb_new) (range n))))");
+    run(ctx, "(def short (sb_str (fold add (sb_new) (range m))))");
+    run(ctx, "(def needle (sb_str (sb_add (sb_new) \"word\" (- n 1))))");
+    run(ctx, "(def cat (func (s i) (concat s \"word\" \" \")))");
+    run(ctx, "(def spaces (func (s) (fold (func (c i) (if (== (substr s i (+ i 1)) \" \") (+ c 1) c)) "
+             "0 (range (str_len s)))))");
+
+    printf("n = %d, %d bytes\n", n, (int)alisp_tonumber(run(ctx, "(str_len text)")));
+    bench(ctx, "build, builder", "(sb_str (fold add (sb_new) (range n)))", n, 1);
+    bench(ctx, "build, concat (n / 10)", "(fold cat \"\" (range m))", n / 10, 1);
+    bench(ctx, "find, last word", "(find text needle)", n, 1);
+    bench(ctx, "split, words", "(split text \" \")", n, 1);
+    bench(ctx, "count spaces, substr (n / 10)", "(spaces short)", n / 10, 1);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
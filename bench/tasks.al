@@ -0,0 +1,36 @@
+# Parallel scaling of tasks: an integral split into 8 independent tasks.
+#
+#   $ time ALISP_THREADS=1 ./alisp bench/tasks.al
+#   $ time ./alisp bench/tasks.al
+
+(def integral (func (f a b dx)
+    (def iter (func (x acc)
+        (if (> x b)
+            acc
+            (iter (+ x dx) (+ acc (f x))))))
+    (* (iter (+ a (/ dx 2)) 0) dx)))
+
+(def f (func (x) (* (sin x) (exp (- 0 (* x x))))))
+
+# part: integral over [k/8, (k+1)/8] in steps of 1/8 divided into n
+(def part (func (k n)
+    (def w (/ 1 8))
+    (def step (func (i acc)
+        (if (== i n)
+            acc
+            (step (+ i 1) (+ acc (integral f (+ (* k w) (/ (* i w) n)) (+ (* k w) (/ (* (+ i 1) w) n)) 0.0001))))))
+    (step 0 0)))
+
+(def fs (list))
+(def start (func (k)
+    (if (< k 8)
+        (list_add fs (spawn part k 10)))
+    (if (< k 8)
+        (start (+ k 1)))))
+(start 0)
+
+(def total (func (k acc)
+    (if (== k 8)
+        acc
+        (total (+ k 1) (+ acc (await (list_get fs k)))))))
+(println "integral: " (total 0 0))
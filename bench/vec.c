@@ -0,0 +1,47 @@
+/*
+Vector benchmark.
+Persistent vectors against lists for keeping every version of a sequence: n appends
+and n updates, each kept as a new version, and n reads.  Lists keep versions by
+copying (list_merge, copy), or give them up (list_add, list_set change in place).
+
+    $ make bench/vec && bench/vec [n]
+*/
+
+#include "bench.h"
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 5000;
+    alisp_ctx* ctx = alisp_new();
+
+    // (def idx (list 0 1 ... n-1))
+    char* src = malloc(32 + n * 8);
+    int len = sprintf(src, "(def idx (list");
+    for (int i = 0; i < n; ++i)
+        len += sprintf(src + len, " %d", i);
+    strcpy(src + len, "))");
+    run(ctx, src);
+    free(src);
+    run(ctx, "(def v (vec_from idx))");
+    run(ctx, "(def l (copy idx))");
+    run(ctx, "(def lset (func (l i x) (list_set l i x) l))");
+
+    printf("n = %d\n", n);
+    bench(ctx, "append: vec_add",
+          "(fold (func (acc i) (vec_add acc i)) (vec) idx)", n, 1);
+    bench(ctx, "append: list_add (in place)",
+          "(fold (func (acc i) (list_add acc i)) (list) idx)", n, 1);
+    bench(ctx, "append: list_merge",
+          "(fold (func (acc i) (list_merge acc (list i))) (list) idx)", n, 1);
+    bench(ctx, "update: vec_set",
+          "(fold (func (acc i) (vec_set acc i 0)) v idx)", n, 1);
+    bench(ctx, "update: list_set (in place)",
+          "(fold (func (acc i) (lset acc i 0)) l idx)", n, 1);
+    bench(ctx, "update: copy and list_set",
+          "(fold (func (acc i) (lset (copy acc) i 0)) l idx)", n, 1);
+    bench(ctx, "read: vec_get",
+          "(foreach (func (i) (vec_get v i)) idx)", n, 1);
+    bench(ctx, "read: list_get",
+          "(foreach (func (i) (list_get l i)) idx)", n, 1);
+    alisp_free(ctx);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,319 @@
+/*
+Script cache.
+Parse trees of scripts are saved to compact binary .alc files and loaded on later runs
+instead of tokenizing and parsing the source again.  A cache file is valid only for the
+source text it was made from: the header holds a hash and the length of the source.
+
+Cache file is written next to the script (script.al -> script.al.alc), or, when
+ALISP_CACHE_DIR environment variable is set, to that directory under the name made
+of the source hash.
+
+File layout (native byte order, v - LEB128 varint):
+    header      magic "ALC", format version, byte order mark, source hash, source length
+    symbols     v count, then every distinct symbol or string text as v len, len bytes
+    nodes       parse tree in pre-order:
+                    'i' v zigzag integer    integral number
+                    'n' double              other number
+                    's' v index             symbol from the table
+                    'q' v index             string of the text from the table
+                    'l' v n                 list of n following nodes
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <math.h>
+#include "alisp.h"
+
+#define ALC_MAGIC   "ALC"
+#define ALC_BOM     0x01020304u
+
+/* Cache file header */
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint32_t bom;
+    uint32_t reserved;
+    uint64_t hash;
+    uint64_t srclen;
+} alc_header_t;
+
+/* Symbol table: distinct symbols of a tree, open addressing over their hashes */
+typedef struct {
+    char**    syms;
+    uint32_t* slots;    // index + 1, 0 for empty slot
+    uint32_t  len;
+    uint32_t  max;      // number of slots, power of 2
+} symtab_t;
+
+static uint32_t symtab_idx(symtab_t* t, char* s) {
+    if (2 * (t->len + 1) > t->max) {  // keep load factor under 1/2
+        uint32_t max = t->max ? t->max * 2 : 256;
+        uint32_t* slots = calloc(max, sizeof(uint32_t));
+        for (uint32_t i = 0; i < t->len; ++i) {
+            uint64_t j = hash_bytes(t->syms[i], strlen(t->syms[i])) & (max - 1);
+            while (slots[j])
+                j = (j + 1) & (max - 1);
+            slots[j] = i + 1;
+        }
+        safe_free(t->slots);
+        t->slots = slots;
+        t->max = max;
+        t->syms = realloc(t->syms, max * sizeof(char*));
+    }
+    uint64_t j = hash_bytes(s, strlen(s)) & (t->max - 1);
+    for (; t->slots[j]; j = (j + 1) & (t->max - 1))
+        if (streq(t->syms[t->slots[j] - 1], s))
+            return t->slots[j] - 1;
+    t->syms[t->len] = s;
+    t->slots[j] = ++t->len;
+    return t->len - 1;
+}
+
+/*
+--------------------------------------
+cache_path
+
+    Return a newly allocated path of the cache file for a script.
+--------------------------------------
+*/
+char* cache_path(const char* filename, unsigned long long hash) {
+    const char* dir = getenv("ALISP_CACHE_DIR");
+    char* path;
+    if (dir && *dir) {
+        path = malloc(strlen(dir) + 32);
+        sprintf(path, "%s/%016llx.alc", dir, hash);
+    } else {
+        path = malloc(strlen(filename) + 5);
+        sprintf(path, "%s.alc", filename);
+    }
+    return path;
+}
+
+
+// ----------------------------------------------------------------------
+// Save
+
+/* Collect symbols of a tree. Return 0 if it is not a parse tree. */
+static int cache_syms(symtab_t* t, atom_t* obj) {
+    if (obj->type == SYMBOL) {
+        symtab_idx(t, obj->val.sym);
+    } else if (obj->type == STRING) {
+        symtab_idx(t, str_data(obj));
+    } else if (obj->type == LIST) {
+        for (int i = 0; i < list_len(obj); ++i)
+            if (!cache_syms(t, obj->val.list->items[i]))
+                return 0;
+    } else if (obj->type != NUMBER)
+        return 0;
+    return 1;
+}
+
+/* Serialize a parse tree node. */
+static void cache_put(buf_t* b, symtab_t* t, atom_t* obj) {
+    double x;
+    switch (obj->type) {
+    case NUMBER:
+        x = *obj->val.num;
+        if (x == (double)(int64_t)x && (x != 0 || !signbit(x)) &&
+            x > -9.2e18 && x < 9.2e18) {
+            int64_t k = (int64_t)x;
+            buf_put(b, "i", 1);
+            buf_putv(b, ((uint64_t)k << 1) ^ (uint64_t)(k >> 63));
+        } else {
+            buf_put(b, "n", 1);
+            buf_put(b, &x, sizeof(double));
+        }
+        break;
+    case SYMBOL:
+        buf_put(b, "s", 1);
+        buf_putv(b, symtab_idx(t, obj->val.sym));
+        break;
+    case STRING:
+        buf_put(b, "q", 1);
+        buf_putv(b, symtab_idx(t, str_data(obj)));
+        break;
+    case LIST:
+        buf_put(b, "l", 1);
+        buf_putv(b, list_len(obj));
+        for (int i = 0; i < list_len(obj); ++i)
+            cache_put(b, t, obj->val.list->items[i]);
+        break;
+    }
+}
+
+/*
+--------------------------------------
+cache_save
+
+    Write the parse tree of a script to its cache file.  Failures are silent, the
+    cache is an optimization only.
+--------------------------------------
+*/
+void cache_save(const char* filename, const char* src, size_t len, atom_t* ptree) {
+    alc_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ALC_MAGIC, 4);
+    h.version = ALC_VERSION;
+    h.bom = ALC_BOM;
+    h.hash = hash_bytes(src, len);
+    h.srclen = len;
+
+    symtab_t t = {NULL, NULL, 0, 0};
+    buf_t b = {NULL, 0, 0};
+    if (cache_syms(&t, ptree)) {
+        buf_put(&b, &h, sizeof(h));
+        buf_putv(&b, t.len);
+        for (uint32_t i = 0; i < t.len; ++i) {
+            size_t n = strlen(t.syms[i]);
+            buf_putv(&b, n);
+            buf_put(&b, t.syms[i], n);
+        }
+        cache_put(&b, &t, ptree);
+    }
+    safe_free(t.syms);
+    safe_free(t.slots);
+    if (!b.len)
+        return;
+
+    // Write to a temporary file and rename, so readers never see a partial file.
+    // Temporary name is unique per process and thread (stack address of the header).
+    char* path = cache_path(filename, h.hash);
+    char* tmp = malloc(strlen(path) + 64);
+    sprintf(tmp, "%s.%ld.%lx.tmp", path, (long)getpid(), (unsigned long)(uintptr_t)&h);
+    FILE* f = fopen(tmp, "wb");
+    if (f) {
+        int ok = fwrite(b.data, 1, b.len, f) == b.len;
+        ok = !fclose(f) && ok;
+        if (!ok || rename(tmp, path))
+            remove(tmp);
+    }
+    safe_free(tmp);
+    safe_free(path);
+    safe_free(b.data);
+}
+
+
+// ----------------------------------------------------------------------
+// Load
+
+/* Deserialize a parse tree node. Return NULL if data is malformed. */
+static atom_t* cache_get(const char** p, const char* end, char** syms, unsigned long long nsyms,
+                         arena_t* a, int depth) {
+    unsigned long long n;
+    double x;
+    if (*p >= end || depth > CACHE_MAXDEPTH)
+        return NULL;
+
+    switch (*(*p)++) {
+    case 'i':
+        if (!buf_getv(p, end, &n))
+            return NULL;
+        return node_num(a, (double)(int64_t)((n >> 1) ^ -(n & 1)));
+
+    case 'n':
+        if (end - *p < (long)sizeof(double))
+            return NULL;
+        memcpy(&x, *p, sizeof(double));
+        *p += sizeof(double);
+        return node_num(a, x);
+
+    case 's': {
+        if (!buf_getv(p, end, &n) || n >= nsyms || !*syms[n])  // only strings are empty
+            return NULL;
+        atom_t* obj = node_new(a, SYMBOL);
+        obj->val.sym = syms[n];  // nodes share symbol text
+        return obj;
+    }
+
+    case 'q':
+        if (!buf_getv(p, end, &n) || n >= nsyms)
+            return NULL;
+        return node_str(a, syms[n], strlen(syms[n]));
+
+    case 'l': {
+        // A node takes 2+ bytes: divide rather than multiply, n may be anything
+        if (!buf_getv(p, end, &n) || n > (uint64_t)(end - *p) / 2 || n > INT_MAX)
+            return NULL;
+        atom_t* l = node_list(a, n);
+        list_t* ll = l->val.list;
+        for (unsigned long long i = 0; i < n; ++i)
+            if (!(ll->items[ll->len++] = cache_get(p, end, syms, nsyms, a, depth + 1)))
+                return NULL;
+        return l;
+    }
+
+    default:
+        return NULL;
+    }
+}
+
+/*
+--------------------------------------
+cache_load
+
+    Load the parse tree of a script from its cache file.  Return NULL if there is no
+    valid cache file for this source.
+--------------------------------------
+*/
+atom_t* cache_load(const char* filename, const char* src, size_t len, arena_t* a) {
+    uint64_t hash = hash_bytes(src, len);
+    char* path = cache_path(filename, hash);
+    FILE* f = fopen(path, "rb");
+    safe_free(path);
+    if (!f)
+        return NULL;
+
+    // Read the whole file
+    fseek(f, 0L, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0L, SEEK_SET);
+    if (size < (long)sizeof(alc_header_t)) {
+        fclose(f);
+        return NULL;
+    }
+    char* data = malloc(size);
+    int ok = fread(data, 1, size, f) == (size_t)size;
+    fclose(f);
+
+    // Check header
+    alc_header_t h;
+    memcpy(&h, data, sizeof(h));
+    ok = ok && !memcmp(h.magic, ALC_MAGIC, 4) && h.version == ALC_VERSION &&
+         h.bom == ALC_BOM && h.hash == hash && h.srclen == len;
+
+    atom_t* ptree = NULL;
+    const char* p = data + sizeof(h);
+    const char* end = data + size;
+    unsigned long long nsyms = 0, n, i;
+    char** syms = NULL;
+
+    // Read symbol table
+    if (ok && buf_getv(&p, end, &nsyms) && nsyms <= (uint64_t)(end - p)) {
+        syms = malloc((nsyms + 1) * sizeof(char*));
+        for (i = 0; i < nsyms; ++i) {
+            if (!buf_getv(&p, end, &n) || n > (uint64_t)(end - p))
+                break;
+            syms[i] = arena_strdup(a, p, n);
+            p += n;
+        }
+        ok = i == nsyms;
+    } else
+        ok = 0;
+
+    // Read parse tree
+    if (ok) {
+        ptree = cache_get(&p, end, syms, nsyms, a, 0);
+        if (p != end)
+            ptree = NULL;  // trailing garbage
+    }
+
+    safe_free(syms);
+    safe_free(data);
+    if (!ptree)
+        arena_reset(a);  // drop partially loaded tree
+    return ptree;
+}
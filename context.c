@@ -0,0 +1,78 @@
+/*
+Interpreter context.
+Everything one interpreter needs: global and active environments, parser settings and
+arena, input line and output buffer.  Contexts are independent, so several interpreters
+can live in one process and run on different threads.
+
+Memory management routines deep inside atom, list and dictionary code don't take the
+context as an argument; they use the context current for the calling thread, which is
+set by ctx_new and ctx_set.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "alisp.h"
+
+__thread alisp_ctx* ctx_cur = NULL;  // current context of the thread
+
+/*
+--------------------------------------
+ctx_new
+
+    Make an interpreter context with a fresh global environment and make it current.
+--------------------------------------
+*/
+alisp_ctx* ctx_new() {
+    alisp_ctx* ctx = malloc(sizeof(alisp_ctx));
+    ctx->global_env = NULL;
+    ctx->active_env = NULL;
+    ctx->arena = arena_new(ARENA_CHUNK);
+    ctx->input = NULL;
+    ctx->parse_jobs = 1;
+    ctx->pool = NULL;
+    ctx->use_cache = 1;
+    out_open(&ctx->out, OUT_FD);
+
+    ctx_set(ctx);
+    globenv_init(ctx);
+    ctx->active_env = ctx->global_env;
+    return ctx;
+}
+
+/* Make context current for the calling thread. Return previous one. */
+alisp_ctx* ctx_set(alisp_ctx* ctx) {
+    alisp_ctx* prev = ctx_cur;
+    ctx_cur = ctx;
+    return prev;
+}
+
+/* Set the number of threads for parsing scripts. */
+void ctx_set_jobs(alisp_ctx* ctx, int jobs) {
+    pool_del(ctx->pool);
+    ctx->pool = NULL;
+    ctx->parse_jobs = jobs < 1 ? 1 : jobs;
+    if (ctx->parse_jobs > 1)
+        ctx->pool = pool_new(ctx->parse_jobs);
+}
+
+/*
+--------------------------------------
+ctx_del
+
+    Deallocate a context and everything it owns.
+--------------------------------------
+*/
+void ctx_del(alisp_ctx* ctx) {
+    if (!ctx)
+        return;
+    alisp_ctx* prev = ctx_set(ctx);
+
+    globenv_del(ctx);
+    out_close(&ctx->out);
+    pool_del(ctx->pool);
+    arena_del(ctx->arena);
+    safe_free(ctx->input);
+
+    ctx_set(prev == ctx ? NULL : prev);
+    safe_free(ctx);
+}
@@ -34,6 +34,7 @@ atom_t* dict(int size, atom_t* parent) {
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.dict = d;
     obj->type = DICTIONARY;
+    obj->flags = 0;
     obj->bindings = 0;
 
     return obj;
@@ -77,29 +78,6 @@ safe_free(dbg_s);
     safe_free(obj);         // free object
 }
 
-/*
---------------------------------------
-dict_cp
-
-    Copy a dictionary (subroutine for atom_cp).
---------------------------------------
-*/
-atom_t* dict_cp(atom_t* obj, atom_t* objects, atom_t* copies) {
-    int i = list_idx(objects, obj);
-    if (i != -1)
-        return copies->val.list->items[i];  // object already has a copy
-
-    atom_t* copy = dict(obj->val.dict->maxlen, obj->val.dict->parent);
-    list_add_h(objects, obj);
-    list_add_h(copies, copy);
-
-    char** keys = obj->val.dict->keys;
-    atom_t** vals = obj->val.dict->vals;
-    for (int i = 0; i < obj->val.dict->len; ++i)
-        dict_add(copy, keys[i], atom_cp(vals[i], objects, copies));
-    return copy;
-}
-
 /*
 --------------------------------------
 dict_add
@@ -295,15 +273,15 @@ dict_print
 void dict_print(atom_t* dictionary, int depth) {
     dict_assert(dictionary, "dict_print");
     dict_t* d = dictionary->val.dict;
-    printf("{\n");
+    out_str("{\n");
     for (int i = 0; i < d->len; i++) {
         if (d->vals[i]->type != STD_OP) {
             char* o = atom_tostring(d->vals[i], depth ? depth - 1 : depth);
-            printf("  %s : %s\n", d->keys[i], o);
+            out_printf("  %s : %s\n", d->keys[i], o);
             safe_free(o);
         }
     }
-    printf("}\n");
+    out_str("}\n");
 }
 
 /*
@@ -14,7 +14,7 @@ eval
     Evaluate an expression in an environment.
 --------------------------------------
 */
-atom_t* eval(atom_t* expr, atom_t* env, atom_t** ret) {
+atom_t* eval(alisp_ctx* ctx, atom_t* expr, atom_t* env, atom_t** ret) {
 
 #ifdef DEBUG
 char* dbg_s = atom_tostr(expr);
@@ -22,7 +22,7 @@ printf("....  eval:                    %s\n", dbg_s);
 safe_free(dbg_s);
 #endif
 
-    active_env = env;
+    ctx->active_env = env;
 
     if (!(expr && env)) {
         printf("\x1b[95m" "Fatal error: eval: bad argument(s)!\n" "\x1b[0m");
@@ -32,14 +32,17 @@ safe_free(dbg_s);
     // -------------------------------------
     // Primitive expressions
 
-    if (expr->type == NUMBER)
-        return expr;                            // number
+    // Literals from a parse tree are copied to the heap, since the tree is
+    // released all at once after evaluation.
+
+    if (expr->type == NUMBER)                   // number
+        return expr->flags & F_ARENA ? num(*expr->val.num) : expr;
+
+    if (expr->type == STRING)                   // quoted string
+        return expr->flags & F_ARENA ? str_copy(expr) : expr;
     
     if (expr->type == SYMBOL) {
         
-        if (expr->val.sym[0] == '"')
-            return expr;                        // quoted string
-        
         atom_t* v = dict_get(env, expr->val.sym);
         if (v)
             return v;                           // variable
@@ -98,23 +101,20 @@ safe_free(dbg_s);
                     body = clause[1];
                 // Check if 'else' is encountered
                 if (test->type == SYMBOL && streq(test->val.sym, "else")) {
-                    atom_t* v = eval(body, env, ret);
-                    active_env = env;
+                    atom_t* v = eval(ctx, body, env, ret);
+                    ctx->active_env = env;
                     atom_del(body);
                     return v;
                 }
                 // Evaluate test. If it's true -- evaluate body
-                test = eval(test, env, NULL);
-                active_env = env;
+                test = eval(ctx, test, env, NULL);
+                ctx->active_env = env;
                 if (!test)
                     return NULL;
-                if (!(test->type == NIL ||
-                     (test->type == NUMBER && *test->val.num == 0) ||
-                     (test->type == SYMBOL && strlen(test->val.sym) == 0) ||
-                     (test->type == LIST && list_len(test) == 0))) {
+                if (atom_true(test)) {
                     atom_del(test);
-                    atom_t* v = eval(body, env, ret);
-                    active_env = env;
+                    atom_t* v = eval(ctx, body, env, ret);
+                    ctx->active_env = env;
                     atom_del(body);
                     return v;
                 } else {
@@ -133,21 +133,18 @@ safe_free(dbg_s);
                 list_print(expr, 0);
                 return NULL;
             }
-            atom_t* test = eval(items[1], env, NULL);
-            active_env = env;
+            atom_t* test = eval(ctx, items[1], env, NULL);
+            ctx->active_env = env;
             if (!test)
                 return NULL;
-            if (test->type == NIL ||
-               (test->type == NUMBER && *test->val.num == 0) ||
-               (test->type == SYMBOL && strlen(test->val.sym) == 0) ||
-               (test->type == LIST && list_len(test) == 0)) {
+            if (!atom_true(test)) {
                 atom_del(test);
                 if (elen == 4)
-                    return eval(items[3], env, ret);
+                    return eval(ctx, items[3], env, ret);
                 return &nilobj;
             } else {
                 atom_del(test);
-                return eval(items[2], env, ret);
+                return eval(ctx, items[2], env, ret);
             }
 
         // -------------------------------------
@@ -174,8 +171,8 @@ safe_free(dbg_s);
                 dict_add(env, items[1]->val.sym, &nilobj);
                 return &nilobj;
             } else {
-                atom_t* v = eval(items[2], env, NULL);
-                active_env = env;
+                atom_t* v = eval(ctx, items[2], env, NULL);
+                ctx->active_env = env;
                 if (!v)
                     return NULL;
                 dict_add(env, items[1]->val.sym, v);
@@ -202,8 +199,8 @@ safe_free(dbg_s);
                 safe_free(o);
                 return NULL;
             }
-            atom_t* v = eval(items[2], env, NULL);
-            active_env = env;
+            atom_t* v = eval(ctx, items[2], env, NULL);
+            ctx->active_env = env;
             if (!v)
                 return NULL;
             dict_add(e, items[1]->val.sym, v);
@@ -217,8 +214,8 @@ safe_free(dbg_s);
                 list_print(expr, 0);
                 return NULL;
             }
-            atom_t* v = eval(items[1], env, NULL);
-            active_env = env;
+            atom_t* v = eval(ctx, items[1], env, NULL);
+            ctx->active_env = env;
             if (!v)
                 return NULL;
             if (v->type == NIL)
@@ -262,9 +259,9 @@ safe_free(dbg_s);
             for (int i = 1; !block_ret && i < elen; ++i) {
                 if (last_v)
                     atom_del(last_v);
-                if(!(last_v = eval(items[i], env, &block_ret)))
+                if(!(last_v = eval(ctx, items[i], env, &block_ret)))
                     return NULL;  // some eval encountered an error
-                active_env = env;
+                ctx->active_env = env;
             }
             if (!block_ret)
                 return last_v;  // value of the last expression in a block (default)
@@ -284,7 +281,7 @@ safe_free(dbg_s);
                 list_print(expr, 0);
                 return NULL;
             }
-            return *ret = eval(items[1], env, NULL);
+            return *ret = eval(ctx, items[1], env, NULL);
 
         // -------------------------------------
         // apply procedure to arguments         (proc [arg ...])
@@ -295,8 +292,8 @@ printf("....  eval:                    Evaluating procedure and arguments\n");
 #endif
 
             // Evaluate procedure
-            atom_t* proc = eval(items[0], env, NULL);
-            active_env = env;
+            atom_t* proc = eval(ctx, items[0], env, NULL);
+            ctx->active_env = env;
             if (!proc)
                 return NULL;
 
@@ -304,8 +301,8 @@ printf("....  eval:                    Evaluating procedure and arguments\n");
             atom_t* args = list();
             atom_t* v;
             for (int i = 1; i < elen; ++i) {
-                v = eval(items[i], env, NULL);
-                active_env = env;
+                v = eval(ctx, items[i], env, NULL);
+                ctx->active_env = env;
                 if (v) {
                     list_add(args, v);
                 } else {
@@ -328,8 +325,8 @@ safe_free(dbg_s2);
 #endif
 
             // Apply
-            v = apply(expr, proc, args);
-            active_env = env;
+            v = apply(ctx, expr, proc, args);
+            ctx->active_env = env;
 
 #ifdef DEBUG
 dbg_s = v ? atom_tostr(v) : "NULL";
@@ -0,0 +1,521 @@
+/*
+F64 array: contiguous sequence of raw doubles for numeric work.
+A list of numbers is an array of pointers to atoms that each point to a double; an
+array keeps the doubles themselves, aligned for vector registers.  Arrays never
+change: arithmetic returns a new array, so arrays can be frozen and read by many
+threads at once.
+
+Math operators broadcast over arrays: unary ones apply to every item, binary ones
+pair items of two arrays of the same length, or every item of an array with a number.
+Addition, subtraction, multiplication, division, sum, dot product, minimum, maximum,
+square root and absolute value run in kernels for the widest instruction set of the
+processor, AVX2 or SSE2, picked once at run time.  F64_SIMD_ENV limits the choice.
+Other operators go item by item.
+
+Vector kernels add up sums and dot products in several lanes at once, so their
+results may differ from a sequential sum in the last bits.
+
+A matrix is an array of type MATRIX with a shape: its items are rows one after
+another.  Elementwise operators treat it as an array of the same shape; matrix.c
+multiplies and solves through the kernels here.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "alisp.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define F64_X86
+#endif
+
+#define F64_ALIGN 32    // bytes, width of an AVX2 register
+
+/* Kernels of an instruction set */
+typedef struct {
+    void   (*binop[4])(double*, const double*, const double*, int, int);
+    double (*sum)(const double*, int);
+    double (*dot)(const double*, const double*, int);
+    double (*min)(const double*, int);
+    double (*max)(const double*, int);
+    void   (*sqrt)(double*, const double*, int);
+    void   (*abs)(double*, const double*, int);
+    void   (*madd)(double*, int, const double*, int, const double*, int, int, int, int);
+} kernels_t;
+
+/* Binary kernel modes: which operands are single numbers instead of arrays */
+#define A_SCALAR 1
+#define B_SCALAR 2
+
+
+// ----------------------------------------------------------------------
+// Kernels
+
+/*
+Kernels are generated for every instruction set from the same templates: V is the
+register type, W its width in doubles, P the prefix of intrinsics.  A scalar operand
+is broadcast to a register once; leftover items are done one by one.
+*/
+
+#define BINOP(isa, target, V, W, P, op, sop)                                          \
+    target static void isa##_##op(double* r, const double* a, const double* b, int n, \
+                                  int mode) {                                         \
+        V va = P##_set1_pd(mode & A_SCALAR ? *a : 0);                                 \
+        V vb = P##_set1_pd(mode & B_SCALAR ? *b : 0);                                 \
+        int i = 0;                                                                    \
+        for (; i + W <= n; i += W) {                                                  \
+            if (!(mode & A_SCALAR))                                                   \
+                va = P##_loadu_pd(a + i);                                             \
+            if (!(mode & B_SCALAR))                                                   \
+                vb = P##_loadu_pd(b + i);                                             \
+            P##_storeu_pd(r + i, P##_##op##_pd(va, vb));                              \
+        }                                                                             \
+        for (; i < n; ++i)                                                            \
+            r[i] = (mode & A_SCALAR ? *a : a[i]) sop (mode & B_SCALAR ? *b : b[i]);   \
+    }
+
+#define KERNELS(isa, target, V, W, P)                                                 \
+    BINOP(isa, target, V, W, P, add, +)                                               \
+    BINOP(isa, target, V, W, P, sub, -)                                               \
+    BINOP(isa, target, V, W, P, mul, *)                                               \
+    BINOP(isa, target, V, W, P, div, /)                                               \
+                                                                                      \
+    /* Add up lanes of a register */                                                  \
+    target static double isa##_lanes(V v) {                                           \
+        double t[W];                                                                  \
+        P##_storeu_pd(t, v);                                                          \
+        double s = 0;                                                                 \
+        for (int j = 0; j < W; ++j)                                                   \
+            s += t[j];                                                                \
+        return s;                                                                     \
+    }                                                                                 \
+                                                                                      \
+    target static double isa##_sum(const double* a, int n) {                          \
+        V s0 = P##_setzero_pd(), s1 = P##_setzero_pd();                               \
+        int i = 0;                                                                    \
+        for (; i + 2 * W <= n; i += 2 * W) {                                          \
+            s0 = P##_add_pd(s0, P##_loadu_pd(a + i));                                 \
+            s1 = P##_add_pd(s1, P##_loadu_pd(a + i + W));                             \
+        }                                                                             \
+        double s = isa##_lanes(P##_add_pd(s0, s1));                                   \
+        for (; i < n; ++i)                                                            \
+            s += a[i];                                                                \
+        return s;                                                                     \
+    }                                                                                 \
+                                                                                      \
+    target static double isa##_dot(const double* a, const double* b, int n) {         \
+        V s0 = P##_setzero_pd(), s1 = P##_setzero_pd();                               \
+        int i = 0;                                                                    \
+        for (; i + 2 * W <= n; i += 2 * W) {                                          \
+            s0 = P##_add_pd(s0, P##_mul_pd(P##_loadu_pd(a + i), P##_loadu_pd(b + i)));\
+            s1 = P##_add_pd(s1, P##_mul_pd(P##_loadu_pd(a + i + W),                   \
+                                           P##_loadu_pd(b + i + W)));                 \
+        }                                                                             \
+        double s = isa##_lanes(P##_add_pd(s0, s1));                                   \
+        for (; i < n; ++i)                                                            \
+            s += a[i] * b[i];                                                         \
+        return s;                                                                     \
+    }                                                                                 \
+                                                                                      \
+    /* Minimum or maximum of n > 0 items */                                           \
+    target static double isa##_min(const double* a, int n) {                          \
+        V m = P##_set1_pd(a[0]);                                                      \
+        int i = 0;                                                                    \
+        for (; i + W <= n; i += W)                                                    \
+            m = P##_min_pd(P##_loadu_pd(a + i), m);                                   \
+        double t[W], r = a[0];                                                        \
+        P##_storeu_pd(t, m);                                                          \
+        for (int j = 0; j < W; ++j)                                                   \
+            r = t[j] < r ? t[j] : r;                                                  \
+        for (; i < n; ++i)                                                            \
+            r = a[i] < r ? a[i] : r;                                                  \
+        return r;                                                                     \
+    }                                                                                 \
+                                                                                      \
+    target static double isa##_max(const double* a, int n) {                          \
+        V m = P##_set1_pd(a[0]);                                                      \
+        int i = 0;                                                                    \
+        for (; i + W <= n; i += W)                                                    \
+            m = P##_max_pd(P##_loadu_pd(a + i), m);                                   \
+        double t[W], r = a[0];                                                        \
+        P##_storeu_pd(t, m);                                                          \
+        for (int j = 0; j < W; ++j)                                                   \
+            r = t[j] > r ? t[j] : r;                                                  \
+        for (; i < n; ++i)                                                            \
+            r = a[i] > r ? a[i] : r;                                                  \
+        return r;                                                                     \
+    }                                                                                 \
+                                                                                      \
+    target static void isa##_sqrt(double* r, const double* a, int n) {                \
+        int i = 0;                                                                    \
+        for (; i + W <= n; i += W)                                                    \
+            P##_storeu_pd(r + i, P##_sqrt_pd(P##_loadu_pd(a + i)));                   \
+        for (; i < n; ++i)                                                            \
+            r[i] = sqrt(a[i]);                                                        \
+    }                                                                                 \
+                                                                                      \
+    /* Clear the sign bit */                                                          \
+    target static void isa##_abs(double* r, const double* a, int n) {                 \
+        V sign = P##_set1_pd(-0.0);                                                   \
+        int i = 0;                                                                    \
+        for (; i + W <= n; i += W)                                                    \
+            P##_storeu_pd(r + i, P##_andnot_pd(sign, P##_loadu_pd(a + i)));           \
+        for (; i < n; ++i)                                                            \
+            r[i] = fabs(a[i]);                                                        \
+    }                                                                                 \
+                                                                                      \
+    /* C[m x nc] += A[m x kc] * B[kc x nc], rows ldc, lda, ldb items apart.  Four */  \
+    /* rows of B are added to a row of C at once, to load and store C less often */   \
+    target static void isa##_madd(double* c, int ldc, const double* a, int lda,       \
+                                  const double* b, int ldb, int m, int kc, int nc) {  \
+        for (int i = 0; i < m; ++i) {                                                 \
+            double* ci = c + (size_t)i * ldc;                                         \
+            const double* ai = a + (size_t)i * lda;                                   \
+            int k = 0;                                                                \
+            for (; k + 4 <= kc; k += 4) {                                             \
+                const double* b0 = b + (size_t)k * ldb;                               \
+                const double* b1 = b0 + ldb;                                          \
+                const double* b2 = b1 + ldb;                                          \
+                const double* b3 = b2 + ldb;                                          \
+                V a0 = P##_set1_pd(ai[k]), a1 = P##_set1_pd(ai[k + 1]);               \
+                V a2 = P##_set1_pd(ai[k + 2]), a3 = P##_set1_pd(ai[k + 3]);           \
+                int j = 0;                                                            \
+                for (; j + W <= nc; j += W) {                                         \
+                    V s = P##_add_pd(                                                 \
+                        P##_add_pd(P##_mul_pd(a0, P##_loadu_pd(b0 + j)),              \
+                                   P##_mul_pd(a1, P##_loadu_pd(b1 + j))),             \
+                        P##_add_pd(P##_mul_pd(a2, P##_loadu_pd(b2 + j)),              \
+                                   P##_mul_pd(a3, P##_loadu_pd(b3 + j))));            \
+                    P##_storeu_pd(ci + j, P##_add_pd(P##_loadu_pd(ci + j), s));       \
+                }                                                                     \
+                for (; j < nc; ++j)                                                   \
+                    ci[j] = ci[j] + ((ai[k] * b0[j] + ai[k + 1] * b1[j]) +            \
+                                     (ai[k + 2] * b2[j] + ai[k + 3] * b3[j]));        \
+            }                                                                         \
+            for (; k < kc; ++k) {                                                     \
+                const double* b0 = b + (size_t)k * ldb;                               \
+                V a0 = P##_set1_pd(ai[k]);                                            \
+                int j = 0;                                                            \
+                for (; j + W <= nc; j += W)                                           \
+                    P##_storeu_pd(ci + j, P##_add_pd(P##_loadu_pd(ci + j),            \
+                                                     P##_mul_pd(a0, P##_loadu_pd(b0 + j))));\
+                for (; j < nc; ++j)                                                   \
+                    ci[j] = ci[j] + ai[k] * b0[j];                                    \
+            }                                                                         \
+        }                                                                             \
+    }                                                                                 \
+                                                                                      \
+    static const kernels_t isa##_kernels = {                                          \
+        {isa##_add, isa##_sub, isa##_mul, isa##_div}, isa##_sum, isa##_dot,           \
+        isa##_min, isa##_max, isa##_sqrt, isa##_abs, isa##_madd };
+
+/* Scalar stand-ins for intrinsics: registers of one double */
+#define scalar_set1_pd(x)       (x)
+#define scalar_setzero_pd()     0.0
+#define scalar_loadu_pd(p)      (*(p))
+#define scalar_storeu_pd(p, x)  (*(p) = (x))
+#define scalar_add_pd(x, y)     ((x) + (y))
+#define scalar_sub_pd(x, y)     ((x) - (y))
+#define scalar_mul_pd(x, y)     ((x) * (y))
+#define scalar_div_pd(x, y)     ((x) / (y))
+#define scalar_min_pd(x, y)     ((x) < (y) ? (x) : (y))
+#define scalar_max_pd(x, y)     ((x) > (y) ? (x) : (y))
+#define scalar_sqrt_pd(x)       sqrt(x)
+#define scalar_andnot_pd(m, x)  ((void)(m), fabs(x))
+
+KERNELS(scalar, , double, 1, scalar)
+
+#ifdef F64_X86
+KERNELS(sse2, __attribute__((target("sse2"))), __m128d, 2, _mm)
+KERNELS(avx2, __attribute__((target("avx2"))), __m256d, 4, _mm256)
+#endif
+
+static const kernels_t* kernels = &scalar_kernels;
+static pthread_once_t   kernels_once = PTHREAD_ONCE_INIT;
+
+/* Pick the widest kernels the processor runs, within F64_SIMD_ENV. */
+static void kernels_init() {
+#ifdef F64_X86
+    const char* s = getenv(F64_SIMD_ENV);
+    int cap = !s ? 2 : streq(s, "scalar") ? 0 : streq(s, "sse2") ? 1 : 2;
+    __builtin_cpu_init();
+    if (cap >= 2 && __builtin_cpu_supports("avx2"))
+        kernels = &avx2_kernels;
+    else if (cap >= 1 && __builtin_cpu_supports("sse2"))
+        kernels = &sse2_kernels;
+#endif
+}
+
+/* Return the kernels in use. */
+static const kernels_t* f64_kernels() {
+    pthread_once(&kernels_once, kernels_init);
+    return kernels;
+}
+
+
+// ----------------------------------------------------------------------
+// Arrays
+
+/*
+--------------------------------------
+f64_new
+
+    Make an array of n items, not initialized.
+--------------------------------------
+*/
+atom_t* f64_new(int n) {
+    f64array_t* a = malloc(sizeof(f64array_t));
+    size_t size = ((size_t)n * sizeof(double) + F64_ALIGN - 1) / F64_ALIGN * F64_ALIGN;
+    a->len = n;
+    a->rows = 1;
+    a->cols = n;
+    a->data = aligned_alloc(F64_ALIGN, size ? size : F64_ALIGN);
+    if (!a->data) {
+        printf("\x1b[95m" "Fatal error: f64_new: out of memory!\n" "\x1b[0m");
+        exit(EXIT_FAILURE);
+    }
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.arr = a;
+    obj->type = F64ARRAY;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Deallocate an array. */
+void f64_del(atom_t* obj) {
+    safe_free(obj->val.arr->data);
+    safe_free(obj->val.arr);
+    safe_free(obj);
+}
+
+/* Return the number of items. */
+int f64_len(atom_t* obj) {
+    return obj->val.arr->len;
+}
+
+/* Return the items. */
+double* f64_data(atom_t* obj) {
+    return obj->val.arr->data;
+}
+
+/* Is an object an array or a matrix? */
+int f64_is(atom_t* obj) {
+    return obj->type == F64ARRAY || obj->type == MATRIX;
+}
+
+/* Make an array of n items of the type and shape of another, not initialized. */
+static atom_t* f64_like(atom_t* obj, int n) {
+    atom_t* res = f64_new(n);
+    res->type = obj->type;
+    res->val.arr->rows = obj->val.arr->rows;
+    res->val.arr->cols = obj->val.arr->cols;
+    return res;
+}
+
+/* Copy an array or a matrix. */
+atom_t* f64_copy(atom_t* obj) {
+    atom_t* copy = f64_like(obj, f64_len(obj));
+    memcpy(f64_data(copy), f64_data(obj), f64_len(obj) * sizeof(double));
+    return copy;
+}
+
+/*
+--------------------------------------
+f64_from
+
+    Make an array of the items of a list or a range.  Return NULL if some items are
+    not numbers or the range is too long.
+--------------------------------------
+*/
+atom_t* f64_from(atom_t* lst) {
+    if (lst->type == RANGE) {
+        int n = range_len(lst);
+        if (n > F64_MAX_LEN) {
+            errmsg("Semantic", "range is too long", NULL, NULL);
+            return NULL;
+        }
+        atom_t* obj = f64_new(n);
+        double* d = f64_data(obj);
+        for (int i = 0; i < n; ++i)
+            d[i] = range_item(lst, i);
+        return obj;
+    }
+
+    int n = list_len(lst);
+    atom_t** items = lst->val.list->items;
+    for (int i = 0; i < n; ++i)
+        if (items[i]->type != NUMBER) {
+            errmsg("Semantic", "array items must be numbers", NULL, NULL);
+            return NULL;
+        }
+    atom_t* obj = f64_new(n);
+    double* d = f64_data(obj);
+    for (int i = 0; i < n; ++i)
+        d[i] = *items[i]->val.num;
+    return obj;
+}
+
+/*
+--------------------------------------
+f64_range
+
+    Make an array of numbers from start up to stop, not including it, by step.
+    Return NULL if the step is 0 or the range is too long.
+--------------------------------------
+*/
+atom_t* f64_range(double start, double stop, double step) {
+    if (step == 0) {
+        errmsg("Semantic", "step is zero", NULL, NULL);
+        return NULL;
+    }
+    double count = ceil((stop - start) / step);
+    if (!(count <= F64_MAX_LEN)) {  // also NaN
+        errmsg("Semantic", "range is too long", NULL, NULL);
+        return NULL;
+    }
+    int n = count > 0 ? (int)count : 0;
+    atom_t* obj = f64_new(n);
+    double* d = f64_data(obj);
+    for (int i = 0; i < n; ++i)
+        d[i] = start + i * step;
+    return obj;
+}
+
+/* Return a list of the items. */
+atom_t* f64_list(atom_t* obj) {
+    int n = f64_len(obj);
+    double* d = f64_data(obj);
+    atom_t* lst = list();
+    list_reserve(lst, n);
+    for (int i = 0; i < n; ++i)
+        list_add(lst, num(d[i]));
+    return lst;
+}
+
+/*
+--------------------------------------
+f64_math1
+
+    Apply a math operator to every item of an array or a matrix. Return the array or
+    matrix of results.
+--------------------------------------
+*/
+atom_t* f64_math1(atom_t* obj, double (*op)(double)) {
+    int n = f64_len(obj);
+    double* a = f64_data(obj);
+    atom_t* res = f64_like(obj, n);
+    double* r = f64_data(res);
+    if (op == op_sqrt)
+        f64_kernels()->sqrt(r, a, n);
+    else if (op == op_fabs)
+        f64_kernels()->abs(r, a, n);
+    else
+        for (int i = 0; i < n; ++i)
+            r[i] = op(a[i]);
+    return res;
+}
+
+/*
+--------------------------------------
+f64_math2
+
+    Apply a binary math operator to pairs of items of two arrays or matrices of the
+    same shape, or to every item of one and a number.  Return the array or matrix of
+    results, a number if both x and y are numbers, or NULL if the shapes differ.
+--------------------------------------
+*/
+atom_t* f64_math2(atom_t* x, atom_t* y, double (*op)(double, double)) {
+    int mode = (x->type == NUMBER ? A_SCALAR : 0) | (y->type == NUMBER ? B_SCALAR : 0);
+    if (mode == (A_SCALAR | B_SCALAR))
+        return num(op(*x->val.num, *y->val.num));
+    int n = mode & A_SCALAR ? f64_len(y) : f64_len(x);
+    if (!mode && x->type != y->type) {
+        errmsg("Semantic", "wrong type of argument", NULL, NULL);
+        return NULL;
+    } else if (!mode && (x->val.arr->rows != y->val.arr->rows ||
+                         x->val.arr->cols != y->val.arr->cols)) {
+        errmsg("Semantic", x->type == MATRIX ? "matrices differ in shape" :
+               "arrays differ in length", NULL, NULL);
+        return NULL;
+    }
+    const double* a = mode & A_SCALAR ? x->val.num : f64_data(x);
+    const double* b = mode & B_SCALAR ? y->val.num : f64_data(y);
+    atom_t* res = f64_like(mode & A_SCALAR ? y : x, n);
+    double* r = f64_data(res);
+
+    int k = op == op_add ? 0 : op == op_sub ? 1 : op == op_mul ? 2 : op == op_div ? 3 : -1;
+    if (k >= 0)
+        f64_kernels()->binop[k](r, a, b, n, mode);
+    else
+        for (int i = 0; i < n; ++i)
+            r[i] = op(mode & A_SCALAR ? *a : a[i], mode & B_SCALAR ? *b : b[i]);
+    return res;
+}
+
+/* Sum of the items. */
+double f64_sum(atom_t* obj) {
+    return f64_kernels()->sum(f64_data(obj), f64_len(obj));
+}
+
+/* Dot product of two arrays of the same length. */
+double f64_dot(atom_t* x, atom_t* y) {
+    return f64_kernels()->dot(f64_data(x), f64_data(y), f64_len(x));
+}
+
+/* Dot product of n items. */
+double f64_vdot(const double* a, const double* b, int n) {
+    return f64_kernels()->dot(a, b, n);
+}
+
+/* C[m x nc] += A[m x kc] * B[kc x nc], rows of every matrix ld items apart. */
+void f64_madd(double* c, int ldc, const double* a, int lda, const double* b, int ldb,
+              int m, int kc, int nc) {
+    f64_kernels()->madd(c, ldc, a, lda, b, ldb, m, kc, nc);
+}
+
+/* Minimum of the items of a non-empty array. */
+double f64_min(atom_t* obj) {
+    return f64_kernels()->min(f64_data(obj), f64_len(obj));
+}
+
+/* Maximum of the items of a non-empty array. */
+double f64_max(atom_t* obj) {
+    return f64_kernels()->max(f64_data(obj), f64_len(obj));
+}
+
+/*
+--------------------------------------
+f64_tostr
+
+    Make a string representing an array.
+--------------------------------------
+*/
+char* f64_tostr(atom_t* obj) {
+    int n = f64_len(obj);
+    double* d = f64_data(obj);
+    char* o;
+    char buf[1024];
+    char tmp[64];
+    strcpy(buf, "f64[");
+
+    for (int i = 0; i < n; ++i) {
+        sprintf(tmp, "%g", d[i]);
+        if (strlen(buf) + strlen(tmp) > 1000) {
+            strcat(buf, " ... ");
+            break;
+        }
+        strcat(buf, tmp);
+        if (i < n - 1)
+            strcat(buf, " ");
+    }
+
+    strcat(buf, "]");
+    o = malloc(strlen(buf) + 1);
+    strcpy(o, buf);
+    return o;
+}
@@ -9,12 +9,9 @@ Routines for standard operators and procedures.
 #include <math.h>
 #include "alisp.h"
 
-atom_t* global_env;
-atom_t* active_env;
-
 /* Create global environment. */
-void globenv_init() {
-    if (global_env) {
+void globenv_init(alisp_ctx* ctx) {
+    if (ctx->global_env) {
         printf("\x1b[95m" "Fatal error: globenv_init: global environment already exists!\n" "\x1b[0m");
         exit(EXIT_FAILURE);
     }
@@ -23,7 +20,7 @@ void globenv_init() {
 printf("....  globenv_init:            Creating global environment\n");
 #endif
 
-    global_env = dict(32, NULL);
+    atom_t* global_env = ctx->global_env = dict(32, NULL);
 
     atom_t* trueobj = num(1);
     atom_t* falseobj = num(0);
@@ -39,6 +36,7 @@ printf("....  globenv_init:            Creating global environment\n");
     /* Output */
     dict_add(global_env, "print",   op_print());
     dict_add(global_env, "println", op_println());
+    dict_add(global_env, "flush",   op_flush());
     /* Arithmetic */
     dict_add(global_env, "+",    op_math2r(op_add));
     dict_add(global_env, "-",    op_math2r(op_sub));
@@ -89,6 +87,7 @@ printf("....  globenv_init:            Creating global environment\n");
     /* Type */
     dict_add(global_env, "copy", op_copy());
     dict_add(global_env, "type", op_type());
+    dict_add(global_env, "freeze", op_freeze());
     /* Lists */
     dict_add(global_env, "list",       op_list());
     dict_add(global_env, "list_get",   op_list_get());
@@ -98,11 +97,99 @@ printf("....  globenv_init:            Creating global environment\n");
     dict_add(global_env, "list_ins",   op_list_ins());
     dict_add(global_env, "list_rem",   op_list_rem());
     dict_add(global_env, "list_merge", op_list_merge());
+    dict_add(global_env, "map",        op_map());
+    dict_add(global_env, "filter",     op_filter());
+    dict_add(global_env, "reduce",     op_reduce());
+    dict_add(global_env, "fold",       op_fold());
+    dict_add(global_env, "foreach",    op_foreach());
+    dict_add(global_env, "pmap",       op_pmap());
+    dict_add(global_env, "preduce",    op_preduce());
+    dict_add(global_env, "sort",        op_sort());
+    dict_add(global_env, "stable_sort", op_stable_sort());
+    dict_add(global_env, "bsearch",     op_bsearch());
+    dict_add(global_env, "lower_bound", op_lower_bound());
+    /* Vectors */
+    dict_add(global_env, "vec",       op_vec());
+    dict_add(global_env, "vec_get",   op_vec_get());
+    dict_add(global_env, "vec_set",   op_vec_set());
+    dict_add(global_env, "vec_len",   op_vec_len());
+    dict_add(global_env, "vec_add",   op_vec_add());
+    dict_add(global_env, "vec_merge", op_vec_merge());
+    dict_add(global_env, "vec_from",  op_vec_from());
+    dict_add(global_env, "vec_list",  op_vec_list());
+    /* Hash maps */
+    dict_add(global_env, "hashmap", op_hashmap());
+    dict_add(global_env, "hm_get",  op_hm_get());
+    dict_add(global_env, "hm_set",  op_hm_set());
+    dict_add(global_env, "hm_has",  op_hm_has());
+    dict_add(global_env, "hm_del",  op_hm_del());
+    dict_add(global_env, "hm_keys", op_hm_keys());
+    dict_add(global_env, "hm_len",  op_hm_len());
+    /* Sets */
+    dict_add(global_env, "set",        op_set());
+    dict_add(global_env, "set_add",    op_set_add());
+    dict_add(global_env, "set_has",    op_set_has());
+    dict_add(global_env, "set_rem",    op_set_rem());
+    dict_add(global_env, "set_len",    op_set_len());
+    dict_add(global_env, "set_from",   op_set_from());
+    dict_add(global_env, "set_list",   op_set_list());
+    dict_add(global_env, "union",      op_set_union());
+    dict_add(global_env, "intersect",  op_set_intersect());
+    dict_add(global_env, "difference", op_set_difference());
+    /* Priority queues */
+    dict_add(global_env, "pq_new",  op_pq_new());
+    dict_add(global_env, "pq_push", op_pq_push());
+    dict_add(global_env, "pq_pop",  op_pq_pop());
+    dict_add(global_env, "pq_peek", op_pq_peek());
+    dict_add(global_env, "pq_len",  op_pq_len());
+    /* Lazy sequences */
+    dict_add(global_env, "range",     op_range());
+    dict_add(global_env, "generator", op_generator());
+    dict_add(global_env, "to_list",   op_to_list());
+    /* Strings */
+    dict_add(global_env, "concat",  op_concat());
+    dict_add(global_env, "substr",  op_substr());
+    dict_add(global_env, "str_len", op_str_len());
+    dict_add(global_env, "split",   op_split());
+    dict_add(global_env, "join",    op_join());
+    dict_add(global_env, "find",    op_find());
+    dict_add(global_env, "sb_new",  op_sb_new());
+    dict_add(global_env, "sb_add",  op_sb_add());
+    dict_add(global_env, "sb_str",  op_sb_str());
+    dict_add(global_env, "sb_len",  op_sb_len());
+    /* F64 arrays */
+    dict_add(global_env, "f64array",  op_f64array());
+    dict_add(global_env, "f64_range", op_f64_range());
+    dict_add(global_env, "f64_get",   op_f64_get());
+    dict_add(global_env, "f64_len",   op_f64_len());
+    dict_add(global_env, "f64_list",  op_f64_list());
+    dict_add(global_env, "sum",       op_sum());
+    dict_add(global_env, "dot",       op_dot());
+    dict_add(global_env, "min",       op_min());
+    dict_add(global_env, "max",       op_max());
+    /* Matrices */
+    dict_add(global_env, "matrix",    op_matrix());
+    dict_add(global_env, "mat_get",   op_mat_get());
+    dict_add(global_env, "mat_rows",  op_mat_rows());
+    dict_add(global_env, "mat_cols",  op_mat_cols());
+    dict_add(global_env, "mat_list",  op_mat_list());
+    dict_add(global_env, "matmul",    op_matmul());
+    dict_add(global_env, "transpose", op_transpose());
+    dict_add(global_env, "solve",     op_solve());
+    /* Tasks */
+    dict_add(global_env, "spawn", op_spawn());
+    dict_add(global_env, "await", op_await());
+
+    // Let operators know their names, the keys live as long as the environment
+    dict_t* d = global_env->val.dict;
+    for (int i = 0; i < d->len; ++i)
+        if (d->vals[i]->type == STD_OP)
+            d->vals[i]->val.oper->name = d->keys[i];
 }
 
 /* Deallocate global environment. */
-void globenv_del() {
-    if (!global_env) {
+void globenv_del(alisp_ctx* ctx) {
+    if (!ctx->global_env) {
         printf("\x1b[95m" "Fatal error: globenv_del: global environment doesn't exist!\n" "\x1b[0m");
         exit(EXIT_FAILURE);
     }
@@ -111,6 +198,8 @@ void globenv_del() {
 printf("....  globenv_del:             Deallocating global environment\n");
 #endif
 
-    atom_del(global_env);
+    ctx->active_env = ctx->global_env;
+    atom_del(ctx->global_env);
+    ctx->global_env = ctx->active_env = NULL;
 }
 
@@ -0,0 +1,395 @@
+/*
+Hash map: a collection of values by keys that are numbers or strings.
+
+Entries are kept in dense arrays of keys and values, in order of insertion until some
+are removed, and are found through a table of slots with open addressing and linear
+probing, kept at most half full.  A slot holds the number of an entry plus one, or 0
+if it is free.  Removing an entry moves the last entry into its place and shifts the
+rest of its probe run back, so there are no tombstones to slow lookups down.
+
+Keys are copies owned by the map, values are bound to it like items of a list.
+
+A set is a hash map of keys only, of type SET, with the nil object for every value.
+Operations on two sets go through the smaller one and look its keys up in the other by
+the hashes already stored.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "alisp.h"
+
+/* Hash of a key, numbers and strings hash apart. */
+static unsigned hm_hash(atom_t* key) {
+    uint64_t h;
+    if (key->type == NUMBER) {
+        double d = *key->val.num;
+        if (d == 0)
+            d = 0;  // -0 is the same key as 0
+        memcpy(&h, &d, sizeof(h));
+    } else if (key->type == STRING) {
+        h = ~(uint64_t)str_hash(key);  // cached by the string
+    } else {
+        h = 0xCBF29CE484222325ULL;  // FNV-1a
+        for (const unsigned char* s = (const unsigned char*)key->val.sym; *s; ++s)
+            h = (h ^ *s) * 0x100000001B3ULL;
+        h = ~h;
+    }
+    h ^= h >> 33;  // finalizer of MurmurHash3, every bit matters for the slot
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return (unsigned)h;
+}
+
+/* Are keys equal? */
+static int hm_eq(atom_t* a, atom_t* b) {
+    if (a->type != b->type)
+        return 0;
+    if (a->type == NUMBER)
+        return *a->val.num == *b->val.num;
+    return a->type == STRING ? str_eq(a, b) : streq(a->val.sym, b->val.sym);
+}
+
+/* Copy a key. */
+static atom_t* key_copy(atom_t* key) {
+    if (key->type == STRING)
+        return str_copy(key);
+    return key->type == NUMBER ? num(*key->val.num) : sym(key->val.sym);
+}
+
+/* Return the slot of a key, or the free slot where it would go. */
+static int hm_find(hashmap_t* m, atom_t* key, unsigned h) {
+    int mask = m->nslots - 1;
+    int i = h & mask;
+    for (; m->slots[i]; i = (i + 1) & mask) {
+        int e = m->slots[i] - 1;
+        if (m->hashes[e] == h && hm_eq(m->keys[e], key))
+            break;
+    }
+    return i;
+}
+
+/* Make a table of n slots for the entries. */
+static void hm_rehash(hashmap_t* m, int n) {
+    safe_free(m->slots);
+    m->slots = calloc(n, sizeof(int));
+    m->nslots = n;
+    for (int e = 0; e < m->len; ++e) {
+        int i = m->hashes[e] & (n - 1);
+        while (m->slots[i])
+            i = (i + 1) & (n - 1);
+        m->slots[i] = e + 1;
+    }
+}
+
+/*
+--------------------------------------
+hm_new
+
+    Make a hash map with room for n entries.
+--------------------------------------
+*/
+atom_t* hm_new(int n) {
+    hashmap_t* m = malloc(sizeof(hashmap_t));
+    m->bindlist = NULL;
+    m->lock = 0;
+    m->len = 0;
+    m->maxlen = n > 4 ? n : 4;
+    m->keys = malloc(m->maxlen * sizeof(atom_t*));
+    m->vals = malloc(m->maxlen * sizeof(atom_t*));
+    m->hashes = malloc(m->maxlen * sizeof(unsigned));
+    m->slots = NULL;
+    int slots;
+    for (slots = 8; slots < 2 * m->maxlen; slots <<= 1);
+    hm_rehash(m, slots);
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.hm = m;
+    obj->type = HASHMAP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/*
+--------------------------------------
+hm_del
+
+    Deallocate a hash map.
+--------------------------------------
+*/
+void hm_del(atom_t* obj) {
+    hashmap_t* m = obj->val.hm;
+    m->lock = 1;  // lock this object
+
+    // Deallocate keys and bound values
+    for (int e = 0; e < m->len; ++e) {
+        atom_del(m->keys[e]);
+        atom_t* val = m->vals[e];
+        if (!(atom_is_container(val) && val->val.list->lock)) {
+            atom_unbind(val, obj);
+            atom_del(val);
+        }
+    }
+
+    safe_free(m->keys);
+    safe_free(m->vals);
+    safe_free(m->hashes);
+    safe_free(m->slots);
+    list_free(m->bindlist);
+    safe_free(m);
+    safe_free(obj);
+}
+
+/* Can an object be a key? */
+int hm_iskey(atom_t* key) {
+    return key->type == NUMBER || key->type == STRING || key->type == SYMBOL;
+}
+
+/* Return the value of a key, or NULL. */
+atom_t* hm_get(atom_t* obj, atom_t* key) {
+    hashmap_t* m = obj->val.hm;
+    int i = hm_find(m, key, hm_hash(key));
+    return m->slots[i] ? m->vals[m->slots[i] - 1] : NULL;
+}
+
+/* Associate a value with a key of a known hash. */
+static void hm_put(atom_t* obj, atom_t* key, unsigned h, atom_t* val) {
+    hashmap_t* m = obj->val.hm;
+    int i = hm_find(m, key, h);
+
+    // Replace the value of a key
+    if (m->slots[i]) {
+        int e = m->slots[i] - 1;
+        atom_t* old = m->vals[e];
+        if (old != val) {
+            m->vals[e] = val;
+            atom_bind(val, obj);
+            atom_unbind(old, obj);
+            atom_del(old);
+        }
+        return;
+    }
+
+    // Add an entry, allocating more space if necessary
+    if (m->len == m->maxlen) {
+        m->maxlen *= 2;
+        m->keys = realloc(m->keys, m->maxlen * sizeof(atom_t*));
+        m->vals = realloc(m->vals, m->maxlen * sizeof(atom_t*));
+        m->hashes = realloc(m->hashes, m->maxlen * sizeof(unsigned));
+    }
+    if (2 * (m->len + 1) > m->nslots) {
+        hm_rehash(m, 2 * m->nslots);
+        i = hm_find(m, key, h);
+    }
+    int e = m->len++;
+    m->keys[e] = key_copy(key);
+    m->vals[e] = val;
+    m->hashes[e] = h;
+    m->slots[i] = e + 1;
+    atom_bind(val, obj);
+}
+
+/* Remove a key of a known hash and its value. Return 0 if there is no such key. */
+static int hm_drop(atom_t* obj, atom_t* key, unsigned h) {
+    hashmap_t* m = obj->val.hm;
+    int mask = m->nslots - 1;
+    int i = hm_find(m, key, h);
+    if (!m->slots[i])
+        return 0;
+    int e = m->slots[i] - 1;
+    atom_t* val = m->vals[e];
+    atom_del(m->keys[e]);
+
+    // Shift back the slots of the probe run that may not stay behind the free one
+    for (int j = (i + 1) & mask; m->slots[j]; j = (j + 1) & mask) {
+        int home = m->hashes[m->slots[j] - 1] & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            m->slots[i] = m->slots[j];
+            i = j;
+        }
+    }
+    m->slots[i] = 0;
+
+    // Move the last entry into the hole
+    int last = --m->len;
+    if (e != last) {
+        m->keys[e] = m->keys[last];
+        m->vals[e] = m->vals[last];
+        m->hashes[e] = m->hashes[last];
+        for (i = m->hashes[e] & mask; m->slots[i] != last + 1; i = (i + 1) & mask);
+        m->slots[i] = e + 1;
+    }
+
+    atom_unbind(val, obj);
+    atom_del(val);
+    return 1;
+}
+
+/* Associate a value with a key. */
+void hm_set(atom_t* obj, atom_t* key, atom_t* val) {
+    hm_put(obj, key, hm_hash(key), val);
+}
+
+/* Remove a key and its value. Return 0 if there is no such key. */
+int hm_remove(atom_t* obj, atom_t* key) {
+    return hm_drop(obj, key, hm_hash(key));
+}
+
+/* Return the number of entries. */
+int hm_len(atom_t* obj) {
+    return obj->val.hm->len;
+}
+
+/* Return the list of keys. */
+atom_t* hm_keys(atom_t* obj) {
+    hashmap_t* m = obj->val.hm;
+    atom_t* lst = list();
+    list_reserve(lst, m->len);
+    for (int e = 0; e < m->len; ++e) {
+        list_add(lst, key_copy(m->keys[e]));
+    }
+    return lst;
+}
+
+/*
+--------------------------------------
+hm_tostr
+
+    Make a string representing a hash map or a set.
+--------------------------------------
+*/
+char* hm_tostr(atom_t* obj, int depth) {
+    hashmap_t* m = obj->val.hm;
+    char* k;
+    char* o;
+    char buf[1024];
+    int set = obj->type == SET;
+    strcpy(buf, set ? "#{" : "{");
+
+    for (int e = 0; e < m->len; ++e) {
+        k = atom_tostring(m->keys[e], 1);
+        o = set ? strdup("") : atom_tostring(m->vals[e], depth ? depth - 1 : depth);
+        if (strlen(buf) + strlen(k) + strlen(o) > 1000) {
+            safe_free(k);
+            safe_free(o);
+            strcat(buf, " ... ");
+            break;
+        }
+        strcat(buf, k);
+        if (!set) {
+            strcat(buf, " : ");
+            strcat(buf, o);
+        }
+        safe_free(k);
+        safe_free(o);
+        if (e < m->len - 1)
+            strcat(buf, ", ");
+    }
+
+    strcat(buf, "}");
+    o = malloc(strlen(buf) + 1);
+    strcpy(o, buf);
+    return o;
+}
+
+
+// ----------------------------------------------------------------------
+// Sets
+
+/* Make a set with room for n keys. */
+atom_t* set_new(int n) {
+    atom_t* obj = hm_new(n);
+    obj->type = SET;
+    return obj;
+}
+
+/* Add a key to a set. */
+void set_add(atom_t* obj, atom_t* key) {
+    hm_put(obj, key, hm_hash(key), &nilobj);
+}
+
+/* Is a key in a set? */
+int set_has(atom_t* obj, atom_t* key) {
+    return hm_get(obj, key) != NULL;
+}
+
+/*
+--------------------------------------
+set_copy
+
+    Copy a set, table and all, without hashing the keys again.
+--------------------------------------
+*/
+atom_t* set_copy(atom_t* obj) {
+    hashmap_t* m = obj->val.hm;
+    atom_t* copy = set_new(m->len);
+    hashmap_t* c = copy->val.hm;
+    hm_rehash(c, m->nslots);
+    memcpy(c->slots, m->slots, m->nslots * sizeof(int));
+    memcpy(c->hashes, m->hashes, m->len * sizeof(unsigned));
+    for (int e = 0; e < m->len; ++e) {
+        c->keys[e] = key_copy(m->keys[e]);
+        c->vals[e] = &nilobj;
+    }
+    c->len = m->len;
+    return copy;
+}
+
+/* Union of two sets: a copy of the larger one with the keys of the smaller one. */
+atom_t* set_union(atom_t* a, atom_t* b) {
+    if (hm_len(a) < hm_len(b)) {
+        atom_t* t = a;
+        a = b;
+        b = t;
+    }
+    atom_t* r = set_copy(a);
+    hashmap_t* m = b->val.hm;
+    for (int e = 0; e < m->len; ++e)
+        hm_put(r, m->keys[e], m->hashes[e], &nilobj);
+    return r;
+}
+
+/* Intersection of two sets: the keys of the smaller one found in the larger one. */
+atom_t* set_intersect(atom_t* a, atom_t* b) {
+    if (hm_len(a) > hm_len(b)) {
+        atom_t* t = a;
+        a = b;
+        b = t;
+    }
+    atom_t* r = set_new(0);
+    hashmap_t* m = a->val.hm;
+    hashmap_t* other = b->val.hm;
+    for (int e = 0; e < m->len; ++e)
+        if (other->slots[hm_find(other, m->keys[e], m->hashes[e])])
+            hm_put(r, m->keys[e], m->hashes[e], &nilobj);
+    return r;
+}
+
+/*
+--------------------------------------
+set_difference
+
+    Keys of a that are not in b.  If a is smaller, its keys are looked up in b,
+    otherwise the keys of b are removed from a copy of a.
+--------------------------------------
+*/
+atom_t* set_difference(atom_t* a, atom_t* b) {
+    hashmap_t* m;
+    atom_t* r;
+    if (hm_len(a) <= hm_len(b)) {
+        r = set_new(0);
+        m = a->val.hm;
+        hashmap_t* other = b->val.hm;
+        for (int e = 0; e < m->len; ++e)
+            if (!other->slots[hm_find(other, m->keys[e], m->hashes[e])])
+                hm_put(r, m->keys[e], m->hashes[e], &nilobj);
+    } else {
+        r = set_copy(a);
+        m = b->val.hm;
+        for (int e = 0; e < m->len; ++e)
+            hm_drop(r, m->keys[e], m->hashes[e]);
+    }
+    return r;
+}
@@ -0,0 +1,894 @@
+/*
+Heap image.
+Snapshot of everything reachable from the global environment: values, closures, their
+environments and shared structure.  Image is relocatable: objects refer to each other
+by number, not by address.  Loading an image maps the file and rebuilds the objects
+in the global environment, which is much cheaper than evaluating the source again.
+
+Standard operators are saved by name and resolved against the fresh global
+environment when the image is loaded.
+
+File layout (native byte order):
+    header      magic "ALI", format version, byte order mark, number of objects
+    objects     records numbered from 1, object 1 is the global environment.
+                Images of values passed between contexts have the list of values as
+                object 2, and may have the global environment empty.  Futures are
+                not written, references to them are NULL.
+                Reference 0 stands for NULL object, IMG_NONE for no object.
+                    'N' f64                                 number
+                    'S' u32 len, bytes                      symbol
+                    'C' u32 len, bytes                      string
+                    'B' u32 len, bytes                      string builder
+                    'L' u32 n, n x u32 ref                  list
+                    'D' u32 parent, u32 n, n x (u32 len, key bytes, u32 ref)
+                                                            dictionary
+                    'F' u32 params, u32 body, u32 env       function
+                    'O' u32 len, bytes                      standard operator
+                    'V' u32 n, n x u32 ref                  vector
+                    'H' u32 n, n x (u32 key, u32 value)     hash map
+                    'T' u32 n, n x u32 key                  set
+                    'Q' u32 proc, u32 n, n x (f64 priority, u32 item)
+                                                            priority queue, heap order
+                    'A' u32 n, n x f64                      f64 array
+                    'M' u32 rows, u32 cols, rows*cols x f64 matrix
+                    'R' f64 start, f64 step, u32 len        range
+                    'G' u32 proc, u32 init                  generator
+                    'P' address                             frozen object
+                Images in memory refer to frozen objects by address instead of copying
+                them, frozen objects are immutable and live as long as the process.
+                Image files never have 'P' records.  Items of vectors that are lists,
+                dictionaries, hash maps, sets, arrays, matrices or ranges are
+                frozen when they are loaded.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "alisp.h"
+
+#define IMG_MAGIC   "ALI"
+#define IMG_BOM     0x01020304u
+#define IMG_NONE    0xFFFFFFFFu
+
+/* Image header */
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint32_t bom;
+    uint32_t count;
+} img_header_t;
+
+
+// ----------------------------------------------------------------------
+// Save
+
+/* Writer state */
+typedef struct {
+    buf_t      buf;
+    ptrmap_t*  ids;     // object -> number
+    atom_t**   queue;   // objects in order of numbering
+    uint32_t   len;
+    uint32_t   max;
+    int        pointers;  // write frozen objects by address
+} writer_t;
+
+static void put32(writer_t* w, uint32_t x) {
+    buf_put(&w->buf, &x, sizeof(x));
+}
+
+static void putbytes(writer_t* w, const char* s, size_t len) {
+    put32(w, len);
+    buf_put(&w->buf, s, len);
+}
+
+static void putstr(writer_t* w, const char* s) {
+    putbytes(w, s, strlen(s));
+}
+
+/* Return the number of an object, queueing it for writing if it is new. */
+static uint32_t ref(writer_t* w, atom_t* obj) {
+    if (!obj)
+        return IMG_NONE;
+    if (obj->type == NIL || obj->type == FUTURE)
+        return 0;  // futures belong to their context, they are written as NULL
+    uint32_t id = (uint32_t)(uintptr_t)ptrmap_get(w->ids, obj);
+    if (id)
+        return id;
+    if (w->len == w->max) {
+        w->max *= 2;
+        w->queue = realloc(w->queue, w->max * sizeof(atom_t*));
+    }
+    w->queue[w->len++] = obj;
+    ptrmap_put(w->ids, obj, (void*)(uintptr_t)w->len);
+    return w->len;
+}
+
+/*
+--------------------------------------
+image_write
+
+    Append image of the global environment to a buffer, and of a list of values as
+    object 2 if given.  Without globals the global environment is written empty, as a
+    placeholder for the global environment of the reader.  With pointers frozen
+    objects are written by address, for images read in the same process.  Return 1
+    on success.
+--------------------------------------
+*/
+static int image_write(alisp_ctx* ctx, atom_t* values, int globals, int pointers,
+                       buf_t* out) {
+    writer_t w = {{NULL, 0, 0}, ptrmap_new(1024), malloc(1024 * sizeof(atom_t*)), 0, 1024,
+                  pointers};
+    img_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, IMG_MAGIC, 4);
+    h.version = IMG_VERSION;
+    h.bom = IMG_BOM;
+    buf_put(&w.buf, &h, sizeof(h));
+
+    int ok = 1;
+    ref(&w, ctx->global_env);
+    if (values)
+        ref(&w, values);
+
+    // Objects are numbered as they are discovered, and written in that order
+    for (uint32_t i = 0; ok && i < w.len; ++i) {
+        atom_t* obj = w.queue[i];
+        if (w.pointers && (obj->flags & F_FROZEN)) {
+            buf_put(&w.buf, "P", 1);
+            buf_put(&w.buf, &obj, sizeof(atom_t*));
+            continue;
+        }
+        switch (obj->type) {
+
+        case NUMBER:
+            buf_put(&w.buf, "N", 1);
+            buf_put(&w.buf, obj->val.num, sizeof(double));
+            break;
+
+        case SYMBOL:
+            buf_put(&w.buf, "S", 1);
+            putstr(&w, obj->val.sym);
+            break;
+
+        case STRING:
+            buf_put(&w.buf, "C", 1);
+            putbytes(&w, str_data(obj), str_len(obj));
+            break;
+
+        case BUILDER:
+            buf_put(&w.buf, "B", 1);
+            putbytes(&w, obj->val.buf->data, sb_len(obj));
+            break;
+
+        case LIST: {
+            list_t* l = obj->val.list;
+            buf_put(&w.buf, "L", 1);
+            put32(&w, l->len);
+            for (int j = 0; j < l->len; ++j)
+                put32(&w, ref(&w, l->items[j]));
+            break;
+        }
+
+        case VECTOR: {
+            int n = vec_len(obj);
+            buf_put(&w.buf, "V", 1);
+            put32(&w, n);
+            for (int j = 0; j < n; ++j)
+                put32(&w, ref(&w, vec_item(obj, j)));
+            break;
+        }
+
+        case HASHMAP: {
+            hashmap_t* m = obj->val.hm;
+            buf_put(&w.buf, "H", 1);
+            put32(&w, m->len);
+            for (int j = 0; j < m->len; ++j) {
+                put32(&w, ref(&w, m->keys[j]));
+                put32(&w, ref(&w, m->vals[j]));
+            }
+            break;
+        }
+
+        case F64ARRAY:
+            buf_put(&w.buf, "A", 1);
+            put32(&w, f64_len(obj));
+            buf_put(&w.buf, f64_data(obj), f64_len(obj) * sizeof(double));
+            break;
+
+        case MATRIX:
+            buf_put(&w.buf, "M", 1);
+            put32(&w, mat_rows(obj));
+            put32(&w, mat_cols(obj));
+            buf_put(&w.buf, f64_data(obj), f64_len(obj) * sizeof(double));
+            break;
+
+        case PQUEUE: {
+            int n = pq_len(obj);
+            buf_put(&w.buf, "Q", 1);
+            put32(&w, ref(&w, pq_proc(obj)));
+            put32(&w, n);
+            for (int j = 0; j < n; ++j) {
+                double prio = pq_prio(obj, j);
+                buf_put(&w.buf, &prio, sizeof(double));
+                put32(&w, ref(&w, pq_item(obj, j)));
+            }
+            break;
+        }
+
+        case RANGE: {
+            double start = range_item(obj, 0), step = range_step(obj);
+            buf_put(&w.buf, "R", 1);
+            buf_put(&w.buf, &start, sizeof(double));
+            buf_put(&w.buf, &step, sizeof(double));
+            put32(&w, range_len(obj));
+            break;
+        }
+
+        case GENERATOR:
+            buf_put(&w.buf, "G", 1);
+            put32(&w, ref(&w, gen_proc(obj)));
+            put32(&w, ref(&w, gen_init(obj)));
+            break;
+
+        case SET: {
+            hashmap_t* m = obj->val.hm;
+            buf_put(&w.buf, "T", 1);
+            put32(&w, m->len);
+            for (int j = 0; j < m->len; ++j)
+                put32(&w, ref(&w, m->keys[j]));
+            break;
+        }
+
+        case DICTIONARY: {
+            dict_t* d = obj->val.dict;
+            int len = globals || obj != ctx->global_env ? d->len : 0;
+            buf_put(&w.buf, "D", 1);
+            put32(&w, ref(&w, d->parent));
+            put32(&w, len);
+            for (int j = 0; j < len; ++j) {
+                putstr(&w, d->keys[j]);
+                put32(&w, ref(&w, d->vals[j]));
+            }
+            break;
+        }
+
+        case FUNCTION: {
+            function_t* f = obj->val.func;
+            buf_put(&w.buf, "F", 1);
+            put32(&w, ref(&w, f->params));
+            put32(&w, ref(&w, f->body));
+            put32(&w, ref(&w, f->env));
+            break;
+        }
+
+        case STD_OP:
+            if (!obj->val.oper->name) {
+                errmsg("Image", "operator has no name", NULL, NULL);
+                ok = 0;
+                break;
+            }
+            buf_put(&w.buf, "O", 1);
+            putstr(&w, obj->val.oper->name);
+            break;
+
+        default:
+            errmsg("Image", "unrecognized object type", NULL, NULL);
+            ok = 0;
+        }
+    }
+
+    if (ok) {
+        ((img_header_t*)w.buf.data)->count = w.len;
+        buf_put(out, w.buf.data, w.buf.len);
+    }
+
+    safe_free(w.buf.data);
+    safe_free(w.queue);
+    ptrmap_del(w.ids);
+    return ok;
+}
+
+/* Append image of the global environment to a buffer. Return 1 on success. */
+int image_dump(alisp_ctx* ctx, buf_t* out) {
+    return image_write(ctx, NULL, 1, 1, out);
+}
+
+/* Append image of a list of values, with or without the global environment. */
+int image_dump_values(alisp_ctx* ctx, atom_t* values, int globals, buf_t* out) {
+    return image_write(ctx, values, globals, 1, out);
+}
+
+/* Write image of the global environment to a file. Return 1 on success. */
+int image_save(alisp_ctx* ctx, const char* filename) {
+    buf_t b = {NULL, 0, 0};
+    int ok = image_write(ctx, NULL, 1, 0, &b);
+    if (ok) {
+        FILE* f = fopen(filename, "wb");
+        if (!f) {
+            errmsg("Image", "failed to open file", NULL, NULL);
+            ok = 0;
+        } else {
+            ok = fwrite(b.data, 1, b.len, f) == b.len;
+            ok = !fclose(f) && ok;
+            if (!ok)
+                errmsg("Image", "failed to write file", NULL, NULL);
+        }
+    }
+    safe_free(b.data);
+    return ok;
+}
+
+
+// ----------------------------------------------------------------------
+// Load
+
+/* Reader state */
+typedef struct {
+    atom_t*     global_env;
+    const char* data;
+    const char* end;
+    uint32_t    count;
+    const char** recs;  // record of every object, 1-based
+    atom_t**    objs;   // rebuilt objects, 1-based
+    int         pointers;  // accept frozen objects by address
+} reader_t;
+
+static int get32(const char** p, const char* end, uint32_t* x) {
+    if (end - *p < (long)sizeof(uint32_t))
+        return 0;
+    memcpy(x, *p, sizeof(uint32_t));
+    *p += sizeof(uint32_t);
+    return 1;
+}
+
+static int getstr(const char** p, const char* end, const char** s, uint32_t* len) {
+    if (!get32(p, end, len) || (uint32_t)(end - *p) < *len)
+        return 0;
+    *s = *p;
+    *p += *len;
+    return 1;
+}
+
+/* Type of a referenced object, NIL for reference 0, -1 for a bad reference. */
+static int reftype(reader_t* r, uint32_t ref) {
+    if (ref == 0)
+        return NIL;
+    if (ref > r->count)
+        return -1;
+    switch (*r->recs[ref]) {
+    case 'N': return NUMBER;
+    case 'S': return SYMBOL;
+    case 'C': return STRING;
+    case 'B': return BUILDER;
+    case 'L': return LIST;
+    case 'D': return DICTIONARY;
+    case 'F': return FUNCTION;
+    case 'O': return STD_OP;
+    case 'V': return VECTOR;
+    case 'H': return HASHMAP;
+    case 'T': return SET;
+    case 'Q': return PQUEUE;
+    case 'A': return F64ARRAY;
+    case 'M': return MATRIX;
+    case 'R': return RANGE;
+    case 'G': return GENERATOR;
+    case 'P': {
+        atom_t* obj;
+        memcpy(&obj, r->recs[ref] + 1, sizeof(atom_t*));
+        return obj->type;
+    }
+    default:  return -1;
+    }
+}
+
+/* Find record boundaries. Return 0 if data is malformed. */
+static int image_scan(reader_t* r) {
+    const char* p = r->data;
+    const char* s;
+    uint32_t n, len, x;
+
+    for (uint32_t i = 1; i <= r->count; ++i) {
+        if (p >= r->end)
+            return 0;
+        r->recs[i] = p;
+        switch (*p++) {
+        case 'N':
+            if (r->end - p < (long)sizeof(double))
+                return 0;
+            p += sizeof(double);
+            break;
+        case 'S':
+        case 'O':
+            if (!getstr(&p, r->end, &s, &len) || len == 0)
+                return 0;
+            break;
+        case 'C':
+        case 'B':
+            if (!getstr(&p, r->end, &s, &len) || len > STR_MAX_LEN)
+                return 0;
+            break;
+        case 'L':
+        case 'V':
+        case 'T':
+            if (!get32(&p, r->end, &n) || (uint64_t)(r->end - p) < (uint64_t)n * 4)
+                return 0;
+            p += (size_t)n * 4;
+            break;
+        case 'H':
+        case 'A':
+            if (!get32(&p, r->end, &n) || (uint64_t)(r->end - p) < (uint64_t)n * 8 ||
+                (r->recs[i][0] == 'A' && n > F64_MAX_LEN))
+                return 0;
+            p += (size_t)n * 8;
+            break;
+        case 'Q':
+            if (!get32(&p, r->end, &x) || !get32(&p, r->end, &n) ||
+                (uint64_t)(r->end - p) < (uint64_t)n * 12)
+                return 0;
+            p += (size_t)n * 12;
+            break;
+        case 'M':
+            if (!get32(&p, r->end, &x) || !get32(&p, r->end, &n) ||
+                (uint64_t)x * n > F64_MAX_LEN || (uint64_t)(r->end - p) < (uint64_t)x * n * 8)
+                return 0;
+            p += (size_t)x * n * 8;
+            break;
+        case 'D':
+            if (!get32(&p, r->end, &x) || !get32(&p, r->end, &n))
+                return 0;
+            for (uint32_t j = 0; j < n; ++j)
+                if (!getstr(&p, r->end, &s, &len) || len == 0 || !get32(&p, r->end, &x))
+                    return 0;
+            break;
+        case 'F':
+            if (r->end - p < 12)
+                return 0;
+            p += 12;
+            break;
+        case 'R':
+            if (r->end - p < 20)
+                return 0;
+            p += 16;
+            get32(&p, r->end, &n);
+            if (n > INT_MAX)
+                return 0;
+            break;
+        case 'G':
+            if (r->end - p < 8)
+                return 0;
+            p += 8;
+            break;
+        case 'P':
+            if (!r->pointers || r->end - p < (long)sizeof(atom_t*))
+                return 0;
+            p += sizeof(atom_t*);
+            break;
+        default:
+            return 0;
+        }
+    }
+    return p == r->end;
+}
+
+/* Check references between objects. Return 0 if something is wrong. */
+static int image_check(reader_t* r) {
+    const char* p;
+    const char* s;
+    uint32_t n, len, x, y, z;
+
+    if (reftype(r, 1) != DICTIONARY)
+        return 0;
+
+    for (uint32_t i = 1; i <= r->count; ++i) {
+        p = r->recs[i] + 1;
+        switch (r->recs[i][0]) {
+        case 'L':
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&p, r->end, &x);
+                if (reftype(r, x) < 0)
+                    return 0;
+            }
+            break;
+        case 'V':
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&p, r->end, &x);
+                y = reftype(r, x);
+                if (y != NIL && y != NUMBER && y != SYMBOL && y != STRING && y != VECTOR &&
+                    y != LIST && y != DICTIONARY && y != HASHMAP && y != SET &&
+                    y != F64ARRAY && y != MATRIX && y != RANGE)
+                    return 0;
+            }
+            break;
+        case 'T':
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&p, r->end, &x);
+                y = reftype(r, x);
+                if (y != NUMBER && y != STRING && y != SYMBOL)
+                    return 0;
+            }
+            break;
+        case 'H':
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&p, r->end, &x);
+                get32(&p, r->end, &y);
+                z = reftype(r, x);
+                if ((z != NUMBER && z != STRING && z != SYMBOL) || reftype(r, y) < 0)
+                    return 0;
+            }
+            break;
+        case 'Q':
+            get32(&p, r->end, &x);
+            if (x != IMG_NONE && reftype(r, x) != FUNCTION && reftype(r, x) != STD_OP)
+                return 0;
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                p += sizeof(double);
+                get32(&p, r->end, &x);
+                if (reftype(r, x) < 0)
+                    return 0;
+            }
+            break;
+        case 'G':
+            get32(&p, r->end, &x);
+            get32(&p, r->end, &y);
+            if ((reftype(r, x) != FUNCTION && reftype(r, x) != STD_OP) || reftype(r, y) < 0)
+                return 0;
+            break;
+        case 'D':
+            get32(&p, r->end, &x);
+            if (i == 1 ? x != IMG_NONE : reftype(r, x) != DICTIONARY)
+                return 0;  // only the global environment has no parent
+            // Chain of parents must end in the global environment
+            for (y = 0; x != 1 && x != IMG_NONE && y < r->count; ++y) {
+                if (reftype(r, x) != DICTIONARY)
+                    return 0;
+                s = r->recs[x] + 1;
+                get32(&s, r->end, &x);
+            }
+            if (i != 1 && x != 1)
+                return 0;
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                getstr(&p, r->end, &s, &len);
+                get32(&p, r->end, &x);
+                if (reftype(r, x) < 0)
+                    return 0;
+            }
+            break;
+        case 'F':
+            get32(&p, r->end, &x);
+            get32(&p, r->end, &y);
+            get32(&p, r->end, &z);
+            if (reftype(r, x) != LIST || reftype(r, y) != LIST || reftype(r, z) != DICTIONARY)
+                return 0;
+            // Parameters must be symbols
+            s = r->recs[x] + 1;
+            get32(&s, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&s, r->end, &y);
+                if (reftype(r, y) != SYMBOL)
+                    return 0;
+            }
+            break;
+        case 'O': {
+            getstr(&p, r->end, &s, &len);
+            char* name = strndup(s, len);
+            atom_t* op = dict_get(r->global_env, name);
+            safe_free(name);
+            if (!op || op->type != STD_OP)
+                return 0;  // operator is unknown to this interpreter
+            break;
+        }
+        }
+    }
+    return 1;
+}
+
+/* Rebuild objects of a checked image. */
+static void image_build(reader_t* r) {
+    const char* p;
+    const char* s;
+    uint32_t n, len, x, y, z;
+    char* str;
+
+    // Make objects, containers are left empty
+    r->objs[0] = &nilobj;
+    r->objs[1] = r->global_env;
+    for (uint32_t i = 2; i <= r->count; ++i) {
+        p = r->recs[i] + 1;
+        switch (r->recs[i][0]) {
+        case 'N': {
+            double d;
+            memcpy(&d, p, sizeof(double));
+            r->objs[i] = num(d);
+            break;
+        }
+        case 'S':
+        case 'O':
+            getstr(&p, r->end, &s, &len);
+            str = strndup(s, len);
+            r->objs[i] = r->recs[i][0] == 'S' ? sym(str) : dict_get(r->global_env, str);
+            safe_free(str);
+            break;
+        case 'C':
+            getstr(&p, r->end, &s, &len);
+            r->objs[i] = str_new(s, len);
+            break;
+        case 'B':
+            getstr(&p, r->end, &s, &len);
+            r->objs[i] = sb_new();
+            if (len)
+                buf_put(r->objs[i]->val.buf, s, len);
+            break;
+        case 'L':
+            r->objs[i] = list();
+            break;
+        case 'V':
+            r->objs[i] = vec_new(NULL, 0);
+            break;
+        case 'H':
+            get32(&p, r->end, &n);
+            r->objs[i] = hm_new(n);
+            break;
+        case 'T':
+            get32(&p, r->end, &n);
+            r->objs[i] = set_new(n);
+            break;
+        case 'Q':
+            r->objs[i] = pq_new(NULL);
+            break;
+        case 'A':
+            get32(&p, r->end, &n);
+            r->objs[i] = f64_new(n);
+            memcpy(f64_data(r->objs[i]), p, (size_t)n * sizeof(double));
+            break;
+        case 'M':
+            get32(&p, r->end, &x);
+            get32(&p, r->end, &n);
+            r->objs[i] = mat_new(x, n);
+            memcpy(f64_data(r->objs[i]), p, (size_t)x * n * sizeof(double));
+            break;
+        case 'R': {
+            double start, step;
+            memcpy(&start, p, sizeof(double));
+            memcpy(&step, p + sizeof(double), sizeof(double));
+            p += 2 * sizeof(double);
+            get32(&p, r->end, &n);
+            r->objs[i] = range_make(start, step, n);
+            break;
+        }
+        case 'G':
+            r->objs[i] = gen_new(NULL, NULL);
+            break;
+        case 'D':
+            get32(&p, r->end, &x);
+            get32(&p, r->end, &n);
+            r->objs[i] = dict(n, NULL);
+            break;
+        case 'F': {
+            function_t* f = malloc(sizeof(function_t));
+            f->bindlist = NULL;
+            f->lock = 0;
+            f->params = f->body = f->env = NULL;
+            atom_t* obj = malloc(sizeof(atom_t));
+            obj->val.func = f;
+            obj->type = FUNCTION;
+            obj->flags = 0;
+            obj->bindings = 0;
+            r->objs[i] = obj;
+            break;
+        }
+        case 'P':
+            memcpy(&r->objs[i], p, sizeof(atom_t*));
+            break;
+        }
+    }
+
+    // Link environments and protect operators while the global environment is filled
+    for (uint32_t i = 2; i <= r->count; ++i) {
+        p = r->recs[i] + 1;
+        if (r->recs[i][0] == 'D') {
+            get32(&p, r->end, &x);
+            r->objs[i]->val.dict->parent = r->objs[x];
+        } else if (r->recs[i][0] == 'O')
+            atom_bind(r->objs[i], r->global_env);
+    }
+
+    // Fill containers, binding their contents the usual way
+    for (uint32_t i = 1; i <= r->count; ++i) {
+        atom_t* obj = r->objs[i];
+        p = r->recs[i] + 1;
+        switch (r->recs[i][0]) {
+        case 'L':
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&p, r->end, &x);
+                list_add(obj, r->objs[x]);
+            }
+            break;
+        case 'D':
+            get32(&p, r->end, &x);
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                getstr(&p, r->end, &s, &len);
+                get32(&p, r->end, &x);
+                str = strndup(s, len);
+                dict_add(obj, str, r->objs[x]);
+                safe_free(str);
+            }
+            break;
+        case 'H':
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&p, r->end, &x);
+                get32(&p, r->end, &y);
+                hm_set(obj, r->objs[x], r->objs[y]);
+            }
+            break;
+        case 'T':
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                get32(&p, r->end, &x);
+                set_add(obj, r->objs[x]);
+            }
+            break;
+        case 'Q':
+            get32(&p, r->end, &x);
+            if (x != IMG_NONE) {
+                obj->val.pq->proc = r->objs[x];
+                atom_bind(r->objs[x], obj);
+            }
+            get32(&p, r->end, &n);
+            for (uint32_t j = 0; j < n; ++j) {
+                double prio;
+                memcpy(&prio, p, sizeof(double));
+                p += sizeof(double);
+                get32(&p, r->end, &x);
+                pq_append(obj, r->objs[x], prio);
+            }
+            break;
+        case 'G':
+            get32(&p, r->end, &x);
+            get32(&p, r->end, &y);
+            gen_set(obj, r->objs[x], r->objs[y]);
+            break;
+        case 'F': {
+            function_t* f = obj->val.func;
+            get32(&p, r->end, &x);
+            get32(&p, r->end, &y);
+            get32(&p, r->end, &z);
+            f->params = r->objs[x];
+            f->body = r->objs[y];
+            f->env = r->objs[z];
+            atom_bind(f->params, obj);
+            atom_bind(f->body, obj);
+            for (atom_t* e = f->env; e && e != r->global_env; e = e->val.dict->parent)
+                atom_bind(e, obj);
+            break;
+        }
+        }
+    }
+
+    // Fill vectors in place: they never contain themselves, and vectors sharing one
+    // being filled see its items when it is done
+    atom_t** items = NULL;
+    for (uint32_t i = 2; i <= r->count; ++i) {
+        if (r->recs[i][0] != 'V')
+            continue;
+        p = r->recs[i] + 1;
+        get32(&p, r->end, &n);
+        items = realloc(items, (n + 1) * sizeof(atom_t*));
+        for (uint32_t j = 0; j < n; ++j) {
+            get32(&p, r->end, &x);
+            items[j] = r->objs[x];
+            if ((items[j]->type == LIST || items[j]->type == DICTIONARY ||
+                 items[j]->type == HASHMAP || items[j]->type == SET ||
+                 items[j]->type == RANGE || f64_is(items[j])) &&
+                !(items[j]->flags & F_FROZEN) && !atom_freeze(items[j]))
+                items[j] = &nilobj;
+        }
+        vec_fill(r->objs[i], items, n);
+    }
+    safe_free(items);
+
+    for (uint32_t i = 2; i <= r->count; ++i)
+        if (r->recs[i][0] == 'O') {
+            atom_unbind(r->objs[i], r->global_env);
+            atom_del(r->objs[i]);  // no longer referenced by anything
+        } else if (strchr("NSCV", r->recs[i][0]) && !r->objs[i]->bindings)
+            atom_del(r->objs[i]);  // copied into vectors, hash map keys or sets only
+}
+
+/*
+--------------------------------------
+image_read
+
+    Rebuild the global environment from an image in memory, and the list of values
+    if asked for.  Frozen objects by address are accepted only with pointers.
+    Return 1 on success.
+--------------------------------------
+*/
+static int image_read(alisp_ctx* ctx, const char* data, size_t size, atom_t** values,
+                      int pointers) {
+    if (size < sizeof(img_header_t)) {
+        errmsg("Image", "not an image file", NULL, NULL);
+        return 0;
+    }
+
+    img_header_t h;
+    memcpy(&h, data, sizeof(h));
+    int ok = 0;
+    if (memcmp(h.magic, IMG_MAGIC, 4) || h.bom != IMG_BOM)
+        errmsg("Image", "not an image file", NULL, NULL);
+    else if (h.version != IMG_VERSION)
+        errmsg("Image", "image was made by another version of the interpreter", NULL, NULL);
+    else if (h.count < 1 || h.count > (uint64_t)size)
+        errmsg("Image", "image is damaged", NULL, NULL);
+    else {
+        reader_t r;
+        r.global_env = ctx->global_env;
+        r.data = data + sizeof(h);
+        r.end = data + size;
+        r.count = h.count;
+        r.recs = malloc((h.count + 1) * sizeof(char*));
+        r.objs = malloc((h.count + 1) * sizeof(atom_t*));
+        r.pointers = pointers;
+        if (!image_scan(&r) || !image_check(&r) || (values && reftype(&r, 2) != LIST))
+            errmsg("Image", "image is damaged or incompatible", NULL, NULL);
+        else {
+            image_build(&r);
+            if (values)
+                *values = r.objs[2];
+            ok = 1;
+        }
+        safe_free(r.recs);
+        safe_free(r.objs);
+    }
+    return ok;
+}
+
+/* Rebuild the global environment from an image in memory. Return 1 on success. */
+int image_restore(alisp_ctx* ctx, const char* data, size_t size) {
+    return image_read(ctx, data, size, NULL, 1);
+}
+
+/* Rebuild an image of values. Return the list of values, or NULL on error. */
+atom_t* image_restore_values(alisp_ctx* ctx, const char* data, size_t size) {
+    atom_t* values = NULL;
+    return image_read(ctx, data, size, &values, 1) ? values : NULL;
+}
+
+/* Map an image file and rebuild the global environment from it. Return 1 on success. */
+int image_load(alisp_ctx* ctx, const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        errmsg("Image", "failed to open file", NULL, NULL);
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < (off_t)sizeof(img_header_t)) {
+        errmsg("Image", "not an image file", NULL, NULL);
+        close(fd);
+        return 0;
+    }
+    char* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        errmsg("Image", "failed to read file", NULL, NULL);
+        return 0;
+    }
+
+    int ok = image_read(ctx, data, st.st_size, NULL, 0);  // addresses mean nothing here
+    munmap(data, st.st_size);
+    return ok;
+}
@@ -0,0 +1,69 @@
+/*
+Alisp embedding API.
+Public interface of libalisp.a / libalisp.so for running the interpreter inside another
+program.
+
+Every interpreter lives in its own context.  Contexts are independent and may be used
+from different threads, but one context must not be used by two threads at a time.
+
+Values are owned by the interpreter while they are referenced from its environment.
+Values returned by the API that are not referenced (results of computations, values made
+with alisp_number or alisp_string) belong to the caller: pass them to the interpreter
+with alisp_set or alisp_call, or release them with alisp_release.  Releasing a value
+still referenced by the interpreter does nothing, so it is always safe to release a
+returned value when done with it.  A value referenced by the interpreter is valid until
+the next evaluation, which may reassign it.
+
+Errors are reported to the interpreter output, and the call returns NULL or 0.
+*/
+
+#ifndef LIBALISP_H
+#define LIBALISP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Context alisp_ctx;
+typedef struct Atom alisp_value;
+
+/* Native builtin: receives arguments, returns a result or NULL on error */
+typedef alisp_value* (*alisp_native)(alisp_ctx* ctx, int argc, alisp_value** argv, void* data);
+
+/* Value types */
+enum { ALISP_NIL, ALISP_NUMBER, ALISP_SYMBOL, ALISP_LIST, ALISP_DICTIONARY, ALISP_FUNCTION,
+       ALISP_BUILTIN, ALISP_FUTURE, ALISP_VECTOR, ALISP_HASHMAP,
+       ALISP_SET, ALISP_F64ARRAY, ALISP_MATRIX, ALISP_PQUEUE,
+       ALISP_RANGE, ALISP_GENERATOR, ALISP_STRING, ALISP_BUILDER };
+
+/* Contexts */
+alisp_ctx*   alisp_new(void);
+void         alisp_free(alisp_ctx* ctx);
+void         alisp_flush(alisp_ctx* ctx);
+
+/* Evaluation */
+alisp_value* alisp_eval(alisp_ctx* ctx, const char* src);
+int          alisp_run(alisp_ctx* ctx, const char* filename);
+alisp_value* alisp_call(alisp_ctx* ctx, alisp_value* fn, int argc, alisp_value** argv);
+
+/* Global environment */
+alisp_value* alisp_get(alisp_ctx* ctx, const char* name);
+int          alisp_set(alisp_ctx* ctx, const char* name, alisp_value* val);
+int          alisp_register(alisp_ctx* ctx, const char* name, alisp_native fn, void* data);
+
+/* Values */
+alisp_value* alisp_nil(void);
+alisp_value* alisp_number(double x);
+alisp_value* alisp_string(const char* s);
+int          alisp_type(const alisp_value* val);
+double       alisp_tonumber(const alisp_value* val);
+const char*  alisp_tosymbol(const alisp_value* val);
+char*        alisp_tostr(const alisp_value* val);
+void         alisp_error(alisp_ctx* ctx, const char* msg);
+void         alisp_release(alisp_ctx* ctx, alisp_value* val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
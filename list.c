@@ -1,5 +1,14 @@
 /*
 List: a collection of objects.
+
+Items are kept in one array with free slots at both ends, so inserting and removing
+items shifts the shorter side, and changes at the front or the back take amortized O(1)
+time: lists make queues and stacks alike.
+
+A slice made by list_slice is a list that shares a range of the items of another list,
+its base, instead of copying them.  The items stay bound to the base, and the slice
+holds the base with a binding of its own.  Both are copied on write: before a slice or
+a list with slices is changed, the slices get items of their own (list_own).
 */
 
 #include <stdio.h>
@@ -22,12 +31,16 @@ atom_t* list() {
     l->lock = 0;
     l->len = 0;
     l->maxlen = 2;
+    l->head = 0;
     l->items = malloc(l->maxlen * sizeof(atom_t*));
+    l->base = NULL;
+    l->slices = 0;
 
     // Make a list object
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.list = l;
     obj->type = LIST;
+    obj->flags = 0;
     obj->bindings = 0;
 
     return obj;
@@ -53,6 +66,20 @@ safe_free(dbg_s);
     atom_t* item;
     l->lock = 1;  // lock this object
 
+    // A slice releases its base, the items are not its own
+    if (l->base) {
+        atom_t* base = l->base;
+        if (!(base->flags & F_FROZEN))
+            --base->val.list->slices;
+        atom_unbind(base, obj);
+        atom_del(base);
+        list_free(l->bindlist);
+        safe_free(l);
+        safe_free(obj);
+        return;
+    }
+    list_own(obj);  // slices outliving the list keep the items
+
     // Deallocate bound objects
     for (int i = 0; i < l->len; ++i) {
         item = l->items[i];
@@ -63,6 +90,7 @@ safe_free(dbg_s);
     }
 
     // Deallocate the rest
+    l->items -= l->head;
     safe_free(l->items);  // free items
     list_free(l->bindlist);
     safe_free(l);         // free list
@@ -71,24 +99,33 @@ safe_free(dbg_s);
 
 /*
 --------------------------------------
-list_cp
+list_room
 
-    Copy a list (subroutine for atom_cp).
+    Make room for an item at the front or the back of a list.  If free slots are
+    plenty at the other end, items are moved to the middle of the allocation,
+    otherwise the allocation grows.  Either way there are enough free slots at both
+    ends afterwards to pay for the move.
 --------------------------------------
 */
-atom_t* list_cp(atom_t* obj, atom_t* objects, atom_t* copies) {
-    int i = list_idx(objects, obj);
-    if (i != -1)
-        return copies->val.list->items[i];  // object already has a copy
-
-    atom_t* copy = list();
-    list_add_h(objects, obj);
-    list_add_h(copies, copy);
-
-    atom_t** items = obj->val.list->items;
-    for (i = 0; i < list_len(obj); ++i)
-        list_add(copy, atom_cp(items[i], objects, copies));
-    return copy;
+static void list_room(list_t* l, int front) {
+    atom_t** mem = l->items - l->head;
+    int total = l->head + l->maxlen;
+    int room = total - l->len;
+    int head;
+
+    if (room > l->len / 2 + 1) {
+        head = room / 2;
+        memmove(mem + head, l->items, l->len * sizeof(atom_t*));
+    } else {
+        total = total * 1.5 + 2;
+        mem = realloc(mem, total * sizeof(atom_t*));
+        head = front ? (total - l->len) / 2 : l->head;  // none added at the front for the back
+        if (head != l->head)
+            memmove(mem + head, mem + l->head, l->len * sizeof(atom_t*));
+    }
+    l->items = mem + head;
+    l->maxlen = total - head;
+    l->head = head;
 }
 
 /*
@@ -105,20 +142,26 @@ void list_insert(atom_t* obj, int index, atom_t* item, char bind) {
         exit(EXIT_FAILURE);
     }
 
+    list_own(obj);
     list_t* l = obj->val.list;
 
-    // Allocate more space if necessary
-    if (l->len == l->maxlen) {
-        l->maxlen *= 1.5;
-        l->items = realloc(l->items, l->maxlen * sizeof(atom_t*));
-    }
-
     if (index > l->len || index < 0)
         // insert item at the end of the list
         index = l->len;
-    else
-        // shift items to free space
+
+    // Shift the shorter side to free space
+    if (index < l->len - index) {
+        if (!l->head)
+            list_room(l, 1);
+        --l->items;
+        --l->head;
+        ++l->maxlen;
+        memmove(l->items, l->items + 1, index * sizeof(atom_t*));
+    } else {
+        if (l->len == l->maxlen)
+            list_room(l, 0);
         memmove(l->items + index + 1, l->items + index, (l->len - index) * sizeof(atom_t*));
+    }
 
     // Insert item
     l->items[index] = item;
@@ -200,6 +243,7 @@ void list_remove(atom_t* obj, int index, char unbind) {
         exit(EXIT_FAILURE);
     }
 
+    list_own(obj);
     list_t* l = obj->val.list;
 
     if (unbind) {
@@ -207,7 +251,14 @@ void list_remove(atom_t* obj, int index, char unbind) {
         atom_del(l->items[index]);
     }
 
-    memmove(l->items + index, l->items + index + 1, (l->len - index - 1) * sizeof(atom_t*));
+    // Shift the shorter side over the item
+    if (index < l->len - index - 1) {
+        memmove(l->items + 1, l->items, index * sizeof(atom_t*));
+        ++l->items;
+        ++l->head;
+        --l->maxlen;
+    } else
+        memmove(l->items + index, l->items + index + 1, (l->len - index - 1) * sizeof(atom_t*));
     --l->len;
 }
 
@@ -261,17 +312,17 @@ void list_print(atom_t* obj, int depth) {
     list_assert(obj, "list_print");
     atom_t** items = obj->val.list->items;
     char* o;
-    printf("(");
+    out_char('(');
     for (int i = 0; i < list_len(obj); ++i) {
 
         o = atom_tostring(items[i], depth ? depth - 1 : depth);
-        printf("%s", o);
+        out_str(o);
         safe_free(o);
 
         if (i < list_len(obj) - 1)
-            putchar(' ');
+            out_char(' ');
     }
-    printf(")\n");
+    out_str(")\n");
 }
 
 /*
@@ -310,6 +361,111 @@ int list_maxlen(atom_t* obj) {
     return obj->val.list->maxlen;
 }
 
+/*
+--------------------------------------
+list_reserve
+
+    Make room for at least n items.
+--------------------------------------
+*/
+void list_reserve(atom_t* obj, int n) {
+    list_own(obj);
+    list_t* l = obj->val.list;
+    if (n > l->maxlen) {
+        l->maxlen = n;
+        l->items = realloc(l->items - l->head, (l->head + n) * sizeof(atom_t*));
+        l->items += l->head;
+    }
+}
+
+/*
+--------------------------------------
+list_append
+
+    Append n items to a list at once.
+--------------------------------------
+*/
+void list_append(atom_t* obj, atom_t** items, int n) {
+    list_reserve(obj, list_len(obj) + n);
+    list_t* l = obj->val.list;
+    memcpy(l->items + l->len, items, n * sizeof(atom_t*));
+    for (int i = 0; i < n; ++i)
+        atom_bind(items[i], obj);
+    l->len += n;
+}
+
+/*
+--------------------------------------
+list_slice
+
+    Return a list of items in range [from, to) that shares them with the list.
+--------------------------------------
+*/
+atom_t* list_slice(atom_t* obj, int from, int to) {
+    list_assert(obj, "list_slice");
+    atom_t* v = list();
+    if (from >= to)
+        return v;
+
+    list_t* l = obj->val.list;
+    atom_t* base = l->base ? l->base : obj;  // slice of a slice shares the same items
+    if (to - from < LIST_SLICE_MIN || ((base->flags & F_UNCOUNTED) && !(base->flags & F_FROZEN))) {
+        list_append(v, l->items + from, to - from);  // short, or changes to base are not tracked
+        return v;
+    }
+    safe_free(v->val.list->items);
+    v->val.list->items = l->items + from;
+    v->val.list->len = to - from;
+    v->val.list->maxlen = 0;
+    v->val.list->base = base;
+    if (!(base->flags & F_FROZEN))
+        ++base->val.list->slices;
+    atom_bind(base, v);  // frozen items never change, they are shared untracked
+    return v;
+}
+
+/* Give a slice items of its own. Return its former base. */
+static atom_t* slice_own(atom_t* obj) {
+    list_t* l = obj->val.list;
+    atom_t* base = l->base;
+    int max = l->len > 2 ? l->len : 2;
+    atom_t** items = malloc(max * sizeof(atom_t*));
+    memcpy(items, l->items, l->len * sizeof(atom_t*));
+    l->items = items;
+    l->maxlen = max;
+    l->head = 0;
+    l->base = NULL;
+    for (int i = 0; i < l->len; ++i)
+        atom_bind(items[i], obj);
+    if (!(base->flags & F_FROZEN))
+        --base->val.list->slices;
+    atom_unbind(base, obj);
+    return base;
+}
+
+/*
+--------------------------------------
+list_own
+
+    Prepare a list for a change: if it is a slice, copy the items it shares; if it
+    has slices, let them copy the items first.
+--------------------------------------
+*/
+void list_own(atom_t* obj) {
+    list_t* l = obj->val.list;
+    if (l->base)
+        atom_del(slice_own(obj));
+
+    // Slices are among the owners, the list itself is in use and not deleted
+    for (int i = 0; l->slices; ++i) {
+        atom_t* s = l->bindlist->val.list->items[i];
+        if (s->type == LIST && s->val.list->base == obj) {
+            slice_own(s);
+            i = -1;  // bind list has changed, start over
+        }
+    }
+}
+
 /*
 --------------------------------------
 list_free
@@ -319,6 +475,7 @@ list_free
 */
 void list_free(atom_t* obj) {
     if (obj) {
+        obj->val.list->items -= obj->val.list->head;
         safe_free(obj->val.list->items);  // free items
         safe_free(obj->val.list);         // free list
         safe_free(obj);                   // free object
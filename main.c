@@ -8,106 +8,77 @@ Can be run in REPL mode and/or to interpret a source file.
 #include <string.h>
 #include "alisp.h"
 
-char* input = NULL;
-
 /* Main. */
 int main(int argc, char* argv[]) {
-    globenv_init();  // create global environment
+    out_init();                   // flush output at exit
+    alisp_ctx* ctx = ctx_new();   // create interpreter with global environment
+
+    // Parse options
+    const char* filename = NULL;
+    const char* sockpath = NULL;
+    int interactive = 0;
+    int batch = 0;
+    int workers = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (streq(argv[i], "-i")) {
+            interactive = 1;
+        } else if (streq(argv[i], "--image") && i + 1 < argc) {
+            if (!image_load(ctx, argv[++i])) {
+                ctx_del(ctx);
+                return EXIT_FAILURE;
+            }
+        } else if (streq(argv[i], "--no-cache")) {
+            ctx->use_cache = 0;
+        } else if (streq(argv[i], "-j") && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            ctx_set_jobs(ctx, atoi(argv[++i]));
+        } else if (streq(argv[i], "--serve") && i + 1 < argc) {
+            sockpath = argv[++i];
+        } else if (streq(argv[i], "--zygote")) {
+            batch = 1;
+        } else if (streq(argv[i], "--workers") && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            workers = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && !filename) {
+            filename = argv[i];
+        } else {
+            helpmsg();
+            ctx_del(ctx);
+            return EXIT_FAILURE;
+        }
+    }
 
-    if (argc == 1) {
+    if (sockpath) {
+        // Script is the prelude of every request
+        if (filename && !script(ctx, filename)) {
+            ctx_del(ctx);
+            return EXIT_FAILURE;
+        }
+        serve(ctx, sockpath, workers);
+        ctx_del(ctx);
+        return EXIT_FAILURE;
+
+    } else if (batch) {
+        // Script is the prelude of every script of the batch
+        if (filename && !script(ctx, filename)) {
+            ctx_del(ctx);
+            return EXIT_FAILURE;
+        }
+        int failed = zygote(ctx, workers);
+        ctx_del(ctx);
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+    } else if (!filename) {
         intromsg();
         while (1)
-            repl();
-
-    } else if (argc == 2 && argv[1][0] != '-') {
-        script(argv[1]);
-
-    } else if (argc == 3 && argv[1][0] != '-' && streq(argv[2], "-i")) {
-        script(argv[1]);
-        while (1)
-            repl();
-
-    } else
-        helpmsg();
-
-    globenv_del();  // deallocate global environment
-}
-
-/*
---------------------------------------
-script
-
-    Run a script.
---------------------------------------
-*/
-void script(const char* filename) {
-    if (!filename) {
-        errmsg("Script", "no file name given", NULL, NULL);
-        return;
-    }
-
-    FILE *f;
-    if ((f = fopen(filename, "r")) == NULL) {
-        errmsg("Script", "failed to open file", filename, filename);
-        return;
-    }
-
-    // Get the size of the file
-    fseek(f, 0L, SEEK_END);
-    long bufsize = ftell(f);
-    if (bufsize == -1) {
-        errmsg("Script", "failed to read file", filename, filename);
-        fclose(f);
-        return;
-    }
-
-    safe_free(input);
-    input = malloc(sizeof(char) * (bufsize + 1));
+            repl(ctx);
 
-    // Read the entire file into memory
-    fseek(f, 0L, SEEK_SET);
-    size_t i = fread(input, sizeof(char), bufsize, f);
-    if (ferror(f)) {
-        errmsg("Script", "failed to read file", filename, filename);
-        fclose(f);
-        safe_free(input);
-        return;
-    } else
-        input[i] = '\0';
-    fclose(f);
-
-    if (strlen(input) == 0) {
-        safe_free(input);
-        return;
-    }
-
-#ifdef DEBUG
-printf("....  script:                  Building parse tree\n");
-#endif
-
-    // Parse
-    atom_t* parse_tree = parse();
-
-    if (!parse_tree) {
-        safe_free(input);
-        return;
+    } else {
+        script(ctx, filename);
+        if (interactive)
+            while (1)
+                repl(ctx);
     }
-    atom_bind(parse_tree, global_env);
-
-#ifdef DEBUG
-printf("....  script:                  Evaluating parse tree\n");
-#endif
 
-    // Evaluate
-    eval(parse_tree, global_env, NULL);
-
-#ifdef DEBUG
-printf("....  script:                  Deallocating parse tree\n");
-#endif
-
-    atom_unbind(parse_tree, global_env);
-    atom_del(parse_tree);
-    safe_free(input);
+    ctx_del(ctx);  // deallocate interpreter
 }
 
 /*
@@ -117,28 +88,28 @@ repl
     Read-evaluate-print loop.
 --------------------------------------
 */
-void repl() {
+void repl(alisp_ctx* ctx) {
     // Read input
-    input = malloc(32);
+    char* input = ctx->input = malloc(32);
     unsigned imax = 32;
     unsigned i;
-    printf("~ ");
+    out_str("~ ");
+    out_flush();
 
     for(i = 0; (input[i] = getchar()) != EOF && input[i] != '\n'; ++i)
         if (i == imax - 2)
-            input = realloc(input, imax *= 2);
+            input = ctx->input = realloc(input, imax *= 2);
     input[i] = '\0';
 
     if (strlen(input) == 0) {
-        safe_free(input);
+        safe_free(ctx->input);
         return;
     }
 
     // Magic commands
     if (input[0] == '$') {
-        magic();
-        if (input)
-            safe_free(input);
+        magic(ctx);
+        safe_free(ctx->input);
         return;
     }
 
@@ -147,22 +118,24 @@ printf("....  repl:                    Building parse tree\n");
 #endif
 
     // Parse
-    atom_t* parse_tree = parse();
+    arena_t* arena = ctx->arena;
+    atom_t* parse_tree = parse(input, arena);
     if (!parse_tree) {
-        safe_free(input);
+        arena_reset(arena);
+        safe_free(ctx->input);
         return;
     }
-    atom_bind(parse_tree, global_env);
 
 #ifdef DEBUG
 printf("....  repl:                    Evaluating parse tree\n");
 #endif
 
     // Evaluate
-    atom_t* val = eval(parse_tree, global_env, NULL);
+    atom_t* val = eval(ctx, parse_tree, ctx->global_env, NULL);
     if (val && val->type != NIL) {
         char* o = atom_tostr(val);
-        printf("%s\n", o);
+        out_str(o);
+        out_char('\n');
         safe_free(o);
     }
 
@@ -170,13 +143,10 @@ printf("....  repl:                    Evaluating parse tree\n");
 printf("....  repl:                    Deallocating parse tree\n");
 #endif
 
-    atom_unbind(parse_tree, global_env);
-    if (val == parse_tree)
-        val = NULL;
-    else if (val)
+    if (val)
         atom_del(val);
-    atom_del(parse_tree);
-    safe_free(input);
+    arena_reset(arena);
+    safe_free(ctx->input);
 }
 
 /*
@@ -186,31 +156,36 @@ magic
     Run a magic command.
 --------------------------------------
 */
-void magic() {
+void magic(alisp_ctx* ctx) {
+    const char* input = ctx->input;
     if (streq(input+1, "help")) {
-        printf("Magic commands:\n"
+        out_str("Magic commands:\n"
                "  $exit             Graceful exit from the interpreter.\n"
                "  $env              View global environment contents.\n"
                "  $run              Run script file.\n"
+               "  $save             Save global environment to an image file.\n"
                "  $about            Info about the program.\n");
 
     } else if (streq(input + 1, "env")) {
-        dict_print(global_env, 2);
+        dict_print(ctx->global_env, 2);
 
     } else if (streq(input + 1, "exit")) {
-        safe_free(input);
-        globenv_del();
+        ctx_del(ctx);
         exit(EXIT_SUCCESS);
 
     } else if (!strncmp(input + 1, "run ", 4)) {
         if (strlen(input) > 5)
-            script(input + 5);
+            script(ctx, input + 5);
+
+    } else if (!strncmp(input + 1, "save ", 5)) {
+        if (strlen(input) > 6)
+            image_save(ctx, input + 6);
 
     } else if (streq(input+1, "about")) {
-        printf("Alisp interpreter by Alex Baryzhikov.\n");
+        out_str("Alisp interpreter by Alex Baryzhikov.\n");
 
     } else {
-        printf("Unrecognized command: %s\n", input + 1);
+        out_printf("Unrecognized command: %s\n", input + 1);
     }
 }
 
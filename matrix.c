@@ -0,0 +1,276 @@
+/*
+Matrix: dense matrix of doubles in row-major order.
+A matrix is an f64 array of type MATRIX with a shape, so elementwise arithmetic and
+math operators work on it as on arrays, item by item.  Here are the operations of
+linear algebra: product, transpose and solving linear systems.
+
+Multiplication goes through blocks of MAT_KC rows and MAT_NC columns of the right
+matrix, small enough to stay in cache while every row of the left matrix passes
+through them, and adds them up in the vector kernel f64_madd.  Transposing copies
+tiles of MAT_TILE x MAT_TILE items, so both matrices are read and written in cache
+lines.  Systems are solved by LU decomposition with partial pivoting, the elimination
+of every column updating the rows below in one kernel call.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "alisp.h"
+
+#define MAT_KC   128    // rows of a block of the right matrix of a product
+#define MAT_NC   256    // columns of a block
+#define MAT_TILE 32     // side of a tile of a transpose
+
+/*
+--------------------------------------
+mat_new
+
+    Make a matrix of zeros.
+--------------------------------------
+*/
+atom_t* mat_new(int rows, int cols) {
+    atom_t* obj = f64_new(rows * cols);
+    obj->type = MATRIX;
+    obj->val.arr->rows = rows;
+    obj->val.arr->cols = cols;
+    memset(f64_data(obj), 0, (size_t)rows * cols * sizeof(double));
+    return obj;
+}
+
+/* Number of rows. */
+int mat_rows(atom_t* obj) {
+    return obj->val.arr->rows;
+}
+
+/* Number of columns. */
+int mat_cols(atom_t* obj) {
+    return obj->val.arr->cols;
+}
+
+/*
+--------------------------------------
+mat_from
+
+    Make a matrix of a list of rows, lists of numbers of the same length.  Return
+    NULL if the list is not like that.
+--------------------------------------
+*/
+atom_t* mat_from(atom_t* lst) {
+    int rows = list_len(lst);
+    atom_t** items = lst->val.list->items;
+    int cols = rows && items[0]->type == LIST ? list_len(items[0]) : 0;
+    for (int i = 0; i < rows; ++i) {
+        if (items[i]->type != LIST || list_len(items[i]) != cols) {
+            errmsg("Semantic", "rows must be lists of the same length", NULL, NULL);
+            return NULL;
+        }
+        for (int j = 0; j < cols; ++j)
+            if (items[i]->val.list->items[j]->type != NUMBER) {
+                errmsg("Semantic", "matrix items must be numbers", NULL, NULL);
+                return NULL;
+            }
+    }
+    if ((double)rows * cols > F64_MAX_LEN) {
+        errmsg("Semantic", "matrix is too large", NULL, NULL);
+        return NULL;
+    }
+
+    atom_t* obj = mat_new(rows, cols);
+    double* d = f64_data(obj);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            d[i * cols + j] = *items[i]->val.list->items[j]->val.num;
+    return obj;
+}
+
+/* Return a list of rows, lists of numbers. */
+atom_t* mat_list(atom_t* obj) {
+    int rows = mat_rows(obj), cols = mat_cols(obj);
+    double* d = f64_data(obj);
+    atom_t* lst = list();
+    list_reserve(lst, rows);
+    for (int i = 0; i < rows; ++i) {
+        atom_t* row = list();
+        list_reserve(row, cols);
+        for (int j = 0; j < cols; ++j)
+            list_add(row, num(d[i * cols + j]));
+        list_add(lst, row);
+    }
+    return lst;
+}
+
+/*
+--------------------------------------
+mat_mul
+
+    Multiply a matrix by a matrix, or by an array as a column vector.  Return the
+    matrix or array of the product, or NULL if the shapes don't match.
+--------------------------------------
+*/
+atom_t* mat_mul(atom_t* x, atom_t* y) {
+    int m = mat_rows(x), k = mat_cols(x);
+    double* a = f64_data(x);
+
+    // Matrix-vector product: dot product of every row
+    if (y->type == F64ARRAY) {
+        if (f64_len(y) != k) {
+            errmsg("Semantic", "array length differs from matrix columns", NULL, NULL);
+            return NULL;
+        }
+        atom_t* res = f64_new(m);
+        double* r = f64_data(res);
+        for (int i = 0; i < m; ++i)
+            r[i] = f64_vdot(a + (size_t)i * k, f64_data(y), k);
+        return res;
+    }
+
+    if (mat_rows(y) != k) {
+        errmsg("Semantic", "matrix shapes don't match", NULL, NULL);
+        return NULL;
+    }
+    int n = mat_cols(y);
+    double* b = f64_data(y);
+    atom_t* res = mat_new(m, n);
+    double* c = f64_data(res);
+
+    // Every block of y is added up for all rows of x before moving on
+    for (int jj = 0; jj < n; jj += MAT_NC)
+        for (int kk = 0; kk < k; kk += MAT_KC)
+            f64_madd(c + jj, n, a + kk, k, b + (size_t)kk * n + jj, n, m,
+                     k - kk < MAT_KC ? k - kk : MAT_KC, n - jj < MAT_NC ? n - jj : MAT_NC);
+    return res;
+}
+
+/* Transpose a matrix. */
+atom_t* mat_transpose(atom_t* obj) {
+    int m = mat_rows(obj), n = mat_cols(obj);
+    double* a = f64_data(obj);
+    atom_t* res = mat_new(n, m);
+    double* r = f64_data(res);
+    for (int ii = 0; ii < m; ii += MAT_TILE)
+        for (int jj = 0; jj < n; jj += MAT_TILE)
+            for (int i = ii; i < m && i < ii + MAT_TILE; ++i)
+                for (int j = jj; j < n && j < jj + MAT_TILE; ++j)
+                    r[(size_t)j * m + i] = a[(size_t)i * n + j];
+    return res;
+}
+
+/*
+--------------------------------------
+mat_solve
+
+    Solve a * x = b for x, b being an array or a matrix of right-hand sides in
+    columns.  Return x, of the type of b, or NULL if a is not square or is singular,
+    or b doesn't match.
+--------------------------------------
+*/
+atom_t* mat_solve(atom_t* x, atom_t* y) {
+    int n = mat_rows(x);
+    int nb = y->type == MATRIX ? mat_cols(y) : 1;
+    if (mat_cols(x) != n) {
+        errmsg("Semantic", "matrix is not square", NULL, NULL);
+        return NULL;
+    } else if ((y->type == MATRIX ? mat_rows(y) : f64_len(y)) != n) {
+        errmsg("Semantic", "matrix shapes don't match", NULL, NULL);
+        return NULL;
+    }
+
+    // Work on copies: LU factors in place of a, solutions in place of b
+    atom_t* lu = f64_copy(x);
+    atom_t* res = f64_copy(y);
+    double* a = f64_data(lu);
+    double* b = f64_data(res);
+    double* neg = malloc((n ? n : 1) * sizeof(double));
+    double* tmp = malloc((nb ? nb : 1) * sizeof(double));
+    int ok = 1;
+
+    for (int k = 0; ok && k < n; ++k) {
+        // Largest pivot of the column goes up
+        int p = k;
+        for (int i = k + 1; i < n; ++i)
+            if (fabs(a[(size_t)i * n + k]) > fabs(a[(size_t)p * n + k]))
+                p = i;
+        if (a[(size_t)p * n + k] == 0) {
+            ok = 0;
+            break;
+        }
+        if (p != k) {
+            for (int j = 0; j < n; ++j) {
+                double t = a[(size_t)k * n + j];
+                a[(size_t)k * n + j] = a[(size_t)p * n + j];
+                a[(size_t)p * n + j] = t;
+            }
+            memcpy(tmp, b + (size_t)k * nb, nb * sizeof(double));
+            memcpy(b + (size_t)k * nb, b + (size_t)p * nb, nb * sizeof(double));
+            memcpy(b + (size_t)p * nb, tmp, nb * sizeof(double));
+        }
+
+        // Subtract multiples of the pivot row from the rows below, in a and b
+        double pivot = a[(size_t)k * n + k];
+        for (int i = k + 1; i < n; ++i) {
+            a[(size_t)i * n + k] /= pivot;
+            neg[i] = -a[(size_t)i * n + k];
+        }
+        if (k + 1 < n) {
+            f64_madd(a + (size_t)(k + 1) * n + k + 1, n, neg + k + 1, 1,
+                     a + (size_t)k * n + k + 1, n, n - k - 1, 1, n - k - 1);
+            f64_madd(b + (size_t)(k + 1) * nb, nb, neg + k + 1, 1,
+                     b + (size_t)k * nb, nb, n - k - 1, 1, nb);
+        }
+    }
+
+    // Back substitution, all right-hand sides at once
+    for (int i = n - 1; ok && i >= 0; --i) {
+        double* bi = b + (size_t)i * nb;
+        for (int j = i + 1; j < n; ++j) {
+            double f = a[(size_t)i * n + j];
+            for (int c = 0; c < nb; ++c)
+                bi[c] -= f * b[(size_t)j * nb + c];
+        }
+        for (int c = 0; c < nb; ++c)
+            bi[c] /= a[(size_t)i * n + i];
+    }
+
+    safe_free(neg);
+    safe_free(tmp);
+    atom_del(lu);
+    if (!ok) {
+        atom_del(res);
+        errmsg("Semantic", "matrix is singular", NULL, NULL);
+        return NULL;
+    }
+    return res;
+}
+
+/*
+--------------------------------------
+mat_tostr
+
+    Make a string representing a matrix, rows separated by semicolons.
+--------------------------------------
+*/
+char* mat_tostr(atom_t* obj) {
+    int rows = mat_rows(obj), cols = mat_cols(obj);
+    double* d = f64_data(obj);
+    char* o;
+    char buf[1024];
+    char tmp[64];
+    strcpy(buf, "mat[");
+
+    for (int i = 0; i < rows * cols; ++i) {
+        sprintf(tmp, "%g", d[i]);
+        if (strlen(buf) + strlen(tmp) > 1000) {
+            strcat(buf, " ... ");
+            break;
+        }
+        strcat(buf, tmp);
+        if (i < rows * cols - 1)
+            strcat(buf, (i + 1) % cols ? " " : "; ");
+    }
+
+    strcat(buf, "]");
+    o = malloc(strlen(buf) + 1);
+    strcpy(o, buf);
+    return o;
+}
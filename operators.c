@@ -14,11 +14,13 @@ Operators.
 /* Print. */
 atom_t* op_print() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = PRINT;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -26,11 +28,27 @@ atom_t* op_print() {
 /* Print line. */
 atom_t* op_println() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = PRINTLN;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Flush output. */
+atom_t* op_flush() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = FLUSH;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -42,12 +60,14 @@ atom_t* op_println() {
 /* Math unary. */
 atom_t* op_math1(double (*op)(double)) {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->val.math1 = op;
     o->type = MATH1;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -55,12 +75,14 @@ atom_t* op_math1(double (*op)(double)) {
 /* Math unary, mutates argument. */
 atom_t* op_math1m(double (*op)(double)) {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->val.math1 = op;
     o->type = MATH1_M;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -68,12 +90,14 @@ atom_t* op_math1m(double (*op)(double)) {
 /* Math binary. */
 atom_t* op_math2(double (*op)(double, double)) {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->val.math2 = op;
     o->type = MATH2;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -81,12 +105,14 @@ atom_t* op_math2(double (*op)(double, double)) {
 /* Math binary, reduces operator over arguments. */
 atom_t* op_math2r(double (*op)(double, double)) {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->val.math2 = op;
     o->type = MATH2_R;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -94,12 +120,14 @@ atom_t* op_math2r(double (*op)(double, double)) {
 /* Relation. */
 atom_t* op_rel(double (*op)(char, void*, void*)) {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->val.rel = op;
     o->type = REL;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -111,11 +139,13 @@ atom_t* op_rel(double (*op)(char, void*, void*)) {
 /* Return a copy of an object. */
 atom_t* op_copy() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = COPY;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -123,11 +153,27 @@ atom_t* op_copy() {
 /* Return type of an object. */
 atom_t* op_type() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = TYPE;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Make an object immutable. */
+atom_t* op_freeze() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = FREEZE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -139,11 +185,13 @@ atom_t* op_type() {
 /* Create list. */
 atom_t* op_list() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_NEW;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -151,11 +199,13 @@ atom_t* op_list() {
 /* Get list element/sublist. */
 atom_t* op_list_get() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_GET;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -163,11 +213,13 @@ atom_t* op_list_get() {
 /* Assign a value to list element. */
 atom_t* op_list_set() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_SET;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -175,11 +227,13 @@ atom_t* op_list_set() {
 /* Return list length. */
 atom_t* op_list_len() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_LEN;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -187,11 +241,13 @@ atom_t* op_list_len() {
 /* Add element to list. */
 atom_t* op_list_add() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_ADD;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -199,11 +255,13 @@ atom_t* op_list_add() {
 /* Insert element to list. */
 atom_t* op_list_ins() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_INS;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -211,11 +269,13 @@ atom_t* op_list_ins() {
 /* Delete element from list. */
 atom_t* op_list_rem() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_REM;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
@@ -223,51 +283,1104 @@ atom_t* op_list_rem() {
 /* Merge lists. */
 atom_t* op_list_merge() {
     operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
     o->type = LIST_MERGE;
 
     atom_t* obj = malloc(sizeof(atom_t));
     obj->val.oper = o;
     obj->type = STD_OP;
+    obj->flags = 0;
     obj->bindings = 0;
     return obj;
 }
 
+/* Make a vector. */
+atom_t* op_vec() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_NEW;
 
-// ---------------------------------------------------------------------- 
-// TODO: dictionary
-// TODO: "for" loop -- iterable/generator based
-// TODO: "while" loop -- condition based
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
 
+/* Get vector item or slice. */
+atom_t* op_vec_get() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_GET;
 
-// ---------------------------------------------------------------------- 
-// Operator functions
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
 
-/* Arithmetic */
-double op_add(double a, double b) { return a + b; }
-double op_sub(double a, double b) { return a - b; }
-double op_mul(double a, double b) { return a * b; }
-double op_div(double a, double b) { return a / b; }
-double op_inc(double a)           { return a + 1.0; }
-double op_dec(double a)           { return a - 1.0; }
+/* Vector with an item replaced. */
+atom_t* op_vec_set() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_SET;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Vector length. */
+atom_t* op_vec_len() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_LEN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Vector with items appended. */
+atom_t* op_vec_add() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_ADD;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Merge vectors. */
+atom_t* op_vec_merge() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_MERGE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Vector of list items. */
+atom_t* op_vec_from() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_FROM;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* List of vector items. */
+atom_t* op_vec_list() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = VEC_LIST;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Hash map. */
+atom_t* op_hashmap() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = HM_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Value of a key. */
+atom_t* op_hm_get() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = HM_GET;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Associate a value with a key. */
+atom_t* op_hm_set() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = HM_SET;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Check for a key. */
+atom_t* op_hm_has() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = HM_HAS;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Remove a key. */
+atom_t* op_hm_del() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = HM_DEL;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* List of keys. */
+atom_t* op_hm_keys() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = HM_KEYS;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Number of keys. */
+atom_t* op_hm_len() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = HM_LEN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Set. */
+atom_t* op_set() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Add keys to a set. */
+atom_t* op_set_add() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_ADD;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Check for a key in a set. */
+atom_t* op_set_has() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_HAS;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Remove keys from a set. */
+atom_t* op_set_rem() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_REM;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Union of sets. */
+atom_t* op_set_union() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_UNION;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Intersection of sets. */
+atom_t* op_set_intersect() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_INTERSECT;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Difference of sets. */
+atom_t* op_set_difference() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_DIFFERENCE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Priority queue. */
+atom_t* op_pq_new() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = PQ_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Push to a priority queue. */
+atom_t* op_pq_push() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = PQ_PUSH;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Pop from a priority queue. */
+atom_t* op_pq_pop() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = PQ_POP;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* First item of a priority queue. */
+atom_t* op_pq_peek() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = PQ_PEEK;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Length of a priority queue. */
+atom_t* op_pq_len() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = PQ_LEN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Lazy range of numbers. */
+atom_t* op_range() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = RANGE_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Generator of items. */
+atom_t* op_generator() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = GEN_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* List of the items of a sequence. */
+atom_t* op_to_list() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = TO_LIST;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Concatenate strings. */
+atom_t* op_concat() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = STR_CONCAT;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Substring. */
+atom_t* op_substr() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = STR_SUB;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Length of a string. */
+atom_t* op_str_len() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = STR_LEN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Split a string. */
+atom_t* op_split() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = STR_SPLIT;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Join strings. */
+atom_t* op_join() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = STR_JOIN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Find a substring. */
+atom_t* op_find() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = STR_FIND;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* String builder. */
+atom_t* op_sb_new() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SB_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Append to a string builder. */
+atom_t* op_sb_add() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SB_ADD;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* String of a string builder. */
+atom_t* op_sb_str() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SB_STR;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Length of a string builder. */
+atom_t* op_sb_len() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SB_LEN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Number of keys in a set. */
+atom_t* op_set_len() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_LEN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Set of the items of a list. */
+atom_t* op_set_from() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_FROM;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* List of the keys of a set. */
+atom_t* op_set_list() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SET_LIST;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* F64 array of list items. */
+atom_t* op_f64array() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* F64 array of a range. */
+atom_t* op_f64_range() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_RANGE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Item of an array. */
+atom_t* op_f64_get() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_GET;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Number of items in an array. */
+atom_t* op_f64_len() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_LEN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* List of the items of an array. */
+atom_t* op_f64_list() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_LIST;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Sum of array items. */
+atom_t* op_sum() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_SUM;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Dot product of arrays. */
+atom_t* op_dot() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_DOT;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Minimum. */
+atom_t* op_min() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_MIN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Maximum. */
+atom_t* op_max() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = F64_MAX;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Matrix. */
+atom_t* op_matrix() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_NEW;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Item of a matrix. */
+atom_t* op_mat_get() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_GET;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Number of rows of a matrix. */
+atom_t* op_mat_rows() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_ROWS;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Number of columns of a matrix. */
+atom_t* op_mat_cols() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_COLS;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* List of the rows of a matrix. */
+atom_t* op_mat_list() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_LIST;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Matrix product. */
+atom_t* op_matmul() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_MUL;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Transpose of a matrix. */
+atom_t* op_transpose() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_TRANSPOSE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Solution of a linear system. */
+atom_t* op_solve() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAT_SOLVE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Map. */
+atom_t* op_map() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = MAP;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Filter. */
+atom_t* op_filter() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = FILTER;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Reduce. */
+atom_t* op_reduce() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = REDUCE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Fold. */
+atom_t* op_fold() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = FOLD;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* For each. */
+atom_t* op_foreach() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = FOREACH;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Parallel map. */
+atom_t* op_pmap() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = PMAP;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Parallel reduce. */
+atom_t* op_preduce() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = PREDUCE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Sort. */
+atom_t* op_sort() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SORT;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Stable sort. */
+atom_t* op_stable_sort() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = STABLE_SORT;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Binary search. */
+atom_t* op_bsearch() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = BSEARCH;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Lower bound. */
+atom_t* op_lower_bound() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = LOWER_BOUND;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+
+// ---------------------------------------------------------------------- 
+// TODO: dictionary
+// TODO: "for" loop -- iterable/generator based
+// TODO: "while" loop -- condition based
+
+
+// ---------------------------------------------------------------------- 
+// Native
+
+/* Builtin of the embedding program. */
+atom_t* op_native(native_t fn, void* data) {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->val.native.fn = fn;
+    o->val.native.data = data;
+    o->type = NATIVE;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+
+// ---------------------------------------------------------------------- 
+// Tasks
+
+/* Spawn. */
+atom_t* op_spawn() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = SPAWN;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Await. */
+atom_t* op_await() {
+    operator_t* o = malloc(sizeof(operator_t));
+    o->name = NULL;
+    o->type = AWAIT;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.oper = o;
+    obj->type = STD_OP;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+// ---------------------------------------------------------------------- 
+// Operator functions
+
+/* Arithmetic */
+double op_add(double a, double b) { return a + b; }
+double op_sub(double a, double b) { return a - b; }
+double op_mul(double a, double b) { return a * b; }
+double op_div(double a, double b) { return a / b; }
+double op_inc(double a)           { return a + 1.0; }
+double op_dec(double a)           { return a - 1.0; }
+
+/* Relational: numbers, strings (atoms) or symbols (text) */
+static int text_cmp(char type, void* a, void* b) {
+    return type == STRING ? str_cmp((atom_t*)a, (atom_t*)b) : strcmp((char*)a, (char*)b); }
+
+static int text_eq(char type, void* a, void* b) {
+    return type == STRING ? str_eq((atom_t*)a, (atom_t*)b) : strcmp((char*)a, (char*)b) == 0; }
 
-/* Relational */
 double op_eq(char type, void* a, void* b) {
-    return type == NUMBER ? *(double*)a == *(double*)b : strcmp((char*)a, (char*)b) == 0; }
+    return type == NUMBER ? *(double*)a == *(double*)b :  text_eq(type, a, b); }
 
 double op_ne(char type, void* a, void* b) {
-    return type == NUMBER ? *(double*)a != *(double*)b : strcmp((char*)a, (char*)b) != 0; }
+    return type == NUMBER ? *(double*)a != *(double*)b : !text_eq(type, a, b); }
 
 double op_lt(char type, void* a, void* b) {
-    return type == NUMBER ? *(double*)a  < *(double*)b : strcmp((char*)a, (char*)b)  < 0; }
+    return type == NUMBER ? *(double*)a  < *(double*)b : text_cmp(type, a, b)  < 0; }
 
 double op_gt(char type, void* a, void* b) {
-    return type == NUMBER ? *(double*)a  > *(double*)b : strcmp((char*)a, (char*)b)  > 0; }
+    return type == NUMBER ? *(double*)a  > *(double*)b : text_cmp(type, a, b)  > 0; }
 
 double op_le(char type, void* a, void* b) {
-    return type == NUMBER ? *(double*)a <= *(double*)b : strcmp((char*)a, (char*)b) <= 0; }
+    return type == NUMBER ? *(double*)a <= *(double*)b : text_cmp(type, a, b) <= 0; }
 
 double op_ge(char type, void* a, void* b) {
-    return type == NUMBER ? *(double*)a >= *(double*)b : strcmp((char*)a, (char*)b) >= 0; }
+    return type == NUMBER ? *(double*)a >= *(double*)b : text_cmp(type, a, b) >= 0; }
 
 /* Logical */
 double op_and(double a, double b) { return a && b; }
@@ -0,0 +1,162 @@
+/*
+Output.
+All interpreter output goes through a user-space buffer which is written to stdout with
+write(2) when it is full, on explicit flush and at exit.  When stdout is a terminal the
+buffer is also flushed after every newline.  In memory mode the buffer grows to keep
+all output until the owner takes it, the evaluation server captures output this way.
+
+Every interpreter context has its own buffer, output routines use the buffer of the
+current context.  Without a context output is written through.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include "alisp.h"
+
+/* Write n bytes to a file descriptor, retrying on interrupts. */
+static void write_all(int fd, const char* s, size_t n) {
+    size_t done = 0;
+    ssize_t k;
+    while (done < n) {
+        k = write(fd, s + done, n - done);
+        if (k < 0) {
+            if (errno == EINTR)
+                continue;
+            return;  // output is gone, drop the rest
+        }
+        done += k;
+    }
+}
+
+/* Arrange for the buffer of the current context to be flushed at exit. */
+void out_init() {
+    static int initialized = 0;
+    if (initialized)
+        return;
+    initialized = 1;
+    atexit(out_flush);
+}
+
+/*
+--------------------------------------
+out_open
+
+    Set up an output buffer writing to the file descriptor.
+--------------------------------------
+*/
+void out_open(output_t* o, int fd) {
+    o->buf = malloc(OUT_BUFSIZE);
+    o->len = 0;
+    o->max = OUT_BUFSIZE;
+    o->fd = fd;
+    o->mode = isatty(fd) ? OUT_LINE : OUT_FULL;
+}
+
+/* Flush and deallocate an output buffer. */
+void out_close(output_t* o) {
+    if (o->len)
+        write_all(o->fd, o->buf, o->len);
+    o->len = 0;
+    safe_free(o->buf);
+}
+
+/* Set buffering mode: OUT_FULL, OUT_LINE or OUT_MEMORY. */
+void out_setmode(int mode) {
+    if (ctx_cur)
+        ctx_cur->out.mode = mode;
+}
+
+/*
+--------------------------------------
+out_flush
+
+    Write pending output.
+--------------------------------------
+*/
+void out_flush() {
+    if (!ctx_cur || !ctx_cur->out.buf || ctx_cur->out.mode == OUT_MEMORY)
+        return;
+    output_t* o = &ctx_cur->out;
+    write_all(o->fd, o->buf, o->len);
+    o->len = 0;
+}
+
+/*
+--------------------------------------
+out_write
+
+    Append n bytes to the output buffer.
+--------------------------------------
+*/
+void out_write(const char* s, size_t n) {
+    if (!ctx_cur || !ctx_cur->out.buf) {
+        write_all(OUT_FD, s, n);
+        return;
+    }
+    output_t* o = &ctx_cur->out;
+    int newline = o->mode == OUT_LINE && memchr(s, '\n', n);
+
+    if (o->mode == OUT_MEMORY && o->len + n > o->max) {
+        while (o->len + n > o->max)
+            o->max *= 2;
+        o->buf = realloc(o->buf, o->max);
+    } else if (o->len + n > o->max) {
+        out_flush();
+        if (n > o->max) {  // too large to buffer, write through
+            write_all(o->fd, s, n);
+            return;
+        }
+    }
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+
+    if (newline)
+        out_flush();
+}
+
+/* Append a string. */
+void out_str(const char* s) {
+    out_write(s, strlen(s));
+}
+
+/* Append a character. */
+void out_char(char c) {
+    output_t* o = ctx_cur ? &ctx_cur->out : NULL;
+    if (o && o->buf && o->len < o->max && (c != '\n' || o->mode != OUT_LINE))
+        o->buf[o->len++] = c;
+    else
+        out_write(&c, 1);
+}
+
+/* Append a number, formatted the same way as atom_tostr does. */
+void out_num(double x) {
+    char tmp[64];
+    int n = snprintf(tmp, sizeof(tmp), "%g", x);
+    out_write(tmp, n);
+}
+
+/* Append formatted output. */
+void out_printf(const char* fmt, ...) {
+    char tmp[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+    if ((size_t)n < sizeof(tmp)) {
+        out_write(tmp, n);
+        return;
+    }
+    // Didn't fit, format into a heap buffer
+    char* s = malloc(n + 1);
+    va_start(ap, fmt);
+    vsnprintf(s, n + 1, fmt, ap);
+    va_end(ap);
+    out_write(s, n);
+    safe_free(s);
+}
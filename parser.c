@@ -2,6 +2,13 @@
 Alisp source code parser.
 Can be used for parsing source file, or input line in REPL mode.  Produces parse tree
 coposed of atom list nodes as branches and other atom types as leaves.
+
+Parse tree lives in an arena: nodes are laid out in pre-order, each list node followed by
+the contiguous array of its children, and the whole tree is freed by resetting the arena.
+Tree atoms carry F_ARENA flag and are ignored by binding and deallocation routines.
+
+All parser state is kept in a parser_t, so several parsers can run at once.  Large
+sources can be split at top level expression boundaries and parsed on a thread pool.
 */
 
 #include <stdio.h>
@@ -10,109 +17,373 @@ coposed of atom list nodes as branches and other atom types as leaves.
 #include <ctype.h>
 #include "alisp.h"
 
-token_t** tokens = NULL;        // list of tokens
-token_t** tok = NULL;           // token pointer
-
 
-// ---------------------------------------------------------------------- 
+// ----------------------------------------------------------------------
 // Parse
 
 /*
 --------------------------------------
 parse
 
-    Take a string and return a parse tree.
+    Take a string and return a parse tree allocated in the arena.
 --------------------------------------
 */
-atom_t* parse() {
-    tokenize();
-    if (!tokens)                    // error during tokenizing
-        return NULL;
+atom_t* parse(const char* src, arena_t* a) {
+    parser_t p;
+    parser_init(&p, src, src + strlen(src), src, a);
+
+    atom_t* ptree = NULL;
+    tokenize(&p);
 
+    if (p.tokens) {
 #ifdef DEBUG
-printf("....  parse:                   %d tokens found\n", tok_len());
+printf("....  parse:                   %d tokens found\n", p.ntok);
 #endif
+        ptree = read_top(&p, 1);
+        tokens_del(&p);
+    }
 
-    token_t** tok_end = tokens + tok_len();
-    atom_t* item = read_from_tokens();
+    parser_report(&p);
+    return ptree;
+}
 
-    if (!item) {                    // error during parsing
-        tokens_del();
-        return NULL;
+/*
+--------------------------------------
+read_top
 
-    } else if (tok == tok_end) {    // a single item
-        tokens_del();
-        return item;
-
-    } else {                        // multiple items
-        atom_t* ptree = list();
-        list_add(ptree, sym("block"));
-        list_add(ptree, item);
-
-        while (tok != tok_end) {
-            if ((item = read_from_tokens())) {
-                list_add(ptree, item);
-            } else {
-                atom_del(ptree);
-                tokens_del();
-                return NULL;
-            }
-        }
-        tokens_del();
+    Read all top level expressions.  With block set, return a single expression as is
+    and wrap several into a (block ...) statement.  Otherwise return a list of them.
+--------------------------------------
+*/
+atom_t* read_top(parser_t* p, int block) {
+    token_t** tok_end = p->tokens + p->ntok;
+    int ntop = count_subexpr(p);
+    atom_t* ptree;
+
+    if (block && ntop <= 1) {       // a single item
+        ptree = read_from_tokens(p);
+        if (ptree && p->tok != tok_end)
+            ptree = read_from_tokens(p);  // stray ')', report it
         return ptree;
     }
+
+    // multiple items
+    ptree = node_list(p->arena, ntop + block);
+    list_t* l = ptree->val.list;
+    if (block)
+        l->items[l->len++] = node_sym(p->arena, "block", 5);
+
+    while (p->tok != tok_end) {
+        atom_t* item = read_from_tokens(p);
+        if (!item)
+            return NULL;
+        l->items[l->len++] = item;
+    }
+    return ptree;
 }
 
 /* Read an expression from a sequence of tokens. */
-atom_t* read_from_tokens() {
-    if (tok == tokens + tok_len()) {
-        errmsg("Syntax", "unexpected EOF while reading", NULL, NULL);
+atom_t* read_from_tokens(parser_t* p) {
+    if ((*p->tok)->val[0] == '\0') {  // terminating token
+        parser_error(p, "Syntax", "unexpected EOF while reading", NULL);
         return NULL;
     }
 
-    token_t* token = *tok++;
+    token_t* token = *p->tok++;
 
     if (streq(token->val, "(")) {
-        atom_t* l = list();
+        atom_t* l = node_list(p->arena, token->n);
+        list_t* ll = l->val.list;
         atom_t* a;
-        while (!streq((*tok)->val, ")")) {
-            if ((a = read_from_tokens()))
-                list_add(l, a);
+        while (!streq((*p->tok)->val, ")")) {
+            if ((a = read_from_tokens(p)))
+                ll->items[ll->len++] = a;
             else
                 return NULL;
         }
-        ++tok;  // pop ')'
+        ++p->tok;  // pop ')'
         return l;
 
     } else if (streq(token->val, ")")) {
-        errmsg("Syntax", "unexpected ')'", token->pos, input);
+        parser_error(p, "Syntax", "unexpected ')'", token->pos);
         return NULL;
 
     } else {
-        return make_atom(token);
+        return make_atom(p, token);
     }
 }
 
 /* Convert a token into an atomic object. */
-atom_t* make_atom(token_t* token) {
-    if (!strlen(token->val)) {
+atom_t* make_atom(parser_t* p, token_t* token) {
+    size_t len = strlen(token->val);
+    if (!len) {
         printf("\x1b[95m" "Fatal error: make_atom: zero-length token!\n" "\x1b[0m");
         exit(EXIT_FAILURE);
     }
+    if (token->val[0] == '"') {                     // quoted string
+        size_t n = len > 1 && token->val[len - 1] == '"' ? len - 2 : len - 1;
+        return node_str(p->arena, token->val + 1, n);
+    }
     char* t;
     double x = strtod(token->val, &t);
     if (*t == '\0') {
-        return num(x);           // number
+        return node_num(p->arena, x);               // number
     } else if (x) {
-        errmsg("Syntax", "invalid symbol", token->pos, input);
+        parser_error(p, "Syntax", "invalid symbol", token->pos);
         return NULL;
     } else {
-        return sym(token->val);  // symbol
+        return node_sym(p->arena, token->val, len); // symbol
+    }
+}
+
+/*
+--------------------------------------
+count_subexpr
+
+    Record the number of subexpressions in every '(' token.
+    Return the number of top level expressions.
+--------------------------------------
+*/
+int count_subexpr(parser_t* p) {
+    token_t** open = malloc((p->ntok + 1) * sizeof(token_t*));  // stack of open parens
+    int depth = 0, ntop = 0;
+
+    for (unsigned i = 0; i < p->ntok; ++i) {
+        token_t* t = p->tokens[i];
+        if (streq(t->val, ")")) {
+            if (depth)
+                --depth;
+            continue;
+        }
+        if (depth)
+            ++open[depth - 1]->n;
+        else
+            ++ntop;
+        if (streq(t->val, "(")) {
+            t->n = 0;
+            open[depth++] = t;
+        }
     }
+
+    safe_free(open);
+    return ntop;
+}
+
+/* Allocate a parse tree node. */
+atom_t* node_new(arena_t* a, char type) {
+    atom_t* obj = arena_alloc(a, sizeof(atom_t));
+    obj->type = type;
+    obj->flags = F_ARENA;
+    obj->bindings = 0;
+    return obj;
 }
 
+/* Make a number node. */
+atom_t* node_num(arena_t* a, double x) {
+    atom_t* obj = node_new(a, NUMBER);
+    obj->val.num = arena_alloc(a, sizeof(double));
+    *obj->val.num = x;
+    return obj;
+}
+
+/* Make a symbol node. */
+atom_t* node_sym(arena_t* a, const char* s, size_t len) {
+    atom_t* obj = node_new(a, SYMBOL);
+    obj->val.sym = arena_strdup(a, s, len);
+    return obj;
+}
+
+/* Make a string node. */
+atom_t* node_str(arena_t* a, const char* s, size_t len) {
+    atom_t* obj = node_new(a, STRING);
+    string_t* str = arena_alloc(a, sizeof(string_t));
+    str->len = len;
+    str->hash = 0;
+    str->data = arena_strdup(a, s, len);
+    obj->val.str = str;
+    return obj;
+}
+
+/* Make a list node with room for n items. */
+atom_t* node_list(arena_t* a, int n) {
+    atom_t* obj = node_new(a, LIST);
+    list_t* l = arena_alloc(a, sizeof(list_t));
+    l->bindlist = NULL;
+    l->lock = 0;
+    l->len = 0;
+    l->maxlen = n;
+    l->head = 0;
+    l->items = arena_alloc(a, n * sizeof(atom_t*));
+    l->base = NULL;
+    l->slices = 0;
+    obj->val.list = l;
+    return obj;
+}
+
+
+// ----------------------------------------------------------------------
+// Parser state
+
+/* Set up parser for the text in [src, end).  Errors are reported against ctx string. */
+void parser_init(parser_t* p, const char* src, const char* end, const char* ctx,
+                 arena_t* a) {
+    p->input = src;
+    p->end = end;
+    p->context = ctx;
+    p->tokens = NULL;
+    p->tok = NULL;
+    p->ntok = 0;
+    p->arena = a;
+    p->errtype = NULL;
+    p->errmsg = NULL;
+    p->errpos = NULL;
+}
 
-// ---------------------------------------------------------------------- 
+/* Remember an error.  Only the first one is kept. */
+void parser_error(parser_t* p, const char* type, const char* msg, const char* pos) {
+    if (p->errtype)
+        return;
+    p->errtype = type;
+    p->errmsg = msg;
+    p->errpos = pos;
+}
+
+/* Display pending error, if any. Return 1 if there was one. */
+int parser_report(parser_t* p) {
+    if (!p->errtype)
+        return 0;
+    errmsg(p->errtype, p->errmsg, p->errpos, p->errpos ? p->context : NULL);
+    return 1;
+}
+
+
+// ----------------------------------------------------------------------
+// Parallel parse
+
+/* Chunk of source parsed by one job. */
+typedef struct {
+    parser_t p;
+    atom_t*  items;  // list of top level expressions
+} chunk_t;
+
+/* Job: parse a chunk. */
+static void parse_chunk(void* arg) {
+    chunk_t* c = arg;
+    tokenize(&c->p);
+    if (c->p.tokens) {
+        c->items = read_top(&c->p, 0);
+        tokens_del(&c->p);
+    }
+}
+
+/*
+--------------------------------------
+split_top
+
+    Find top level expression boundaries in [src, end), skipping strings and comments.
+    Cut the text into pieces of at least size bytes each.  Fill cuts with piece ends,
+    return the number of pieces.
+--------------------------------------
+*/
+int split_top(const char* src, const char* end, size_t size, const char** cuts, int maxcuts) {
+    const char* p = src;
+    const char* start = src;
+    int depth = 0, n = 0;
+
+    while (p < end && n < maxcuts - 1) {
+        char c = *p++;
+        if (c == '"') {
+            for (; p < end && (*p != '"' || p[-1] == '\\'); ++p);
+            if (p < end)
+                ++p;
+        } else if (c == '#') {
+            p = memchr(p, '\n', end - p);
+            if (!p)
+                p = end;
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            if (depth)
+                --depth;
+        } else
+            continue;
+
+        if (depth == 0 && c != '#' && (size_t)(p - start) >= size) {
+            cuts[n++] = p;
+            start = p;
+        }
+    }
+    cuts[n++] = end;
+    return n;
+}
+
+/*
+--------------------------------------
+parse_parallel
+
+    Same as parse, but split the source into chunks at top level expressions and
+    parse them on a pool of threads.  Chunk trees are stitched together in order.
+--------------------------------------
+*/
+atom_t* parse_parallel(const char* src, arena_t* a, pool_t* pool) {
+    size_t len = strlen(src);
+    int jobs = pool_size(pool);
+    if (jobs < 2 || len < PARSE_CHUNK)
+        return parse(src, a);
+
+    // Split
+    int maxcuts = jobs * 4;
+    size_t size = len / maxcuts > PARSE_CHUNK ? len / maxcuts : PARSE_CHUNK;
+    const char** cuts = malloc(maxcuts * sizeof(char*));
+    int n = split_top(src, src + len, size, cuts, maxcuts);
+
+    // Parse chunks
+    chunk_t* chunks = malloc(n * sizeof(chunk_t));
+    for (int i = 0; i < n; ++i) {
+        const char* from = i ? cuts[i - 1] : src;
+        parser_init(&chunks[i].p, from, cuts[i], src, arena_new(cuts[i] - from));
+        chunks[i].items = NULL;
+        pool_submit(pool, parse_chunk, &chunks[i]);
+    }
+    pool_wait(pool);
+
+    // Stitch
+    atom_t* ptree = NULL;
+    int total = 0, failed = 0;
+    for (int i = 0; i < n; ++i) {
+        if (!failed && parser_report(&chunks[i].p))
+            failed = 1;  // report the first error only, like a sequential parse does
+        if (chunks[i].items)
+            total += list_len(chunks[i].items);
+    }
+
+    if (!failed && total == 1) {
+        for (int i = 0; i < n; ++i)
+            if (chunks[i].items && list_len(chunks[i].items))
+                ptree = chunks[i].items->val.list->items[0];
+
+    } else if (!failed && total > 1) {
+        ptree = node_list(a, total + 1);
+        list_t* l = ptree->val.list;
+        l->items[l->len++] = node_sym(a, "block", 5);
+        for (int i = 0; i < n; ++i) {
+            if (!chunks[i].items)
+                continue;
+            list_t* cl = chunks[i].items->val.list;
+            memcpy(l->items + l->len, cl->items, cl->len * sizeof(atom_t*));
+            l->len += cl->len;
+        }
+    }
+
+    for (int i = 0; i < n; ++i)
+        arena_adopt(a, chunks[i].p.arena);  // chunk trees live as long as the result
+    safe_free(chunks);
+    safe_free(cuts);
+    return ptree;
+}
+
+
+// ----------------------------------------------------------------------
 // Tokenize
 
 /*
@@ -122,36 +393,37 @@ tokenize
     Convert a string into a list of tokens.
 --------------------------------------
 */
-void tokenize() {
-    tokens = NULL, tok = NULL;
+void tokenize(parser_t* ps) {
+    ps->tokens = NULL, ps->tok = NULL, ps->ntok = 0;
 
     // Count the number of tokens and catch lexical errors
     unsigned n;
     const char* p;
+    const char* end = ps->end;
 
-    for (n = 0, p = input; *p != '\0'; ++n) {
-        while (*p != '\0' && (isspace(*p) || *p == '#')) {        
-            for (; isspace(*p); ++p);       // skip white space
-            if (*p == '#')                  // skip comment
-                for (; *p != '\n' && *p != '\0'; ++p);
+    for (n = 0, p = ps->input; p < end; ++n) {
+        while (p < end && (isspace(*p) || *p == '#')) {
+            for (; p < end && isspace(*p); ++p);    // skip white space
+            if (p < end && *p == '#')               // skip comment
+                for (; p < end && *p != '\n'; ++p);
         }
-        if (*p == '\0')
+        if (p == end)
             break;
-        
+
         if (strchr(DELIM, *p)) {        // parenthesis
             ++p;
         } else if (*p == '"') {         // quoted string
-            while (*(++p) != '\0' && (*p != '"' || *(p-1) == '\\'));
-            if (*p == '"')
+            while (++p < end && (*p != '"' || *(p-1) == '\\'));
+            if (p < end)
                 p++;
         } else if (isgraph(*p)) {       // number or symbol
-            while (*(++p) != '\0' && isgraph(*p) && !strchr(DELIM, *p))
+            while (++p < end && isgraph(*p) && !strchr(DELIM, *p))
                 if (strchr(RESERVED, *p)) {
-                    errmsg("Lexical", "invalid symbol", p, input);
+                    parser_error(ps, "Lexical", "invalid symbol", p);
                     return;
                 }
         } else {                        // bad character
-            errmsg("Lexical", "bad character", p, input);
+            parser_error(ps, "Lexical", "bad character", p);
             return;
         }
     }
@@ -160,20 +432,22 @@ void tokenize() {
         return;
 
     // Create list of tokens
-    tokens = (token_t**)malloc((n + 1) * sizeof(token_t*));
+    token_t** tok;
+    ps->tokens = (token_t**)malloc((n + 1) * sizeof(token_t*));
+    ps->ntok = n;
     const char* p0;
     int i;
     char* tmp;
 
-    for (tok = tokens, p = input; *p != '\0'; ++tok) {
-        while (*p != '\0' && (isspace(*p) || *p == '#')) {        
-            for (; isspace(*p); ++p);       // skip white space
-            if (*p == '#')                  // skip comment
-                for (; *p != '\n' && *p != '\0'; ++p);
+    for (tok = ps->tokens, p = ps->input; p < end; ++tok) {
+        while (p < end && (isspace(*p) || *p == '#')) {
+            for (; p < end && isspace(*p); ++p);    // skip white space
+            if (p < end && *p == '#')               // skip comment
+                for (; p < end && *p != '\n'; ++p);
         }
-        if (*p == '\0')
+        if (p == end)
             break;
-        
+
         if (strchr(DELIM, *p)) {        // parenthesis
             tmp = (char*)malloc(2);
             tmp[0] = *p, tmp[1] = '\0';
@@ -181,17 +455,17 @@ void tokenize() {
 
         } else if (*p == '"') {         // quoted string
             p0 = p;
-            for (i = 1; *(++p) != '\0' && (*p != '"' || *(p-1) == '\\'); ++i);
-            if (*p == '"')
+            for (i = 1; ++p < end && (*p != '"' || *(p-1) == '\\'); ++i);
+            if (p < end)
                 ++p, ++i;
             tmp = (char*)malloc(i + 1);
             memcpy(tmp, p0, i);
             tmp[i]= '\0';
             *tok = tok_new(tmp, p0);
-        
+
         } else {                        // number or symbol
             p0 = p;
-            for (i = 1; *(++p) != '\0' && isgraph(*p) && !strchr(DELIM, *p); ++i);
+            for (i = 1; ++p < end && isgraph(*p) && !strchr(DELIM, *p); ++i);
             tmp = (char*)malloc(i + 1);
             memcpy(tmp, p0, i);
             tmp[i]= '\0';
@@ -204,30 +478,26 @@ void tokenize() {
     *tmp = '\0';
     *tok = tok_new(tmp, NULL);
 
-    tok = tokens;  // reset token pointer
+    ps->tok = ps->tokens;  // reset token pointer
 }
 
 /* Create a token. */
 token_t* tok_new(char* v, const char* p) {
     token_t* t = (token_t*)malloc(sizeof(token_t));
-    t->val = v, t->pos = p;
+    t->val = v, t->pos = p, t->n = 0;
     return t;
 }
 
-/* Return length of token list. */
-unsigned tok_len() {
-    unsigned i;
-    for (i = 0; *tokens[i]->val != '\0'; ++i);
-    return i;
-}
-
 /* Deallocate tokens. */
-void tokens_del() {
-    for (tok = tokens; (*tok)->val[0] != '\0'; ++tok) {
+void tokens_del(parser_t* p) {
+    token_t** tok;
+    for (tok = p->tokens; (*tok)->val[0] != '\0'; ++tok) {
         safe_free((*tok)->val);
         safe_free(*tok);
     }
     safe_free((*tok)->val);
     safe_free(*tok);
-    safe_free(tokens);
+    safe_free(p->tokens);
+    p->tok = NULL;
+    p->ntok = 0;
 }
@@ -0,0 +1,265 @@
+/*
+Thread pool: a fixed set of worker threads running jobs, with work stealing.
+Every worker has its own queue.  Jobs submitted by a worker go to its own queue and
+are taken back newest first, which keeps nested jobs close to their parent; jobs
+submitted from other threads are dealt to the queues in turn.  A worker that runs out
+of jobs steals the oldest job of another worker before going to sleep.
+
+Threads waiting for a result of a job can help with pending jobs instead of blocking
+(pool_help), so jobs may wait for jobs they submit without exhausting the workers.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "alisp.h"
+
+/* Job */
+typedef struct {
+    void (*fn)(void*);
+    void* arg;
+} job_t;
+
+/* Job queue of a worker */
+typedef struct {
+    job_t*          jobs;       // ring buffer: thieves take at head, owner at tail
+    int             head;
+    int             len;
+    int             max;
+    pthread_mutex_t lock;
+} jobq_t;
+
+/* Thread pool */
+struct Pool {
+    pthread_t*      threads;
+    int             nthreads;
+    jobq_t*         queues;     // queue of every worker
+    unsigned        next;       // queue for the next job submitted from outside
+    int             queued;     // number of jobs in queues
+    int             active;     // number of jobs being run
+    int             sleeping;   // number of idle workers
+    int             stop;
+    pthread_mutex_t lock;
+    pthread_cond_t  work;       // signalled when a job is queued
+    pthread_cond_t  done;       // signalled when the pool runs dry
+};
+
+/* Worker identity of the calling thread */
+static __thread pool_t* self_pool = NULL;
+static __thread int     self_id = -1;
+
+#define load(x)     __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define add(x, n)   __atomic_add_fetch(&(x), n, __ATOMIC_SEQ_CST)
+
+/* Put a job to the tail of a queue. */
+static void jobq_push(jobq_t* q, job_t job) {
+    pthread_mutex_lock(&q->lock);
+    if (q->len == q->max) {  // allocate more space, unwrapping the ring
+        job_t* jobs = malloc(q->max * 2 * sizeof(job_t));
+        for (int i = 0; i < q->len; ++i)
+            jobs[i] = q->jobs[(q->head + i) % q->max];
+        safe_free(q->jobs);
+        q->jobs = jobs;
+        q->head = 0;
+        q->max *= 2;
+    }
+    q->jobs[(q->head + q->len) % q->max] = job;
+    add(q->len, 1);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* Take a job from the tail (own queue) or the head (stealing). Return 0 if empty. */
+static int jobq_take(jobq_t* q, job_t* job, int steal) {
+    if (!load(q->len))
+        return 0;
+    pthread_mutex_lock(&q->lock);
+    int ok = q->len > 0;
+    if (ok) {
+        if (steal) {
+            *job = q->jobs[q->head];
+            q->head = (q->head + 1) % q->max;
+        } else
+            *job = q->jobs[(q->head + q->len - 1) % q->max];
+        add(q->len, -1);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+/*
+--------------------------------------
+pool_take
+
+    Find a job for a worker (or any thread if id is -1): own queue first, then the
+    others.  The job is counted as active.  Return 0 if there are no jobs.
+--------------------------------------
+*/
+static int pool_take(pool_t* pool, int id, job_t* job) {
+    int n = pool->nthreads;
+    int start = id >= 0 ? id : 0;
+    for (int i = 0; i < n; ++i) {
+        int k = (start + i) % n;
+        if (jobq_take(&pool->queues[k], job, k != id)) {
+            add(pool->active, 1);  // before queued drops, so the pool never looks dry
+            add(pool->queued, -1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Run a taken job. */
+static void pool_run(pool_t* pool, job_t job) {
+    job.fn(job.arg);
+    pthread_mutex_lock(&pool->lock);
+    if (!add(pool->active, -1) && !load(pool->queued))
+        pthread_cond_broadcast(&pool->done);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Worker thread. */
+static void* worker(void* arg) {
+    pool_t* pool = arg;
+    job_t job;
+    int id;
+
+    pthread_mutex_lock(&pool->lock);
+    for (id = 0; !pthread_equal(pool->threads[id], pthread_self()); ++id);
+    pthread_mutex_unlock(&pool->lock);
+    self_pool = pool;
+    self_id = id;
+
+    while (1) {
+        if (pool_take(pool, id, &job)) {
+            pool_run(pool, job);
+            continue;
+        }
+
+        // Nothing to do: sleep until a job is queued
+        pthread_mutex_lock(&pool->lock);
+        add(pool->sleeping, 1);
+        while (!load(pool->queued) && !pool->stop)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        add(pool->sleeping, -1);
+        int stop = pool->stop && !load(pool->queued);
+        pthread_mutex_unlock(&pool->lock);
+        if (stop)
+            break;
+    }
+    return NULL;
+}
+
+/*
+--------------------------------------
+pool_new
+
+    Make a pool of n threads.
+--------------------------------------
+*/
+pool_t* pool_new(int n) {
+    if (n < 1)
+        n = 1;
+    pool_t* pool = malloc(sizeof(pool_t));
+    pool->nthreads = n;
+    pool->threads = malloc(n * sizeof(pthread_t));
+    pool->queues = malloc(n * sizeof(jobq_t));
+    for (int i = 0; i < n; ++i) {
+        pool->queues[i].head = pool->queues[i].len = 0;
+        pool->queues[i].max = 16;
+        pool->queues[i].jobs = malloc(16 * sizeof(job_t));
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+    pool->next = 0;
+    pool->queued = pool->active = pool->sleeping = 0;
+    pool->stop = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Workers find their number in threads[], so hold the lock until it is filled
+    pthread_mutex_lock(&pool->lock);
+    for (int i = 0; i < n; ++i)
+        if (pthread_create(&pool->threads[i], NULL, worker, pool)) {
+            printf("\x1b[95m" "Fatal error: pool_new: failed to start a thread!\n" "\x1b[0m");
+            exit(EXIT_FAILURE);
+        }
+    pthread_mutex_unlock(&pool->lock);
+    return pool;
+}
+
+/*
+--------------------------------------
+pool_submit
+
+    Queue a job.
+--------------------------------------
+*/
+void pool_submit(pool_t* pool, void (*fn)(void*), void* arg) {
+    int k = self_pool == pool ? self_id : (int)(add(pool->next, 1) % pool->nthreads);
+    jobq_push(&pool->queues[k], (job_t){fn, arg});
+    add(pool->queued, 1);
+
+    // A worker going to sleep checks the count after announcing itself
+    if (load(pool->sleeping)) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/*
+--------------------------------------
+pool_help
+
+    Run one pending job on the calling thread. Return 0 if there was none.
+--------------------------------------
+*/
+int pool_help(pool_t* pool) {
+    job_t job;
+    if (!pool_take(pool, self_pool == pool ? self_id : -1, &job))
+        return 0;
+    pool_run(pool, job);
+    return 1;
+}
+
+/*
+--------------------------------------
+pool_wait
+
+    Wait until all queued jobs are finished.
+--------------------------------------
+*/
+void pool_wait(pool_t* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (load(pool->queued) || load(pool->active))
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Return the number of threads. */
+int pool_size(pool_t* pool) {
+    return pool ? pool->nthreads : 0;
+}
+
+/* Finish queued jobs and deallocate the pool. */
+void pool_del(pool_t* pool) {
+    if (!pool)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->nthreads; ++i)
+        pthread_join(pool->threads[i], NULL);
+
+    for (int i = 0; i < pool->nthreads; ++i) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+        safe_free(pool->queues[i].jobs);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    safe_free(pool->queues);
+    safe_free(pool->threads);
+    safe_free(pool);
+}
@@ -0,0 +1,245 @@
+/*
+Priority queue: items in a binary heap, the first of them on top.
+
+Without a procedure, every item has a priority, a number kept unboxed in an array
+next to the items, and the smallest priority comes out first.  With a procedure, the
+items are ordered by it the way sort orders them: the item it puts first comes out
+first.  Items and the procedure are bound to the queue like items of a list.
+
+Pushing an item moves it up from the end, popping moves the last item down from the
+top, both in O(log n) comparisons.  Items are swapped on the way, so the queue is
+whole while the procedure runs, but the procedure can't push to or pop from the queue
+it orders.  An error in the procedure while pushing leaves the new item where it
+stopped; while popping, the swaps are undone and the queue is left as it was.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alisp.h"
+
+/*
+--------------------------------------
+pq_new
+
+    Make a priority queue, ordered by a procedure or by priorities if proc is NULL.
+--------------------------------------
+*/
+atom_t* pq_new(atom_t* proc) {
+    pqueue_t* q = malloc(sizeof(pqueue_t));
+    q->bindlist = NULL;
+    q->lock = 0;
+    q->busy = 0;
+    q->len = 0;
+    q->maxlen = 8;
+    q->items = malloc(q->maxlen * sizeof(atom_t*));
+    q->prios = malloc(q->maxlen * sizeof(double));
+    q->proc = NULL;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.pq = q;
+    obj->type = PQUEUE;
+    obj->flags = 0;
+    obj->bindings = 0;
+    if (proc) {
+        q->proc = proc;
+        atom_bind(proc, obj);
+    }
+    return obj;
+}
+
+/*
+--------------------------------------
+pq_del
+
+    Deallocate a priority queue.
+--------------------------------------
+*/
+void pq_del(atom_t* obj) {
+    pqueue_t* q = obj->val.pq;
+    q->lock = 1;  // lock this object
+
+    // Deallocate bound items and the procedure
+    for (int i = 0; i <= q->len; ++i) {
+        atom_t* item = i < q->len ? q->items[i] : q->proc;
+        if (item && !(atom_is_container(item) && item->val.list->lock)) {
+            atom_unbind(item, obj);
+            atom_del(item);
+        }
+    }
+
+    safe_free(q->items);
+    safe_free(q->prios);
+    list_free(q->bindlist);
+    safe_free(q);
+    safe_free(obj);
+}
+
+/* Number of items. */
+int pq_len(atom_t* obj) {
+    return obj->val.pq->len;
+}
+
+/* Procedure ordering the items, or NULL. */
+atom_t* pq_proc(atom_t* obj) {
+    return obj->val.pq->proc;
+}
+
+/* Return the first item, or NULL if the queue is empty. */
+atom_t* pq_peek(atom_t* obj) {
+    pqueue_t* q = obj->val.pq;
+    return q->len ? q->items[0] : NULL;
+}
+
+/* Append an item at the end of the heap, keeping its place: for images. */
+void pq_append(atom_t* obj, atom_t* item, double prio) {
+    pqueue_t* q = obj->val.pq;
+    if (q->len == q->maxlen) {
+        q->maxlen *= 2;
+        q->items = realloc(q->items, q->maxlen * sizeof(atom_t*));
+        q->prios = realloc(q->prios, q->maxlen * sizeof(double));
+    }
+    q->items[q->len] = item;
+    q->prios[q->len] = prio;
+    ++q->len;
+    atom_bind(item, obj);
+}
+
+/* Priority of the item at index i of the heap. */
+double pq_prio(atom_t* obj, int i) {
+    return obj->val.pq->prios[i];
+}
+
+/* Item at index i of the heap. */
+atom_t* pq_item(atom_t* obj, int i) {
+    return obj->val.pq->items[i];
+}
+
+/* True if the item at index a goes before the one at b. */
+static int pq_less(pqueue_t* q, order_t* o, int a, int b) {
+    return q->proc ? order_less(o, q->items[a], q->items[b]) : q->prios[a] < q->prios[b];
+}
+
+/* Swap the items at indices a and b with their priorities. */
+static void pq_swap(pqueue_t* q, int a, int b) {
+    atom_t* t = q->items[a];
+    q->items[a] = q->items[b];
+    q->items[b] = t;
+    double p = q->prios[a];
+    q->prios[a] = q->prios[b];
+    q->prios[b] = p;
+}
+
+/* Report the queue being changed by its own procedure. Return 1 if it is. */
+static int pq_busy(pqueue_t* q, atom_t* expr) {
+    if (!q->busy)
+        return 0;
+    errmsg("Semantic", "queue is being ordered by its procedure", NULL, NULL);
+    list_print(expr, 0);
+    return 1;
+}
+
+/*
+--------------------------------------
+pq_push
+
+    Add an item with a priority, which is ignored if the queue has a procedure.
+    Return 0 on error.
+--------------------------------------
+*/
+int pq_push(alisp_ctx* ctx, atom_t* expr, atom_t* obj, atom_t* item, double prio) {
+    pqueue_t* q = obj->val.pq;
+    if (pq_busy(q, expr))
+        return 0;
+    pq_append(obj, item, q->proc ? 0 : prio);
+
+    order_t o;
+    order_init(&o, ctx, expr, q->proc);
+    q->busy = 1;
+    for (int i = q->len - 1; i > 0 && pq_less(q, &o, i, (i - 1) / 2); i = (i - 1) / 2)
+        pq_swap(q, i, (i - 1) / 2);
+    q->busy = 0;
+    return !o.err;
+}
+
+/*
+--------------------------------------
+pq_pop
+
+    Remove the first item and return it, or NULL on error, then the queue is left as
+    it was.  The item is no longer bound to the queue, the caller takes it over.
+--------------------------------------
+*/
+atom_t* pq_pop(alisp_ctx* ctx, atom_t* expr, atom_t* obj) {
+    pqueue_t* q = obj->val.pq;
+    if (pq_busy(q, expr))
+        return NULL;
+    atom_t* top = q->items[0];
+    pq_swap(q, 0, --q->len);
+
+    // Last item goes down from the top, past the first of its children
+    order_t o;
+    order_init(&o, ctx, expr, q->proc);
+    int path[32];  // indices the item went down to, at most one per bit of len
+    int n = 0;
+    q->busy = 1;
+    for (int i = 0, c = 1; c < q->len; i = c, c = 2 * c + 1) {
+        if (c + 1 < q->len && pq_less(q, &o, c + 1, c))
+            ++c;
+        if (!pq_less(q, &o, c, i))
+            break;
+        pq_swap(q, i, c);
+        path[n++] = c;
+    }
+    q->busy = 0;
+
+    if (o.err) {
+        // Move the item back up, and the first item back on top
+        for (int k = n - 1; k >= 0; --k)
+            pq_swap(q, k ? path[k - 1] : 0, path[k]);
+        pq_swap(q, 0, q->len++);
+        return NULL;
+    }
+    atom_unbind(top, obj);
+    return top;
+}
+
+/*
+--------------------------------------
+pq_tostr
+
+    Make a string representing a priority queue, items in heap order with their
+    priorities if there is no procedure.
+--------------------------------------
+*/
+char* pq_tostr(atom_t* obj, int depth) {
+    pqueue_t* q = obj->val.pq;
+    char* k;
+    char* o;
+    char buf[1024];
+    char tmp[64];
+    strcpy(buf, "pq{");
+
+    for (int i = 0; i < q->len; ++i) {
+        k = atom_tostring(q->items[i], depth ? depth - 1 : depth);
+        if (q->proc)
+            tmp[0] = '\0';
+        else
+            sprintf(tmp, " : %g", q->prios[i]);
+        if (strlen(buf) + strlen(k) + strlen(tmp) > 1000) {
+            safe_free(k);
+            strcat(buf, " ... ");
+            break;
+        }
+        strcat(buf, k);
+        strcat(buf, tmp);
+        safe_free(k);
+        if (i < q->len - 1)
+            strcat(buf, ", ");
+    }
+
+    strcat(buf, "}");
+    o = malloc(strlen(buf) + 1);
+    strcpy(o, buf);
+    return o;
+}
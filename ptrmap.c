@@ -0,0 +1,83 @@
+/*
+Pointer map: hash table from object addresses to values.
+Open addressing with linear probing, no removal.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "alisp.h"
+
+/* Slot of a key, multiplicative hashing of the address. */
+static size_t ptrmap_slot(const ptrmap_t* m, const void* key) {
+    uint64_t h = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & (m->max - 1);
+}
+
+/*
+--------------------------------------
+ptrmap_new
+
+    Make a map with room for about n entries.
+--------------------------------------
+*/
+ptrmap_t* ptrmap_new(size_t n) {
+    ptrmap_t* m = malloc(sizeof(ptrmap_t));
+    for (m->max = 16; m->max < 2 * n; m->max <<= 1);
+    m->len = 0;
+    m->keys = calloc(m->max, sizeof(void*));
+    m->vals = malloc(m->max * sizeof(void*));
+    return m;
+}
+
+/* Return value for the key, or NULL. */
+void* ptrmap_get(const ptrmap_t* m, const void* key) {
+    for (size_t i = ptrmap_slot(m, key); m->keys[i]; i = (i + 1) & (m->max - 1))
+        if (m->keys[i] == key)
+            return m->vals[i];
+    return NULL;
+}
+
+/*
+--------------------------------------
+ptrmap_put
+
+    Associate a value with the key.
+--------------------------------------
+*/
+void ptrmap_put(ptrmap_t* m, const void* key, void* val) {
+    // Keep load factor under 1/2
+    if (2 * (m->len + 1) > m->max) {
+        const void** keys = m->keys;
+        void** vals = m->vals;
+        size_t max = m->max;
+        m->max *= 2;
+        m->len = 0;
+        m->keys = calloc(m->max, sizeof(void*));
+        m->vals = malloc(m->max * sizeof(void*));
+        for (size_t i = 0; i < max; ++i)
+            if (keys[i])
+                ptrmap_put(m, keys[i], vals[i]);
+        free(keys);
+        free(vals);
+    }
+
+    size_t i;
+    for (i = ptrmap_slot(m, key); m->keys[i]; i = (i + 1) & (m->max - 1))
+        if (m->keys[i] == key) {
+            m->vals[i] = val;
+            return;
+        }
+    m->keys[i] = key;
+    m->vals[i] = val;
+    ++m->len;
+}
+
+/* Deallocate a map. */
+void ptrmap_del(ptrmap_t* m) {
+    if (!m)
+        return;
+    free(m->keys);
+    free(m->vals);
+    free(m);
+}
@@ -0,0 +1,388 @@
+/*
+Range and generator: lazy sequences, made an item at a time as they are walked.
+
+A range is numbers from start by step, as many as fit before stop: it keeps the
+three numbers only, and its items and subranges are computed by index.  A generator
+is a procedure and a first item: every next item is the procedure applied to the one
+before, until the procedure returns nil (NULL in Alisp); an error in the procedure
+aborts the walk.  Generators may be endless.
+
+Iteration operators walk sequences through an iterator, so map, filter, fold and the
+rest never build a list of the items.  Items of a range are made and deallocated one
+by one, an item of a generator is held by the iterator until the next one is made.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "alisp.h"
+
+/* Make a range of n numbers from start by step. */
+atom_t* range_make(double start, double step, int n) {
+    range_t* r = malloc(sizeof(range_t));
+    r->start = start;
+    r->step = step;
+    r->len = n;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.rng = r;
+    obj->type = RANGE;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/*
+--------------------------------------
+range_new
+
+    Make a range of numbers from start up to stop, not including it, by step.
+    Return NULL if step is zero or the range is too long.
+--------------------------------------
+*/
+atom_t* range_new(double start, double stop, double step) {
+    if (step == 0) {
+        errmsg("Semantic", "step is zero", NULL, NULL);
+        return NULL;
+    }
+    double count = ceil((stop - start) / step);
+    if (!(count <= INT_MAX)) {  // also NaN
+        errmsg("Semantic", "range is too long", NULL, NULL);
+        return NULL;
+    }
+    return range_make(start, step, count > 0 ? (int)count : 0);
+}
+
+/* Deallocate a range. */
+void range_del(atom_t* obj) {
+    safe_free(obj->val.rng);
+    safe_free(obj);
+}
+
+/* Copy a range. */
+atom_t* range_copy(atom_t* obj) {
+    range_t* r = obj->val.rng;
+    return range_make(r->start, r->step, r->len);
+}
+
+/* Number of items. */
+int range_len(atom_t* obj) {
+    return obj->val.rng->len;
+}
+
+/* Item at index i. */
+double range_item(atom_t* obj, int i) {
+    range_t* r = obj->val.rng;
+    return r->start + i * r->step;
+}
+
+/* Step between items. */
+double range_step(atom_t* obj) {
+    return obj->val.rng->step;
+}
+
+/* Return the range of items in [from, to), clamped to the range. */
+atom_t* range_slice(atom_t* obj, int from, int to) {
+    range_t* r = obj->val.rng;
+    if (from < 0)
+        from = 0;
+    if (to > r->len)
+        to = r->len;
+    return range_make(range_item(obj, from), r->step, to > from ? to - from : 0);
+}
+
+/* Make a string representing a range. */
+char* range_tostr(atom_t* obj) {
+    range_t* r = obj->val.rng;
+    char buf[128];
+    sprintf(buf, "range(%g, %g, %g)", r->start, range_item(obj, r->len), r->step);
+    return strdup(buf);
+}
+
+
+// ----------------------------------------------------------------------
+// Generators
+
+/*
+--------------------------------------
+gen_new
+
+    Make a generator of items from init on, each made of the one before by proc.
+    Both are bound to the generator, and may be NULL to be set later.
+--------------------------------------
+*/
+atom_t* gen_new(atom_t* proc, atom_t* init) {
+    generator_t* g = malloc(sizeof(generator_t));
+    g->bindlist = NULL;
+    g->lock = 0;
+    g->proc = NULL;
+    g->init = NULL;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.gen = g;
+    obj->type = GENERATOR;
+    obj->flags = 0;
+    obj->bindings = 0;
+    gen_set(obj, proc, init);
+    return obj;
+}
+
+/* Set the procedure and the first item of a generator that has none. */
+void gen_set(atom_t* obj, atom_t* proc, atom_t* init) {
+    generator_t* g = obj->val.gen;
+    if (proc) {
+        g->proc = proc;
+        atom_bind(proc, obj);
+    }
+    if (init) {
+        g->init = init;
+        atom_bind(init, obj);
+    }
+}
+
+/*
+--------------------------------------
+gen_del
+
+    Deallocate a generator.
+--------------------------------------
+*/
+void gen_del(atom_t* obj) {
+    generator_t* g = obj->val.gen;
+    g->lock = 1;  // lock this object
+
+    atom_t* parts[2] = {g->proc, g->init};
+    for (int i = 0; i < 2; ++i)
+        if (parts[i] && !(atom_is_container(parts[i]) && parts[i]->val.list->lock)) {
+            atom_unbind(parts[i], obj);
+            atom_del(parts[i]);
+        }
+
+    list_free(g->bindlist);
+    safe_free(g);
+    safe_free(obj);
+}
+
+/* Procedure of a generator. */
+atom_t* gen_proc(atom_t* obj) {
+    return obj->val.gen->proc;
+}
+
+/* First item of a generator. */
+atom_t* gen_init(atom_t* obj) {
+    return obj->val.gen->init;
+}
+
+
+// ----------------------------------------------------------------------
+// Iteration
+
+/* Check if an object is a lazy sequence: range or generator. */
+int seq_is(atom_t* obj) {
+    return obj->type == RANGE || obj->type == GENERATOR;
+}
+
+/* Start walking a sequence. */
+void iter_init(iter_t* it, alisp_ctx* ctx, atom_t* seq) {
+    it->seq = seq;
+    it->i = 0;
+    it->item = NULL;
+    it->env = ctx->active_env;
+}
+
+/*
+--------------------------------------
+iter_next
+
+    Return the next item of a sequence, or NULL at the end or on error, then ok is
+    set to 0.  The caller deallocates every item with atom_del when done with it,
+    items of ranges are new, items of generators are held by the iterator.
+--------------------------------------
+*/
+atom_t* iter_next(alisp_ctx* ctx, atom_t* expr, iter_t* it, int* ok) {
+    atom_t* seq = it->seq;
+    if (seq->type == RANGE)
+        return it->i < range_len(seq) ? num(range_item(seq, it->i++)) : NULL;
+
+    // Generator: first item, or the procedure applied to the last one
+    atom_t* prev = it->item;
+    atom_t* next = gen_init(seq);
+    if (prev) {
+        if (prev->type == NIL)
+            return NULL;  // ended already
+        next = apply_argv(ctx, expr, gen_proc(seq), 1, &prev);
+        if (!next) {
+            *ok = 0;
+            return NULL;
+        }
+        atom_bind(next, it->env);
+        atom_unbind(prev, it->env);
+        atom_del(prev);
+    } else
+        atom_bind(next, it->env);
+    it->item = next;
+    return next->type == NIL ? NULL : next;
+}
+
+/* Stop walking a sequence. */
+void iter_done(iter_t* it) {
+    if (it->item) {
+        atom_unbind(it->item, it->env);
+        atom_del(it->item);
+        it->item = NULL;
+    }
+}
+
+/*
+--------------------------------------
+seq_map
+
+    Return the list of a procedure applied to every item of a sequence, or with
+    filter the list of items it is true for, or NULL on error.
+--------------------------------------
+*/
+atom_t* seq_map(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t* seq, int filter) {
+    atom_t* env = ctx->active_env;
+    atom_t* v = list();
+    atom_bind(v, env);  // protect results while the procedure is applied
+    iter_t it;
+    iter_init(&it, ctx, seq);
+    atom_t* item;
+    int ok = 1;
+    while (ok && (item = iter_next(ctx, expr, &it, &ok))) {
+        atom_bind(item, env);
+        atom_t* r = apply_argv(ctx, expr, proc, 1, &item);
+        if (!r)
+            ok = 0;
+        else if (!filter)
+            list_add(v, r);
+        else {
+            if (atom_true(r))
+                list_add(v, item);
+            atom_del(r);
+        }
+        atom_unbind(item, env);
+        atom_del(item);
+    }
+    iter_done(&it);
+    atom_unbind(v, env);
+    if (!ok) {
+        atom_del(v);
+        return NULL;
+    }
+    return v;
+}
+
+/*
+--------------------------------------
+seq_fold
+
+    Fold the items of a sequence with a procedure of the accumulator and an item,
+    starting at acc, or at the first item if acc is NULL.  Return the result, or
+    NULL on error.
+--------------------------------------
+*/
+atom_t* seq_fold(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t* acc, atom_t* seq) {
+    atom_t* env = ctx->active_env;
+    iter_t it;
+    iter_init(&it, ctx, seq);
+    int ok = 1;
+    if (!acc && !(acc = iter_next(ctx, expr, &it, &ok))) {
+        if (ok) {
+            errmsg("Semantic", "sequence is empty", NULL, NULL);
+            list_print(expr, 0);
+        }
+        iter_done(&it);
+        return NULL;
+    }
+    atom_bind(acc, env);  // protect the accumulator until the next one is made
+
+    atom_t* item;
+    atom_t* args[2];
+    while (ok && (item = iter_next(ctx, expr, &it, &ok))) {
+        args[0] = acc;
+        args[1] = item;
+        atom_bind(item, env);
+        atom_t* r = apply_argv(ctx, expr, proc, 2, args);
+        if (r)
+            atom_bind(r, env);
+        else
+            ok = 0;
+        atom_unbind(acc, env);
+        atom_del(acc);
+        atom_unbind(item, env);
+        atom_del(item);
+        acc = r;
+    }
+    iter_done(&it);
+    if (!ok) {
+        if (acc) {
+            atom_unbind(acc, env);
+            atom_del(acc);
+        }
+        return NULL;
+    }
+    atom_unbind(acc, env);
+    return acc;
+}
+
+/* Apply a procedure to every item of a sequence. Return 0 on error. */
+int seq_foreach(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t* seq) {
+    atom_t* env = ctx->active_env;
+    iter_t it;
+    iter_init(&it, ctx, seq);
+    atom_t* item;
+    int ok = 1;
+    while (ok && (item = iter_next(ctx, expr, &it, &ok))) {
+        atom_bind(item, env);
+        atom_t* r = apply_argv(ctx, expr, proc, 1, &item);
+        if (r)
+            atom_del(r);
+        else
+            ok = 0;
+        atom_unbind(item, env);
+        atom_del(item);
+    }
+    iter_done(&it);
+    return ok;
+}
+
+/* Return the list of the items of a sequence, or NULL on error. */
+atom_t* seq_list(alisp_ctx* ctx, atom_t* expr, atom_t* seq) {
+    atom_t* env = ctx->active_env;
+    atom_t* v = list();
+    if (seq->type == RANGE)
+        list_reserve(v, range_len(seq));
+    atom_bind(v, env);
+    iter_t it;
+    iter_init(&it, ctx, seq);
+    atom_t* item;
+    int ok = 1;
+    while ((item = iter_next(ctx, expr, &it, &ok)))
+        list_add(v, item);
+    iter_done(&it);
+    atom_unbind(v, env);
+    if (!ok) {
+        atom_del(v);
+        return NULL;
+    }
+    return v;
+}
+
+/* Count the items of a sequence into n. Return 0 on error. */
+int seq_len(alisp_ctx* ctx, atom_t* expr, atom_t* seq, int* n) {
+    if (seq->type == RANGE) {
+        *n = range_len(seq);
+        return 1;
+    }
+    iter_t it;
+    iter_init(&it, ctx, seq);
+    atom_t* item;
+    int ok = 1;
+    for (*n = 0; (item = iter_next(ctx, expr, &it, &ok)); ++*n)
+        atom_del(item);
+    iter_done(&it);
+    return ok;
+}
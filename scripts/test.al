@@ -127,6 +127,156 @@
     (println "OK -- List item after assignment: " (list_get lst 2))
     (println "FAIL -- List item after assignment: " (list_get lst 2)))
 
+(def deep (fold (func (acc i) (list acc i)) (list) lst))
+(= tmp (copy deep))
+(list_set (list_get tmp 0) 1 0)
+(if (and (== (list_get (list_get deep 0) 1) (list_get lst -2)) (== (list_get (list_get tmp 0) 1) 0))
+    (println "OK -- Deep copy of nested list")
+    (println "FAIL -- Deep copy of nested list"))
+
+(def long (list_merge lst lst lst lst lst lst lst lst))
+(def sub (list_get long 1 39))
+(list_set long 1 0)
+(list_add sub 7)
+(if (and (== (list_len long) 40) (== (list_get sub 0) (list_get lst 1)) (== (list_get sub -1) 7))
+    (println "OK -- Sublist and list changed apart")
+    (println "FAIL -- Sublist and list changed apart"))
+
+# a local variable holding an item of another local list is released once
+(def item_len (func ()
+    (def outer (list (list 1 2 3) 4))
+    (def inner (list_get outer 0))
+    (list_len inner)))
+(if (== (+ (item_len) (item_len)) 6)
+    (println "OK -- Local item of a local list")
+    (println "FAIL -- Local item of a local list"))
+
+(= tmp (copy long))
+(foreach (func (x) (list_ins tmp 0 x)) lst)
+(foreach (func (x) (block (list_add tmp x) (list_rem tmp 0))) long)
+(if (and (== (list_len tmp) 45) (== (list_get tmp 0) (list_get long -5)) (== (list_get tmp -1) (list_get long -1)))
+    (println "OK -- List as a queue")
+    (println "FAIL -- List as a queue"))
+
+(def fz (freeze (list 1 (list 2 3))))
+(= tmp (copy fz))
+(list_add tmp 4)
+
+(if (and (== (list_len fz) 2) (== (list_len tmp) 3))
+    (println "OK -- Frozen list and its copy")
+    (println "FAIL -- Frozen list and its copy"))
+
+
+# -----------------------------------------------------------------------------
+# Vectors
+
+(def vc (vec 1 2 "c"))
+(= tmp (vec_set (vec_add vc 4) 0 0))
+
+(if (and (== (vec_len vc) 3) (== (vec_get vc 0) 1) (== (vec_len tmp) 4) (== (vec_get tmp 0) 0))
+    (println "OK -- Vector unchanged by set and add: " vc " " tmp)
+    (println "FAIL -- Vector unchanged by set and add: " vc " " tmp))
+
+(= tmp (fold (func (acc i) (vec_add acc i)) (vec) long))
+(def vs (vec_get tmp 1 39))
+
+(if (and (== (vec_len tmp) 40) (== (vec_get vs 0) (list_get long 1)) (== (vec_len (vec_merge vs vc)) 41))
+    (println "OK -- Long vector, slice and merge")
+    (println "FAIL -- Long vector, slice and merge"))
+
+# Hash maps
+
+(def hm (hashmap "a" 1 2 "b"))
+(hm_set hm "c" (list 3))
+(hm_del hm 2)
+
+(if (and (== (hm_len hm) 2) (== (hm_get hm "a") 1) (not (hm_has hm 2)) (== (hm_get hm 2 0) 0))
+    (println "OK -- Hash map set, get and delete: " hm)
+    (println "FAIL -- Hash map set, get and delete: " hm))
+
+(= tmp (fold (func (acc i) (hm_set acc (type i) (+ 1 (hm_get acc (type i) 0))) acc) (hashmap) long))
+
+(if (== (fold (func (acc k) (+ acc (hm_get tmp k))) 0 (hm_keys tmp)) (list_len long))
+    (println "OK -- Hash map grouping: " tmp)
+    (println "FAIL -- Hash map grouping: " tmp))
+
+# Sets
+
+(def st (set_from (list 1 2 2 3 "a" 3)))
+(= tmp (set 3 "a" 4))
+
+(if (and (== (set_len st) 4) (set_has st "a") (== (set_len (union st tmp)) 5)
+         (== (set_len (intersect st tmp)) 2) (set_has (intersect st tmp) 3)
+         (== (set_len (difference st tmp)) 2) (set_has (difference st tmp) 1))
+    (println "OK -- Set algebra: " st " " tmp)
+    (println "FAIL -- Set algebra: " st " " tmp))
+
+# F64 arrays
+
+(def fa (f64array (list 1 -4 9)))
+(= tmp (+ (sqrt (abs fa)) (f64_range 0 3)))
+
+(if (and (== (f64_get tmp 2) 5) (== (sum fa) 6) (== (dot fa tmp) 34) (== (min fa) -4) (== (max (* fa 2)) 18)
+         (== (f64_get (f64array (range 1 10 4)) 2) 9))
+    (println "OK -- Array arithmetic: " fa " " tmp)
+    (println "FAIL -- Array arithmetic: " fa " " tmp))
+
+# Matrices
+
+(def ma (matrix (list (list 2 1) (list 1 3))))
+(= tmp (solve ma (f64array (list 3 5))))
+
+(if (and (< (abs (- (f64_get tmp 0) 0.8)) 1e-12) (< (abs (- (f64_get tmp 1) 1.4)) 1e-12)
+         (== (sum (matmul ma ma)) 25)
+         (== (mat_get (transpose (+ ma (matrix 2 2 (list 0 1 0 0)))) 0 1) 1))
+    (println "OK -- Matrix algebra: " ma " " tmp)
+    (println "FAIL -- Matrix algebra: " ma " " tmp))
+
+# Sorting
+
+(= tmp (sort (list 5 -2 9 0 3 3)))
+
+(if (and (== (list_get tmp 0) -2) (== (list_get tmp -1) 9) (== (bsearch tmp 5) 4) (== (bsearch tmp 4) -1)
+         (== (lower_bound tmp 3) 2) (== (list_get (stable_sort (list 1 3 2) >) 0) 3))
+    (println "OK -- Sorting: " tmp)
+    (println "FAIL -- Sorting: " tmp))
+
+# Priority queues
+
+(def pq (pq_new))
+(foreach (func (x) (pq_push pq (* x 10) x)) (list 4 1 3 2))
+(= tmp (pq_new >))
+(foreach (func (x) (pq_push tmp x)) (list 4 1 3 2))
+
+(if (and (== (pq_pop pq) 10) (== (pq_pop pq) 20) (== (pq_len pq) 2) (== (pq_peek pq) 30)
+         (== (pq_pop tmp) 4) (== (pq_pop tmp) 3))
+    (println "OK -- Priority queue: " pq " " tmp)
+    (println "FAIL -- Priority queue: " pq " " tmp))
+
+# Lazy sequences
+
+(def rng (range 1 10 2))
+(= tmp (generator (func (x) (if (< x 16) (* x 2) NULL)) 1))
+
+(if (and (== (list_len rng) 5) (== (list_get rng -1) 9) (== (fold + 0 rng) 25)
+         (== (list_get (list_get rng 1 3) 0) 3) (== (list_len (filter (func (x) (> x 4)) rng)) 3)
+         (== (reduce + tmp) 31) (== (list_get (to_list tmp) 4) 16) (if (range 0) 0 1))
+    (println "OK -- Lazy sequences: " rng " " (to_list tmp))
+    (println "FAIL -- Lazy sequences: " rng " " (to_list tmp)))
+
+# Strings
+
+(def str (concat "Hello" ", " "world"))
+(= tmp (sb_new))
+(sb_add tmp "x = " 42 ";")
+
+(if (and (== (str_len str) 12) (== (substr str -5) "world") (== (find str "o") 4) (== (find str "o" 5) 8)
+         (== (find str "xyz") -1) (== (list_len (split "a,b,,c" ",")) 4) (== (join (list "a" "b") "-") "a-b")
+         (== (sb_str tmp) "x = 42;") (== (sb_len tmp) 7) (< "abc" "abd") (if "" 0 1)
+         (== (sb_str (sb_add (sb_new) (sb_new))) ""))
+    (println "OK -- Strings: " str " " (sb_str tmp))
+    (println "FAIL -- Strings: " str " " (sb_str tmp)))
+
 
 # -----------------------------------------------------------------------------
 # Recursion
@@ -218,6 +368,14 @@
     (println "OK -- Hidden function export")
     (println "FAIL -- Hidden function export"))
 
+# A closure deleted while its enclosing environment is still evaluated in
+(def cl_items (list 1 2 3))
+(def cl_add (func (i) (map (func (j) (+ i j)) cl_items)))
+(= tmp (map cl_add cl_items))
+(if (== (list_get (list_get tmp 2) 2) 6)
+    (println "OK -- Closure deleted in its environment: " tmp)
+    (println "FAIL -- Closure deleted in its environment: " tmp))
+
 
 # -----------------------------------------------------------------------------
 # Higher order functions
@@ -240,3 +398,81 @@
 (if (== tmp 55)
     (println "OK -- Sum of range [1, 10]: " tmp)
     (println "FAIL -- Sum of range [1, 10]: " tmp))
+
+(= tmp (map (func (x) (* x 10)) (list 1 2 3)))
+
+(if (and (== (list_len tmp) 3) (== (list_get tmp 2) 30))
+    (println "OK -- Map: " tmp)
+    (println "FAIL -- Map: " tmp))
+
+(= tmp (filter (func (x) (> x 1)) (list 1 2 3)))
+
+(if (and (== (list_len tmp) 2) (== (list_get tmp 0) 2))
+    (println "OK -- Filter: " tmp)
+    (println "FAIL -- Filter: " tmp))
+
+(= tmp (list (reduce - (list 10 1 2)) (fold - 10 (list 1 2))))
+
+(if (and (== (list_get tmp 0) 7) (== (list_get tmp 1) 7))
+    (println "OK -- Reduce and fold: " tmp)
+    (println "FAIL -- Reduce and fold: " tmp))
+
+(def fe_sum 0)
+(foreach (func (x) (= fe_sum (+ fe_sum x))) (list 1 2 3))
+
+(if (== fe_sum 6)
+    (println "OK -- For each: " fe_sum)
+    (println "FAIL -- For each: " fe_sum))
+
+
+# -----------------------------------------------------------------------------
+# Tasks
+
+(def cube (func (x) (* x x x)))
+
+# integral: integral of f over [a, b] with step dx
+(def integral (func (f a b dx)
+    (def add_dx (func (x) (+ x dx)))
+    (* (sigma f (+ a (/ dx 2)) add_dx b) dx)))
+
+(def f1 (spawn integral cube 0 0.5 0.01))
+(def f2 (spawn integral cube 0.5 1 0.01))
+(= tmp (+ (await f1) (await f2)))
+
+(if (< (abs (- tmp 0.25)) 0.001)
+    (println "OK -- Integral in two tasks: " tmp)
+    (println "FAIL -- Integral in two tasks: " tmp))
+
+# Arguments and results are copied
+(def tl (list 1 2 3))
+(= tmp (await (spawn list_add tl 4)))
+
+(if (and (== (list_len tl) 3) (== (list_len tmp) 4))
+    (println "OK -- Task works on a copy")
+    (println "FAIL -- Task works on a copy"))
+
+(def sq (func (x) (* x x)))
+(= tmp (pmap sq (list 1 2 3 4)))
+
+(if (and (== (list_len tmp) 4) (== (list_get tmp 3) 16))
+    (println "OK -- Parallel map: " tmp)
+    (println "FAIL -- Parallel map: " tmp))
+
+(= tmp (preduce + 100 (pmap sq (list 1 2 3 4))))
+
+(if (== tmp 130)
+    (println "OK -- Parallel reduce: " tmp)
+    (println "FAIL -- Parallel reduce: " tmp))
+
+(def big (to_list (range 5000)))
+(= tmp (pmap sq big))
+
+(if (and (== (list_len tmp) 5000)
+         (== (fold + 0 (map (func (i) (* i (list_get tmp i))) big))
+             (fold + 0 (map (func (i) (* i (sq i))) big))))
+    (println "OK -- Parallel map in chunks")
+    (println "FAIL -- Parallel map in chunks"))
+
+(if (== (preduce + 0 big) (fold + 0 big))
+    (println "OK -- Parallel reduce in chunks")
+    (println "FAIL -- Parallel reduce in chunks"))
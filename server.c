@@ -0,0 +1,244 @@
+/*
+Evaluation server.
+Listens on a Unix domain socket and evaluates requests on warm interpreter contexts,
+avoiding process start and global environment setup on every evaluation.
+
+Every request is evaluated in a fresh context restored from an in-memory image of the
+prelude environment, so requests can't see each other's definitions or changes.  The
+next context of a worker is prepared right after it answers a request, while the
+client is busy with the answer.
+
+Workers wait on a shared epoll instance.  Sockets are armed for one event at a time,
+so a connection is served by one worker at a time, and any idle worker takes the next
+request of any connection.  A worker reads a request once its first bytes arrive; a
+client that stops in the middle of a request for SERVE_TIMEOUT seconds is disconnected,
+so it can't hold the worker.
+
+Protocol (u32 - 32-bit unsigned integer in network byte order):
+    request     u32 len, len bytes of source text
+    response    u8 status (0 - ok, 1 - error), u32 len, printed output,
+                u32 len, printed value of the last expression (empty for NULL)
+A connection can carry any number of requests, they are answered in order.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include "alisp.h"
+
+/* Server state shared by workers */
+typedef struct {
+    int          sock;      // listening socket
+    int          ep;        // epoll instance watching the socket and connections
+    const buf_t* prelude;   // image of the prelude environment
+} server_t;
+
+/* Watch a socket for one event: only one worker at a time serves a connection. */
+static void server_arm(server_t* s, int fd, int op) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.fd = fd;
+    epoll_ctl(s->ep, op, fd, &ev);
+}
+
+/* Read exactly n bytes. Return 0 on end of stream or error. */
+static int read_all(int fd, void* buf, size_t n) {
+    char* p = buf;
+    while (n) {
+        ssize_t k = read(fd, p, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return 0;
+        p += k;
+        n -= k;
+    }
+    return 1;
+}
+
+/* Write exactly n bytes. Return 0 on error. */
+static int send_all(int fd, const void* buf, size_t n) {
+    const char* p = buf;
+    while (n) {
+        ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return 0;
+        p += k;
+        n -= k;
+    }
+    return 1;
+}
+
+/* Append a length-prefixed byte string to a buffer. */
+static void put_bytes(buf_t* b, const char* s, size_t n) {
+    uint32_t len = htonl((uint32_t)n);
+    buf_put(b, &len, sizeof(len));
+    buf_put(b, s, n);
+}
+
+/* Make a context with the prelude environment, capturing its output. */
+static alisp_ctx* server_ctx(server_t* s) {
+    alisp_ctx* ctx = ctx_new();
+    ctx->use_cache = 0;
+    ctx->out.mode = OUT_MEMORY;
+    if (!image_restore(ctx, s->prelude->data, s->prelude->len)) {
+        printf("\x1b[95m" "Fatal error: server_ctx: failed to restore prelude!\n" "\x1b[0m");
+        exit(EXIT_FAILURE);
+    }
+    ctx->out.len = 0;
+    return ctx;
+}
+
+/*
+--------------------------------------
+server_eval
+
+    Evaluate a request and put the response to a buffer.
+--------------------------------------
+*/
+static void server_eval(alisp_ctx* ctx, const char* src, buf_t* resp) {
+    atom_t* v = NULL;
+    atom_t* parse_tree = parse(src, ctx->arena);
+    if (parse_tree)
+        v = eval(ctx, parse_tree, ctx->global_env, NULL);
+
+    char status = v ? 0 : 1;
+    char* o = v && v->type != NIL ? atom_tostr(v) : NULL;
+    if (v)
+        atom_del(v);
+    buf_put(resp, &status, 1);
+    put_bytes(resp, ctx->out.buf, ctx->out.len);
+    put_bytes(resp, o ? o : "", o ? strlen(o) : 0);
+    safe_free(o);
+    ctx->out.len = 0;  // output is taken
+}
+
+/* Wait for a connection with a request and answer it, repeatedly. */
+static void* server_worker(void* arg) {
+    server_t* s = arg;
+    alisp_ctx* ctx = server_ctx(s);
+    buf_t resp = {NULL, 0, 0};
+    char* src = NULL;
+    uint32_t len;
+    struct epoll_event ev;
+
+    for (;;) {
+        if (epoll_wait(s->ep, &ev, 1, -1) < 1)
+            continue;
+
+        // New connection
+        if (ev.data.fd == s->sock) {
+            int conn = accept(s->sock, NULL, NULL);
+            server_arm(s, s->sock, EPOLL_CTL_MOD);
+            if (conn >= 0) {
+                struct timeval tv = {SERVE_TIMEOUT, 0};
+                setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+                server_arm(s, conn, EPOLL_CTL_ADD);
+            }
+            continue;
+        }
+
+        // Request on a connection
+        int conn = ev.data.fd;
+        if (!read_all(conn, &len, sizeof(len)) || (len = ntohl(len)) > SERVE_MAXREQ) {
+            close(conn);  // closed, timed out, or not a client of ours
+            continue;
+        }
+        src = realloc(src, len + 1);
+        if (!read_all(conn, src, len)) {
+            close(conn);
+            continue;
+        }
+        src[len] = '\0';
+
+        resp.len = 0;
+        server_eval(ctx, src, &resp);
+        if (send_all(conn, resp.data, resp.len))
+            server_arm(s, conn, EPOLL_CTL_MOD);  // wait for the next request
+        else
+            close(conn);
+
+        // Prepare a clean context for the next request
+        ctx_del(ctx);
+        ctx = server_ctx(s);
+    }
+
+    return NULL;
+}
+
+/*
+--------------------------------------
+serve
+
+    Serve evaluation requests on a Unix domain socket with a number of worker threads
+    until interrupted, then exit.  Requests start from the global environment of the
+    context.  Return 0 on error.
+--------------------------------------
+*/
+int serve(alisp_ctx* ctx, const char* path, int workers) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errmsg("Server", "socket path is too long", NULL, NULL);
+        return 0;
+    }
+    strcpy(addr.sun_path, path);
+
+    buf_t prelude = {NULL, 0, 0};
+    if (!image_dump(ctx, &prelude))
+        return 0;
+
+    // Replace a stale socket left by a previous server
+    struct stat st;
+    if (!stat(path, &st) && S_ISSOCK(st.st_mode))
+        unlink(path);
+
+    server_t s = {socket(AF_UNIX, SOCK_STREAM, 0), epoll_create1(0), &prelude};
+    if (s.sock < 0 || s.ep < 0 || bind(s.sock, (struct sockaddr*)&addr, sizeof(addr)) ||
+        listen(s.sock, 128)) {
+        errmsg("Server", strerror(errno), NULL, NULL);
+        if (s.sock >= 0)
+            close(s.sock);
+        if (s.ep >= 0)
+            close(s.ep);
+        safe_free(prelude.data);
+        return 0;
+    }
+    server_arm(&s, s.sock, EPOLL_CTL_ADD);
+
+    // Workers don't get termination signals, the main thread waits for them
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+    out_printf("Serving on %s with %d worker%s\n", path, workers, workers > 1 ? "s" : "");
+    out_flush();
+    for (int i = 0; i < workers; ++i) {
+        pthread_t t;
+        pthread_create(&t, NULL, server_worker, &s);
+        pthread_detach(t);
+    }
+
+    // Workers use the prelude and the socket until the end, exit from here
+    int sig;
+    sigwait(&sigs, &sig);
+    unlink(path);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,322 @@
+/*
+Sort: ordering and binary search of list items.
+
+Items are compared by a procedure of two items, true if the first goes before the
+second, or by default like the < operator: numbers by value, strings by their text.
+Sorting is introsort: quicksort with the median of three for a pivot, heapsort if the
+partitions go too deep, and insertion sort for short ranges.  Stable sorting is merge
+sort.  Every loop checks its bounds, so a procedure that is not a consistent order
+gives some order of the items, never a crash, and an error stops the sorting.
+
+The < and > operators given as procedures compare the same way without being called.
+Numbers sorted by default go through a radix sort instead, stable, on the bits of
+the numbers made to order as unsigned integers: one pass per byte, skipping bytes
+that are the same in all numbers.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "alisp.h"
+
+#define SORT_SMALL 16   // ranges sorted by insertion
+#define RADIX_MIN  64   // fewest numbers for a radix sort
+
+/* Number with its radix key */
+typedef struct {
+    uint64_t key;
+    atom_t*  item;
+} keyed_t;
+
+/* Set up a comparison by a procedure, or by < and > directly. */
+void order_init(order_t* o, alisp_ctx* ctx, atom_t* expr, atom_t* proc) {
+    o->ctx = ctx;
+    o->expr = expr;
+    o->proc = proc;
+    o->desc = 0;
+    o->err = 0;
+    if (proc && proc->type == STD_OP && proc->val.oper->type == REL &&
+        (proc->val.oper->val.rel == op_lt || proc->val.oper->val.rel == op_gt)) {
+        o->proc = NULL;
+        o->desc = proc->val.oper->val.rel == op_gt;
+    }
+}
+
+/* True if a goes before b. */
+int order_less(order_t* o, atom_t* a, atom_t* b) {
+    if (o->err)
+        return 0;
+    if (!o->proc) {
+        if (o->desc) {
+            atom_t* t = a;
+            a = b;
+            b = t;
+        }
+        if (a->type == NUMBER && b->type == NUMBER)
+            return *a->val.num < *b->val.num;
+        else if (a->type == STRING && b->type == STRING)
+            return str_cmp(a, b) < 0;
+        else if (a->type == SYMBOL && b->type == SYMBOL)
+            return strcmp(a->val.sym, b->val.sym) < 0;
+        errmsg("Semantic", "wrong type of argument", NULL, NULL);
+        list_print(o->expr, 0);
+        o->err = 1;
+        return 0;
+    }
+
+    atom_t* args[2] = {a, b};
+    atom_t* r = apply_argv(o->ctx, o->expr, o->proc, 2, args);
+    if (!r) {
+        o->err = 1;
+        return 0;
+    }
+    int res = atom_true(r);
+    atom_del(r);
+    return res;
+}
+
+/* Stable insertion sort. */
+static void insertion_sort(order_t* o, atom_t** a, int n) {
+    for (int i = 1; i < n && !o->err; ++i) {
+        atom_t* x = a[i];
+        int j = i;
+        for (; j > 0 && order_less(o, x, a[j - 1]); --j)
+            a[j] = a[j - 1];
+        a[j] = x;
+    }
+}
+
+/* Move an item down a heap of n items until its children go before it. */
+static void sift_down(order_t* o, atom_t** a, int i, int n) {
+    atom_t* x = a[i];
+    for (int c = 2 * i + 1; c < n; c = 2 * i + 1) {
+        if (c + 1 < n && order_less(o, a[c], a[c + 1]))
+            ++c;
+        if (!order_less(o, x, a[c]))
+            break;
+        a[i] = a[c];
+        i = c;
+    }
+    a[i] = x;
+}
+
+/* Heapsort, for partitions gone too deep. */
+static void heap_sort(order_t* o, atom_t** a, int n) {
+    for (int i = n / 2 - 1; i >= 0; --i)
+        sift_down(o, a, i, n);
+    for (int i = n - 1; i > 0 && !o->err; --i) {
+        atom_t* t = a[0];
+        a[0] = a[i];
+        a[i] = t;
+        sift_down(o, a, 0, i);
+    }
+}
+
+/*
+--------------------------------------
+intro_sort
+
+    Quicksort a range until depth runs out, then heapsort what is left.  Recurse
+    into the shorter partition and loop over the longer one, so the stack stays
+    logarithmic.
+--------------------------------------
+*/
+static void intro_sort(order_t* o, atom_t** a, int n, int depth) {
+    atom_t* t;
+    while (n > SORT_SMALL && !o->err) {
+        if (depth-- == 0) {
+            heap_sort(o, a, n);
+            return;
+        }
+
+        // Median of the first, middle and last items goes first as the pivot
+        int m = n / 2;
+        if (order_less(o, a[m], a[0])) {
+            t = a[m]; a[m] = a[0]; a[0] = t;
+        }
+        if (order_less(o, a[n - 1], a[m])) {
+            t = a[n - 1]; a[n - 1] = a[m]; a[m] = t;
+            if (order_less(o, a[m], a[0])) {
+                t = a[m]; a[m] = a[0]; a[0] = t;
+            }
+        }
+        t = a[m]; a[m] = a[0]; a[0] = t;
+
+        // Items equal to the pivot stop both scans, so they split evenly
+        atom_t* p = a[0];
+        int i = 0, j = n;
+        for (;;) {
+            while (++i < n && order_less(o, a[i], p));
+            while (--j > 0 && order_less(o, p, a[j]));
+            if (i >= j)
+                break;
+            t = a[i]; a[i] = a[j]; a[j] = t;
+        }
+        a[0] = a[j];
+        a[j] = p;
+
+        if (j < n - j - 1) {
+            intro_sort(o, a, j, depth);
+            a += j + 1;
+            n -= j + 1;
+        } else {
+            intro_sort(o, a + j + 1, n - j - 1, depth);
+            n = j;
+        }
+    }
+    insertion_sort(o, a, n);
+}
+
+/* Stable merge sort of a range, tmp has room for half of it. */
+static void merge_sort(order_t* o, atom_t** a, int n, atom_t** tmp) {
+    if (n <= SORT_SMALL) {
+        insertion_sort(o, a, n);
+        return;
+    }
+    int m = n / 2;
+    merge_sort(o, a, m, tmp);
+    merge_sort(o, a + m, n - m, tmp);
+    if (o->err || !order_less(o, a[m], a[m - 1]))
+        return;  // halves are in order already
+
+    // Merge the first half from tmp with the second half in place
+    memcpy(tmp, a, m * sizeof(atom_t*));
+    int i = 0, j = m, k = 0;
+    while (i < m && j < n)
+        a[k++] = order_less(o, a[j], tmp[i]) ? a[j++] : tmp[i++];
+    memcpy(a + k, tmp + i, (m - i) * sizeof(atom_t*));
+}
+
+/*
+--------------------------------------
+radix_sort
+
+    Sort numbers by their keys, least significant byte first.  Keys order like the
+    numbers: the sign bit of positive numbers is set, and all bits of negative ones
+    are flipped.  Stable.
+--------------------------------------
+*/
+static void radix_sort(atom_t** a, int n) {
+    keyed_t* x = malloc(n * sizeof(keyed_t));
+    keyed_t* y = malloc(n * sizeof(keyed_t));
+    int counts[8][256];
+    memset(counts, 0, sizeof(counts));
+
+    for (int i = 0; i < n; ++i) {
+        double d = *a[i]->val.num;
+        if (d == 0)
+            d = 0;  // -0 and 0 are equal
+        uint64_t k;
+        memcpy(&k, &d, sizeof(k));
+        k = k >> 63 ? ~k : k | (1ull << 63);
+        x[i].key = k;
+        x[i].item = a[i];
+        for (int b = 0; b < 8; ++b)
+            ++counts[b][(k >> (b * 8)) & 0xff];
+    }
+
+    for (int b = 0; b < 8; ++b) {
+        int* c = counts[b];
+        if (c[(x[0].key >> (b * 8)) & 0xff] == n)
+            continue;  // same byte in all keys
+        for (int v = 0, sum = 0; v < 256; ++v) {
+            int t = c[v];
+            c[v] = sum;
+            sum += t;
+        }
+        for (int i = 0; i < n; ++i)
+            y[c[(x[i].key >> (b * 8)) & 0xff]++] = x[i];
+        keyed_t* t = x;
+        x = y;
+        y = t;
+    }
+
+    for (int i = 0; i < n; ++i)
+        a[i] = x[i].item;
+    safe_free(x);
+    safe_free(y);
+}
+
+/*
+--------------------------------------
+sort_items
+
+    Return the list of items sorted by a procedure, or like < if proc is NULL, or
+    NULL on error.  Stable sorting keeps equal items in their order.  Items must be
+    protected by the caller.
+--------------------------------------
+*/
+atom_t* sort_items(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t** items, int n,
+                   int stable) {
+    order_t o;
+    order_init(&o, ctx, expr, proc);
+    int numbers = 1;
+    if (!o.proc) {
+        for (int i = 0; i < n; ++i)
+            if (items[i]->type != items[0]->type ||
+                (items[i]->type != NUMBER && items[i]->type != STRING &&
+                 items[i]->type != SYMBOL)) {
+                errmsg("Semantic", "items must be all numbers or all strings", NULL, NULL);
+                list_print(expr, 0);
+                return NULL;
+            }
+        numbers = n > 0 && items[0]->type == NUMBER;
+    }
+
+    // Sort the items of the result, which protects them from the procedure
+    atom_t* env = ctx->active_env;
+    atom_t* v = list();
+    list_append(v, items, n);
+    atom_bind(v, env);
+    atom_t** a = v->val.list->items;
+
+    if (!o.proc && !o.desc && numbers && n >= RADIX_MIN) {
+        radix_sort(a, n);
+    } else if (stable) {
+        atom_t** tmp = malloc((n / 2 + 1) * sizeof(atom_t*));
+        merge_sort(&o, a, n, tmp);
+        safe_free(tmp);
+    } else {
+        int depth = 0;
+        for (int i = n; i > 1; i >>= 1)
+            depth += 2;
+        intro_sort(&o, a, n, depth);
+    }
+
+    atom_unbind(v, env);
+    if (o.err) {
+        atom_del(v);
+        return NULL;
+    }
+    return v;
+}
+
+/*
+--------------------------------------
+search_items
+
+    Find the first of sorted items that doesn't go before x, by a procedure or like
+    < if proc is NULL, and set idx to its index, or to n if there is none.  With
+    exact, set idx to -1 unless that item is also not after x.  Return 0 on error.
+--------------------------------------
+*/
+int search_items(alisp_ctx* ctx, atom_t* expr, atom_t* proc, atom_t** items, int n,
+                 atom_t* x, int exact, int* idx) {
+    order_t o;
+    order_init(&o, ctx, expr, proc);
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int m = lo + (hi - lo) / 2;
+        if (order_less(&o, items[m], x))
+            lo = m + 1;
+        else
+            hi = m;
+        if (o.err)
+            return 0;
+    }
+    *idx = lo;
+    if (exact && (lo == n || order_less(&o, x, items[lo])))
+        *idx = -1;
+    return !o.err;
+}
@@ -0,0 +1,319 @@
+/*
+String: immutable text with its length, and the string builder.
+
+A string keeps its length, so nothing has to scan for the end of the text, and may
+hold any bytes.  Text of up to STR_SMALL - 1 bytes is kept inside the string itself,
+longer text is allocated apart.  The hash of the text is computed the first time it is
+needed and kept: hash map keys and comparisons of unequal strings use it.  Frozen
+strings, and strings in vectors, are shared by tasks, so the kept hash is read and
+written atomically; threads that compute it at once store the same value.
+
+Searching goes through memchr for the first byte of the text looked for, then compares
+the rest where it is found; memchr of the C library is vectorized, so long runs of
+other bytes are skipped many at a time.  Concatenating, joining and splitting compute
+the lengths first and copy every byte once.
+
+A string builder is mutable text that grows by doubling, so appending to it takes
+amortized O(1) time per byte, and a string is made of it once at the end.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alisp.h"
+
+#define cached(s)   __atomic_load_n(&(s)->hash, __ATOMIC_RELAXED)
+
+/* Make a string of len bytes to be filled by the caller. */
+static atom_t* str_alloc(int len) {
+    string_t* s = malloc(sizeof(string_t));
+    s->len = len;
+    s->hash = 0;
+    s->data = len < STR_SMALL ? s->small : malloc(len + 1);
+    s->data[len] = '\0';
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.str = s;
+    obj->type = STRING;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Make a string of len bytes of text. */
+atom_t* str_new(const char* text, int len) {
+    atom_t* obj = str_alloc(len);
+    if (len)
+        memcpy(obj->val.str->data, text, len);  // text of an empty builder is NULL
+    return obj;
+}
+
+/* Deallocate a string. */
+void str_del(atom_t* obj) {
+    string_t* s = obj->val.str;
+    if (s->data != s->small)
+        safe_free(s->data);
+    safe_free(s);
+    safe_free(obj);
+}
+
+/* Copy a string. */
+atom_t* str_copy(atom_t* obj) {
+    atom_t* copy = str_new(str_data(obj), str_len(obj));
+    copy->val.str->hash = cached(obj->val.str);
+    return copy;
+}
+
+/* Length in bytes. */
+int str_len(atom_t* obj) {
+    return obj->val.str->len;
+}
+
+/* Text, terminated by zero. */
+char* str_data(atom_t* obj) {
+    return obj->val.str->data;
+}
+
+/* Hash of the text, computed once. */
+unsigned str_hash(atom_t* obj) {
+    string_t* s = obj->val.str;
+    unsigned h = cached(s);
+    if (!h) {
+        h = (unsigned)hash_bytes(s->data, s->len);
+        if (!h)
+            h = 1;  // 0 stands for not computed
+        __atomic_store_n(&s->hash, h, __ATOMIC_RELAXED);
+    }
+    return h;
+}
+
+/* Are strings equal? */
+int str_eq(atom_t* a, atom_t* b) {
+    string_t* x = a->val.str;
+    string_t* y = b->val.str;
+    unsigned hx = cached(x);
+    unsigned hy = cached(y);
+    if (x->len != y->len || (hx && hy && hx != hy))
+        return 0;
+    return memcmp(x->data, y->data, x->len) == 0;
+}
+
+/* Compare strings like strcmp. */
+int str_cmp(atom_t* a, atom_t* b) {
+    string_t* x = a->val.str;
+    string_t* y = b->val.str;
+    int c = memcmp(x->data, y->data, x->len < y->len ? x->len : y->len);
+    return c ? c : (x->len > y->len) - (x->len < y->len);
+}
+
+/* Make a string representing a string: the text in quotes. */
+char* str_tostr(atom_t* obj) {
+    int len = str_len(obj);
+    char* o = malloc(len + 3);
+    o[0] = '"';
+    memcpy(o + 1, str_data(obj), len);
+    o[len + 1] = '"';
+    o[len + 2] = '\0';
+    return o;
+}
+
+/*
+--------------------------------------
+str_concat
+
+    Return the string of the texts of n strings one after another.
+--------------------------------------
+*/
+atom_t* str_concat(atom_t** items, int n) {
+    size_t len = 0;
+    for (int i = 0; i < n; ++i)
+        len += str_len(items[i]);
+    if (len > STR_MAX_LEN) {
+        errmsg("Semantic", "string is too long", NULL, NULL);
+        return NULL;
+    }
+    atom_t* obj = str_alloc(len);
+    char* p = str_data(obj);
+    for (int i = 0; i < n; ++i) {
+        memcpy(p, str_data(items[i]), str_len(items[i]));
+        p += str_len(items[i]);
+    }
+    return obj;
+}
+
+/* Return the string of the bytes in [from, to), clamped to the string. */
+atom_t* str_sub(atom_t* obj, int from, int to) {
+    if (from < 0)
+        from = 0;
+    if (to > str_len(obj))
+        to = str_len(obj);
+    return str_new(str_data(obj) + from, to > from ? to - from : 0);
+}
+
+/* Return the first place of n bytes of pat in [p, end), or NULL. */
+static const char* str_search(const char* p, const char* end, const char* pat, int n) {
+    if (n == 0)
+        return p;
+    if (end - p < n)
+        return NULL;
+    for (end -= n - 1; p < end; ++p) {
+        p = memchr(p, pat[0], end - p);
+        if (!p)
+            return NULL;
+        if (memcmp(p + 1, pat + 1, n - 1) == 0)
+            return p;
+    }
+    return NULL;
+}
+
+/* Return the index of the first sub at or after from, or -1. */
+int str_find(atom_t* obj, atom_t* sub, int from) {
+    if (from < 0)
+        from = 0;
+    if (from > str_len(obj))
+        return -1;
+    const char* p = str_search(str_data(obj) + from, str_data(obj) + str_len(obj),
+                               str_data(sub), str_len(sub));
+    return p ? (int)(p - str_data(obj)) : -1;
+}
+
+/*
+--------------------------------------
+str_split
+
+    Return the list of the parts of a string between occurrences of a separator, or
+    NULL if the separator is empty.
+--------------------------------------
+*/
+atom_t* str_split(atom_t* obj, atom_t* sep) {
+    int n = str_len(sep);
+    if (n == 0) {
+        errmsg("Semantic", "separator is empty", NULL, NULL);
+        return NULL;
+    }
+    const char* p = str_data(obj);
+    const char* end = p + str_len(obj);
+    const char* q;
+    atom_t* lst = list();
+    while ((q = str_search(p, end, str_data(sep), n))) {
+        list_add(lst, str_new(p, q - p));
+        p = q + n;
+    }
+    list_add(lst, str_new(p, end - p));
+    return lst;
+}
+
+/*
+--------------------------------------
+str_join
+
+    Return the string of the items of a list with a separator between them, or NULL
+    if some item is not a string.
+--------------------------------------
+*/
+atom_t* str_join(atom_t* lst, atom_t* sep) {
+    int n = list_len(lst);
+    atom_t** items = lst->val.list->items;
+    size_t len = n ? (size_t)(n - 1) * str_len(sep) : 0;
+    for (int i = 0; i < n; ++i) {
+        if (items[i]->type != STRING) {
+            errmsg("Semantic", "items must be strings", NULL, NULL);
+            return NULL;
+        }
+        len += str_len(items[i]);
+    }
+    if (len > STR_MAX_LEN) {
+        errmsg("Semantic", "string is too long", NULL, NULL);
+        return NULL;
+    }
+    atom_t* obj = str_alloc(len);
+    char* p = str_data(obj);
+    for (int i = 0; i < n; ++i) {
+        if (i) {
+            memcpy(p, str_data(sep), str_len(sep));
+            p += str_len(sep);
+        }
+        memcpy(p, str_data(items[i]), str_len(items[i]));
+        p += str_len(items[i]);
+    }
+    return obj;
+}
+
+
+// ----------------------------------------------------------------------
+// String builder
+
+/* Make an empty string builder. */
+atom_t* sb_new() {
+    buf_t* b = malloc(sizeof(buf_t));
+    b->data = NULL;
+    b->len = 0;
+    b->max = 0;
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.buf = b;
+    obj->type = BUILDER;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Deallocate a string builder. */
+void sb_del(atom_t* obj) {
+    safe_free(obj->val.buf->data);
+    safe_free(obj->val.buf);
+    safe_free(obj);
+}
+
+/* Length of the text in bytes. */
+int sb_len(atom_t* obj) {
+    return obj->val.buf->len;
+}
+
+/*
+--------------------------------------
+sb_add
+
+    Append the text of an object, the way print writes it.  Return 0 if the text
+    would grow too long.
+--------------------------------------
+*/
+int sb_add(atom_t* obj, atom_t* x) {
+    buf_t* b = obj->val.buf;
+    char tmp[64];
+    char* s = NULL;
+    const char* p;
+    size_t n;
+    if (x->type == STRING) {
+        p = str_data(x);
+        n = str_len(x);
+    } else if (x->type == NUMBER) {
+        n = snprintf(tmp, sizeof(tmp), "%g", *x->val.num);
+        p = tmp;
+    } else if (x->type == BUILDER) {
+        n = x->val.buf->len;
+        p = x == obj && n ? (s = memcpy(malloc(n), b->data, n)) : x->val.buf->data;
+    } else {
+        p = s = atom_tostr(x);
+        n = strlen(s);
+    }
+    int ok = b->len + n <= STR_MAX_LEN;
+    if (ok)
+        buf_put(b, p, n);
+    safe_free(s);
+    if (!ok)
+        errmsg("Semantic", "string is too long", NULL, NULL);
+    return ok;
+}
+
+/* Make a string of the text. */
+atom_t* sb_str(atom_t* obj) {
+    return str_new(obj->val.buf->data, obj->val.buf->len);
+}
+
+/* Copy a string builder. */
+atom_t* sb_copy(atom_t* obj) {
+    atom_t* copy = sb_new();
+    buf_put(copy->val.buf, obj->val.buf->data, sb_len(obj));
+    return copy;
+}
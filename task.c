@@ -0,0 +1,355 @@
+/*
+Tasks.
+(spawn f args...) applies a procedure to arguments on a thread of the task pool and
+returns a future, (await fut) waits for the task and returns its result.  (pmap f list)
+and (preduce f init list) split a list into chunks, map or reduce every chunk in a task,
+and combine the results in list order.
+
+Interpreter state is not shared between threads.  Every task runs in a context of its
+own, with a deep copy of the global environment, the procedure and the arguments, made
+through an in-memory heap image when the task is spawned.  The result comes back the
+same way, as an image restored into the awaiting context, so every await returns a
+fresh copy.  Output of a task is kept until it is awaited and appears in the output of
+the awaiting context, in await order.
+
+The task pool is shared by all contexts of the process and started on the first spawn,
+with one thread per processor or TASK_THREADS_ENV threads.  A thread awaiting a task
+runs pending tasks meanwhile, so tasks may spawn and await tasks themselves.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "alisp.h"
+
+/* Task states */
+enum { TASK_PENDING, TASK_DONE, TASK_FAILED };
+
+/* Task kinds: what a task does with the values of its job */
+enum { TASK_CALL,               // (f args...):      apply f to args
+       TASK_MAP,                // (f items...):     list of f applied to every item
+       TASK_REDUCE };           // (f init items...): fold items with f, starting at init
+
+/* Future: result of a task */
+struct Future {
+    pthread_mutex_t lock;
+    pthread_cond_t  done;       // signalled when the task is finished
+    int             state;
+    int             kind;
+    int             refs;       // holders: the owner of the future and the task
+    buf_t           job;        // image of the procedure and arguments
+    buf_t           result;     // image of the result
+    buf_t           out;        // output of the task
+};
+
+static pool_t*        task_pool = NULL;
+static pthread_once_t task_once = PTHREAD_ONCE_INIT;
+
+/* Start the task pool. */
+static void task_init() {
+    const char* s = getenv(TASK_THREADS_ENV);
+    int n = s ? atoi(s) : 0;
+    if (n < 1)
+        n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    task_pool = pool_new(n);
+}
+
+/* Drop a hold of a future, deallocate it with the last one. */
+void future_release(future_t* f) {
+    if (__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL))
+        return;
+    pthread_mutex_destroy(&f->lock);
+    pthread_cond_destroy(&f->done);
+    safe_free(f->job.data);
+    safe_free(f->result.data);
+    safe_free(f->out.data);
+    safe_free(f);
+}
+
+
+// ----------------------------------------------------------------------
+// Futures
+
+/*
+--------------------------------------
+task_run
+
+    Run a task in a new context on a pool thread, and announce the result.
+--------------------------------------
+*/
+static void task_run(void* arg) {
+    future_t* f = arg;
+    alisp_ctx* prev = ctx_cur;  // set if the thread is helping while awaiting
+    alisp_ctx* ctx = ctx_new();
+    ctx->use_cache = 0;
+    ctx->out.mode = OUT_MEMORY;
+    atom_t* env = ctx->global_env;
+    int ok = 0;
+
+    atom_t* values = image_restore_values(ctx, f->job.data, f->job.len);
+    if (values) {
+        atom_bind(values, env);
+        atom_t** items = values->val.list->items;
+        int n = list_len(values);
+        atom_t* v = NULL;
+
+        if (f->kind == TASK_CALL) {
+            atom_t* args = list();
+            for (int i = 1; i < n; ++i)
+                list_add(args, items[i]);
+            v = call(ctx, items[0], args);
+        } else if (f->kind == TASK_MAP)
+            v = map_items(ctx, values, items[0], items + 1, n - 1);
+        else
+            v = fold_items(ctx, values, items[0], items[1], items + 2, n - 2);
+
+        if (v) {
+            atom_t* res = list();
+            list_add_h(res, v);
+            ok = image_dump_values(ctx, res, 0, &f->result);
+            list_free(res);
+            atom_del(v);
+        }
+        atom_unbind(values, env);
+        atom_del(values);
+    }
+
+    // Take the output before the context is gone
+    f->out = (buf_t){ctx->out.buf, ctx->out.len, ctx->out.max};
+    ctx->out.buf = NULL;
+    ctx->out.len = 0;
+    ctx_del(ctx);
+    ctx_set(prev);
+
+    pthread_mutex_lock(&f->lock);
+    __atomic_store_n(&f->state, ok ? TASK_DONE : TASK_FAILED, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&f->done);
+    pthread_mutex_unlock(&f->lock);
+    future_release(f);
+}
+
+/*
+--------------------------------------
+task_start
+
+    Queue a task of a kind on values copied from the context. Return its future, or
+    NULL if the values can't be copied.
+--------------------------------------
+*/
+static future_t* task_start(alisp_ctx* ctx, int kind, atom_t* values) {
+    future_t* f = malloc(sizeof(future_t));
+    pthread_mutex_init(&f->lock, NULL);
+    pthread_cond_init(&f->done, NULL);
+    f->state = TASK_PENDING;
+    f->kind = kind;
+    f->refs = 2;
+    f->job = f->result = f->out = (buf_t){NULL, 0, 0};
+
+    // Copy the values with the global environment they may use
+    if (!image_dump_values(ctx, values, 1, &f->job)) {
+        f->refs = 1;
+        future_release(f);
+        return NULL;
+    }
+
+    pthread_once(&task_once, task_init);
+    pool_submit(task_pool, task_run, f);
+    return f;
+}
+
+/*
+--------------------------------------
+task_finish
+
+    Wait for a task, helping with pending tasks meanwhile. Pass on its output and
+    return a copy of its result, or NULL if it failed.
+--------------------------------------
+*/
+static atom_t* task_finish(alisp_ctx* ctx, future_t* f) {
+    while (__atomic_load_n(&f->state, __ATOMIC_ACQUIRE) == TASK_PENDING) {
+        if (pool_help(task_pool))
+            continue;
+        pthread_mutex_lock(&f->lock);
+        while (f->state == TASK_PENDING)
+            pthread_cond_wait(&f->done, &f->lock);
+        pthread_mutex_unlock(&f->lock);
+    }
+
+    // Output is passed on by the first await
+    out_write(f->out.data, f->out.len);
+    f->out.len = 0;
+
+    if (f->state == TASK_FAILED)
+        return NULL;
+    atom_t* values = image_restore_values(ctx, f->result.data, f->result.len);
+    if (!values)
+        return NULL;
+    atom_t* v = values->val.list->items[0];
+    atom_bind(v, ctx->active_env);  // protect the result
+    atom_del(values);
+    atom_unbind(v, ctx->active_env);
+    return v;
+}
+
+/* Return the number of chunks to split n list items into, 1 to run inline. */
+static int task_chunks(int n) {
+    pthread_once(&task_once, task_init);
+    int chunks = n / TASK_GRAIN;
+    if (chunks > pool_size(task_pool))
+        chunks = pool_size(task_pool);
+    return chunks > 1 ? chunks : 1;
+}
+
+/* Start a task of kind for every chunk of n items: (f items...). Return the futures. */
+static future_t** task_split(alisp_ctx* ctx, int kind, atom_t* f, atom_t** items, int n,
+                             int chunks) {
+    future_t** futs = malloc(chunks * sizeof(future_t*));
+    for (int k = 0; k < chunks; ++k) {
+        atom_t* values = list();
+        list_add_h(values, f);
+        for (int i = n * k / chunks; i < n * (k + 1) / chunks; ++i)
+            list_add_h(values, items[i]);
+        futs[k] = task_start(ctx, kind, values);
+        list_free(values);
+    }
+    return futs;
+}
+
+
+// ----------------------------------------------------------------------
+// Operators
+
+/*
+--------------------------------------
+task_spawn
+
+    Start a task applying argv[0] to the rest of arguments. Return a future.
+--------------------------------------
+*/
+atom_t* task_spawn(alisp_ctx* ctx, atom_t* expr, int argc, atom_t** argv) {
+    for (int i = 1; i < argc; ++i)
+        if (argv[i]->type == FUTURE) {
+            errmsg("Semantic", "futures can't be passed to tasks", NULL, NULL);
+            list_print(expr, 0);
+            return NULL;
+        }
+
+    atom_t* values = list();
+    for (int i = 0; i < argc; ++i)
+        list_add_h(values, argv[i]);
+    future_t* f = task_start(ctx, TASK_CALL, values);
+    list_free(values);
+    if (!f) {
+        list_print(expr, 0);
+        return NULL;
+    }
+
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.fut = f;
+    obj->type = FUTURE;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Wait for the task of a future and return a copy of its result. */
+atom_t* task_await(alisp_ctx* ctx, atom_t* expr, atom_t* obj) {
+    atom_t* v = task_finish(ctx, obj->val.fut);
+    if (!v) {
+        errmsg("Semantic", "task failed", NULL, NULL);
+        list_print(expr, 0);
+    }
+    return v;
+}
+
+/*
+--------------------------------------
+task_map
+
+    Apply f to every item of a list, in chunks on task threads if the list is long
+    enough.  Return the list of results in list order.
+--------------------------------------
+*/
+atom_t* task_map(alisp_ctx* ctx, atom_t* expr, atom_t* f, atom_t* lst) {
+    int n = list_len(lst);
+    atom_t** items = lst->val.list->items;
+    int chunks = task_chunks(n);
+    if (chunks == 1)
+        return map_items(ctx, expr, f, items, n);
+
+    future_t** futs = task_split(ctx, TASK_MAP, f, items, n, chunks);
+
+    // Concatenate results in order, abandon the rest after a failure
+    atom_t* env = ctx->active_env;
+    atom_t* v = list();
+    atom_bind(v, env);
+    for (int k = 0; k < chunks; ++k) {
+        atom_t* r = futs[k] && v ? task_finish(ctx, futs[k]) : NULL;
+        if (r) {
+            list_append(v, r->val.list->items, list_len(r));
+            atom_del(r);
+        } else if (v) {
+            atom_unbind(v, env);
+            atom_del(v);
+            v = NULL;
+        }
+        if (futs[k])
+            future_release(futs[k]);
+    }
+    safe_free(futs);
+
+    if (!v) {
+        errmsg("Semantic", "task failed", NULL, NULL);
+        list_print(expr, 0);
+        return NULL;
+    }
+    atom_unbind(v, env);
+    return v;
+}
+
+/*
+--------------------------------------
+task_reduce
+
+    Fold the items of a list with f, starting at init.  Long lists are reduced in
+    chunks on task threads, and the chunk results are folded in list order, so the
+    result is the same as of a sequential fold if f is associative.
+--------------------------------------
+*/
+atom_t* task_reduce(alisp_ctx* ctx, atom_t* expr, atom_t* f, atom_t* init, atom_t* lst) {
+    int n = list_len(lst);
+    atom_t** items = lst->val.list->items;
+    int chunks = task_chunks(n);
+    if (chunks == 1)
+        return fold_items(ctx, expr, f, init, items, n);
+
+    future_t** futs = task_split(ctx, TASK_REDUCE, f, items, n, chunks);
+
+    // Fold chunk results in order, abandon the rest after a failure
+    atom_t* env = ctx->active_env;
+    atom_t* acc = init;
+    for (int k = 0; k < chunks; ++k) {
+        atom_t* r = futs[k] && acc ? task_finish(ctx, futs[k]) : NULL;
+        if (r) {
+            atom_bind(r, env);
+            acc = fold_items(ctx, expr, f, acc, &r, 1);
+            if (acc)
+                atom_bind(acc, env);
+            atom_unbind(r, env);
+            atom_del(r);
+            if (acc)
+                atom_unbind(acc, env);
+        } else
+            acc = NULL;
+        if (futs[k])
+            future_release(futs[k]);
+    }
+    safe_free(futs);
+
+    if (!acc) {
+        errmsg("Semantic", "task failed", NULL, NULL);
+        list_print(expr, 0);
+    }
+    return acc;
+}
@@ -13,17 +13,26 @@ Utilities.
 
 /* Display repl intro message. */
 void intromsg() {
-    printf("Alisp interpreter 0.1, May 2017.\n"
+    out_str("Alisp interpreter 0.1, May 2017.\n"
            "Type $help to view list of commands.\n");
 }
 
 /* Display help message. */
 void helpmsg() {
-    printf("Alisp interpreter.\n"
+    out_str("Alisp interpreter.\n"
            "Usage:\n"
            "    alisp                   REPL mode.\n"
            "    alisp script            Run script from file.\n"
-           "    alisp script -i         Run script from file and stay in REPL.\n");
+           "    alisp script -i         Run script from file and stay in REPL.\n"
+           "    alisp [script] --serve sock\n"
+           "                            Evaluate requests on a Unix socket, script is the prelude.\n"
+           "    alisp [script] --zygote Run scripts listed on stdin in processes forked after\n"
+           "                            the prelude script.\n"
+           "Options:\n"
+           "    -j N                    Parse script with N threads.\n"
+           "    --no-cache              Don't use .alc cache of parsed scripts.\n"
+           "    --image file            Load global environment from an image file.\n"
+           "    --workers N             Serve requests with N threads, or run N scripts at once.\n");
 }
 
 /* Display error message.
@@ -49,10 +58,10 @@ void errmsg(const char* type, const char* msg, const char* p, const char* s) {
         }
         err[i] = '\0', pre[errpos] = '\0';
         
-        printf("\x1b[91m" "%s error: " "\x1b[0m" "%s\n%s\n", type, msg, err);
-        printf("%s" "\x1b[92m" "^\n" "\x1b[0m", pre);
+        out_printf("\x1b[91m" "%s error: " "\x1b[0m" "%s\n%s\n", type, msg, err);
+        out_printf("%s" "\x1b[92m" "^\n" "\x1b[0m", pre);
     } else
-        printf("\x1b[91m" "%s error: " "\x1b[0m" "%s\n", type, msg);
+        out_printf("\x1b[91m" "%s error: " "\x1b[0m" "%s\n", type, msg);
 }
 
 
@@ -73,26 +82,64 @@ void safe_memory_free(void** p_addr) {
 // ---------------------------------------------------------------------- 
 // Strings
 
-/* Return symbolic string with quotes stripped. */
-char* strip_quotes(const char* a) {
-    size_t alen = strlen(a);
-    char* buf = malloc(alen - 1);
-    strncpy(buf, a + 1, alen - 2);
-    buf[alen - 2] = '\0';
-    return buf;
+/* Return true if strings are equal, false otherwise. */
+int streq(const char* s1, const char* s2) {
+    return !strcmp(s1, s2);
 }
 
-/* Return symbolic string with quotes stripped. */
-char* add_quotes(const char* a) {
-    size_t alen = strlen(a);
-    char* buf = malloc(alen + 3);
-    strcpy(buf + 1, a);
-    buf[0] = buf[alen + 1] = '"';
-    buf[alen + 2] = '\0';
-    return buf;
+
+// ---------------------------------------------------------------------- 
+// Byte buffers
+
+/* Append n bytes to a growable buffer. */
+void buf_put(buf_t* b, const void* p, size_t n) {
+    if (!n)
+        return;  // p may be NULL then
+    if (b->len + n > b->max) {
+        while (b->len + n > b->max)
+            b->max = b->max ? b->max * 2 : 4096;
+        b->data = realloc(b->data, b->max);
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
 }
 
-/* Return true if strings are equal, false otherwise. */
-int streq(const char* s1, const char* s2) {
-    return !strcmp(s1, s2);
+/* Append an unsigned LEB128 varint. */
+void buf_putv(buf_t* b, unsigned long long x) {
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n] = x & 0x7f;
+        x >>= 7;
+        if (x)
+            tmp[n] |= 0x80;
+        ++n;
+    } while (x);
+    buf_put(b, tmp, n);
+}
+
+/* Read a varint from [*p, end) and advance *p. Return 0 if data is malformed. */
+int buf_getv(const char** p, const char* end, unsigned long long* x) {
+    *x = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        unsigned char c = *(*p)++;
+        *x |= (unsigned long long)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return 1;
+    }
+    return 0;
+}
+
+
+// ---------------------------------------------------------------------- 
+// Hashing
+
+/* Return 64-bit FNV-1a hash of n bytes. */
+unsigned long long hash_bytes(const char* s, size_t n) {
+    unsigned long long h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
 }
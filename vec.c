@@ -0,0 +1,444 @@
+/*
+Vector: persistent sequence of immutable items.
+A vector never changes: setting, appending, merging and slicing return a new vector
+that shares the unchanged parts of the old one.  Items are kept in a tree of nodes with
+VEC_WIDTH slots (a radix-balanced tree indexed by the bits of the item index, VEC_BITS
+per level) and a tail leaf of the last items, so indexing and setting take O(log32 n)
+and appending takes amortized O(1).
+
+Nodes are shared between vectors and counted.  A node referenced once is changed in
+place, so building a vector item by item doesn't copy.  A slice is a window over the
+tree of another vector: it shares the whole tree and takes O(1).  Appending to a slice
+that ends inside its tree sets the next slot instead, without touching other vectors.
+
+Items are numbers, strings, symbols, vectors and frozen objects, since a vector must
+never see them change.  Numbers, strings and symbols are kept as private static atoms,
+counted in their bindings, and are copied on the way out.  Counts are atomic: vectors can be frozen and
+read by many threads at once.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alisp.h"
+
+#define VEC_MASK (VEC_WIDTH - 1)
+
+/* Tree node */
+typedef struct VecNode {
+    int   refs;
+    char  leaf;
+    void* slots[VEC_WIDTH];     // items of a leaf, children of an inner node
+} vnode_t;
+
+/* Vector */
+struct Vector {
+    int      refs;
+    int      off;       // window over the tree: first item
+    int      len;       //                       number of items
+    int      cnt;       // number of items in the tree and the tail
+    int      shift;     // index bits below the root
+    vnode_t* root;
+    vnode_t* tail;      // last items, not in the tree yet
+};
+
+#define ref(x)      __atomic_add_fetch(&(x), 1, __ATOMIC_RELAXED)
+#define unref(x)    __atomic_sub_fetch(&(x), 1, __ATOMIC_ACQ_REL)
+
+
+// ----------------------------------------------------------------------
+// Items
+
+/* Is an item a private atom of vectors? */
+static int item_private(atom_t* a) {
+    return a->type != NIL && (a->flags & F_STATIC);
+}
+
+/* Make an item of a value. Report and return NULL if the value is mutable. */
+static atom_t* item_new(atom_t* x) {
+    atom_t* a;
+    switch (x->type) {
+    case NIL:
+        return &nilobj;
+    case NUMBER:
+        a = num(*x->val.num);
+        break;
+    case SYMBOL:
+        a = sym(x->val.sym);
+        break;
+    case STRING:
+        a = str_copy(x);
+        break;
+    case VECTOR:
+        a = vec_share(x);
+        break;
+    default:
+        if (x->flags & F_FROZEN)
+            return x;
+        errmsg("Semantic", "vector items must be numbers, strings, vectors or frozen",
+               NULL, NULL);
+        return NULL;
+    }
+    a->flags = F_STATIC;  // never bound or deallocated by the interpreter
+    a->bindings = 1;
+    return a;
+}
+
+/* Drop a reference to an item. */
+static void item_release(atom_t* a) {
+    if (!a || !item_private(a) || unref(a->bindings))
+        return;
+    if (a->type == VECTOR)
+        vec_release(a->val.vec);
+    else if (a->type == STRING) {
+        str_del(a);
+        return;
+    } else
+        safe_free(a->val.sym);  // number or symbol storage
+    safe_free(a);
+}
+
+/* Return a value of an item for the interpreter. */
+static atom_t* item_get(atom_t* a) {
+    switch (a->type) {
+    case NUMBER:
+        return num(*a->val.num);
+    case SYMBOL:
+        return sym(a->val.sym);
+    case STRING:
+        return str_copy(a);
+    case VECTOR:
+        return vec_share(a);
+    default:
+        return a;  // nil or frozen
+    }
+}
+
+
+// ----------------------------------------------------------------------
+// Nodes
+
+static vnode_t* vnode_new(char leaf) {
+    vnode_t* n = calloc(1, sizeof(vnode_t));
+    n->refs = 1;
+    n->leaf = leaf;
+    return n;
+}
+
+/* Drop a reference to a node, deallocate it with the last one. */
+static void node_release(vnode_t* n) {
+    if (!n || unref(n->refs))
+        return;
+    for (int i = 0; i < VEC_WIDTH; ++i)
+        if (n->leaf)
+            item_release(n->slots[i]);
+        else
+            node_release(n->slots[i]);
+    safe_free(n);
+}
+
+/* Return a node that can be changed in place of a reference to n. */
+static vnode_t* node_own(vnode_t* n) {
+    if (__atomic_load_n(&n->refs, __ATOMIC_ACQUIRE) == 1)
+        return n;
+    vnode_t* c = vnode_new(n->leaf);
+    memcpy(c->slots, n->slots, sizeof(c->slots));
+    for (int i = 0; i < VEC_WIDTH; ++i)
+        if (!c->slots[i])
+            continue;
+        else if (c->leaf) {
+            if (item_private(c->slots[i]))
+                ref(((atom_t*)c->slots[i])->bindings);
+        } else
+            ref(((vnode_t*)c->slots[i])->refs);
+    node_release(n);
+    return c;
+}
+
+/* Make a path of inner nodes down to a leaf. */
+static vnode_t* node_path(int level, vnode_t* leaf) {
+    if (!level)
+        return leaf;
+    vnode_t* n = vnode_new(0);
+    n->slots[0] = node_path(level - VEC_BITS, leaf);
+    return n;
+}
+
+
+// ----------------------------------------------------------------------
+// Tree
+
+/* Index of the first item in the tail. */
+static int tailoff(int cnt) {
+    return cnt < VEC_WIDTH ? 0 : ((cnt - 1) >> VEC_BITS) << VEC_BITS;
+}
+
+/* Leaf holding the item at tree index i. */
+static vnode_t* leaf_for(vec_t* v, int i) {
+    if (i >= tailoff(v->cnt))
+        return v->tail;
+    vnode_t* n = v->root;
+    for (int level = v->shift; level > 0; level -= VEC_BITS)
+        n = n->slots[(i >> level) & VEC_MASK];
+    return n;
+}
+
+static vec_t* vec_alloc() {
+    vec_t* v = calloc(1, sizeof(vec_t));
+    v->refs = 1;
+    v->shift = VEC_BITS;
+    return v;
+}
+
+/* Make a vector sharing everything with v, to be changed by the caller. */
+static vec_t* vec_clone(vec_t* v) {
+    vec_t* c = malloc(sizeof(vec_t));
+    *c = *v;
+    c->refs = 1;
+    if (c->root)
+        ref(c->root->refs);
+    if (c->tail)
+        ref(c->tail->refs);
+    return c;
+}
+
+/* Replace the item at tree index i below an owned node. */
+static vnode_t* tree_set(vnode_t* n, int level, int i, atom_t* item) {
+    int k = (i >> level) & VEC_MASK;
+    if (!level) {
+        item_release(n->slots[k]);
+        n->slots[k] = item;
+    } else
+        n->slots[k] = tree_set(node_own(n->slots[k]), level - VEC_BITS, i, item);
+    return n;
+}
+
+/* Put a full tail leaf into the tree below an owned node. */
+static vnode_t* tree_push(vnode_t* n, int level, int cnt, vnode_t* leaf) {
+    int k = ((cnt - 1) >> level) & VEC_MASK;
+    if (level == VEC_BITS)
+        n->slots[k] = leaf;
+    else if (n->slots[k])
+        n->slots[k] = tree_push(node_own(n->slots[k]), level - VEC_BITS, cnt, leaf);
+    else
+        n->slots[k] = node_path(level - VEC_BITS, leaf);
+    return n;
+}
+
+/* Replace the item at tree index i of an owned vector. */
+static void vec_put(vec_t* v, int i, atom_t* item) {
+    if (i >= tailoff(v->cnt)) {
+        v->tail = node_own(v->tail);
+        item_release(v->tail->slots[i & VEC_MASK]);
+        v->tail->slots[i & VEC_MASK] = item;
+    } else
+        v->root = tree_set(node_own(v->root), v->shift, i, item);
+}
+
+/* Append an item to an owned vector. */
+static void vec_push(vec_t* v, atom_t* item) {
+    if (v->off + v->len < v->cnt) {  // window ends inside the tree
+        vec_put(v, v->off + v->len++, item);
+        return;
+    }
+
+    if (v->cnt - tailoff(v->cnt) < VEC_WIDTH)
+        v->tail = v->tail ? node_own(v->tail) : vnode_new(1);
+    else {
+        // Tail is full: move it to the tree, growing the tree a level if it is full
+        if ((v->cnt >> VEC_BITS) > (1 << v->shift)) {
+            vnode_t* root = vnode_new(0);
+            root->slots[0] = v->root;
+            root->slots[1] = node_path(v->shift, v->tail);
+            v->root = root;
+            v->shift += VEC_BITS;
+        } else
+            v->root = tree_push(v->root ? node_own(v->root) : vnode_new(0), v->shift, v->cnt,
+                                v->tail);
+        v->tail = vnode_new(1);
+    }
+    v->tail->slots[v->cnt & VEC_MASK] = item;
+    ++v->cnt;
+    ++v->len;
+}
+
+/* Return the item at index i of a vector, as kept. */
+static atom_t* vec_at(vec_t* v, int i) {
+    i += v->off;
+    return leaf_for(v, i)->slots[i & VEC_MASK];
+}
+
+/* Make a vector object. */
+static atom_t* vec_obj(vec_t* v) {
+    atom_t* obj = malloc(sizeof(atom_t));
+    obj->val.vec = v;
+    obj->type = VECTOR;
+    obj->flags = 0;
+    obj->bindings = 0;
+    return obj;
+}
+
+/* Append values to an owned vector. Return 0 if some value can't be an item. */
+static int vec_append(vec_t* v, atom_t** items, int n) {
+    for (int i = 0; i < n; ++i) {
+        atom_t* item = item_new(items[i]);
+        if (!item)
+            return 0;
+        vec_push(v, item);
+    }
+    return 1;
+}
+
+
+// ----------------------------------------------------------------------
+// Operations
+
+/* Drop a reference to a vector, deallocate it with the last one. */
+void vec_release(vec_t* v) {
+    if (unref(v->refs))
+        return;
+    node_release(v->root);
+    node_release(v->tail);
+    safe_free(v);
+}
+
+/* Return another object of the same vector. */
+atom_t* vec_share(atom_t* obj) {
+    ref(obj->val.vec->refs);
+    return vec_obj(obj->val.vec);
+}
+
+/* Return the number of items. */
+int vec_len(atom_t* obj) {
+    return obj->val.vec->len;
+}
+
+/* Return the item at index i as kept by the vector, for reading right away. */
+atom_t* vec_item(atom_t* obj, int i) {
+    return vec_at(obj->val.vec, i);
+}
+
+/*
+--------------------------------------
+vec_new
+
+    Make a vector of n values. Return NULL if some value can't be an item.
+--------------------------------------
+*/
+atom_t* vec_new(atom_t** items, int n) {
+    vec_t* v = vec_alloc();
+    if (!vec_append(v, items, n)) {
+        vec_release(v);
+        return NULL;
+    }
+    return vec_obj(v);
+}
+
+/* Append values to a vector being built, in place. Return 0 if some value can't be an item. */
+int vec_fill(atom_t* obj, atom_t** items, int n) {
+    return vec_append(obj->val.vec, items, n);
+}
+
+/* Return the item at index i. */
+atom_t* vec_get(atom_t* obj, int i) {
+    return item_get(vec_at(obj->val.vec, i));
+}
+
+/* Return a vector with the item at index i replaced, or NULL if x can't be an item. */
+atom_t* vec_set(atom_t* obj, int i, atom_t* x) {
+    atom_t* item = item_new(x);
+    if (!item)
+        return NULL;
+    vec_t* v = vec_clone(obj->val.vec);
+    vec_put(v, v->off + i, item);
+    return vec_obj(v);
+}
+
+/* Return a vector with n values appended, or NULL if some value can't be an item. */
+atom_t* vec_add(atom_t* obj, atom_t** items, int n) {
+    vec_t* v = vec_clone(obj->val.vec);
+    if (!vec_append(v, items, n)) {
+        vec_release(v);
+        return NULL;
+    }
+    return vec_obj(v);
+}
+
+/* Return a vector of items in range [from, to), sharing the tree. */
+atom_t* vec_slice(atom_t* obj, int from, int to) {
+    if (from >= to)
+        return vec_obj(vec_alloc());
+    vec_t* v = vec_clone(obj->val.vec);
+    v->off += from;
+    v->len = to - from;
+    return vec_obj(v);
+}
+
+/*
+--------------------------------------
+vec_merge
+
+    Return a vector of items of n vectors in order.  The first vector is shared and
+    the items of the rest are appended to it.
+--------------------------------------
+*/
+atom_t* vec_merge(atom_t** vecs, int n) {
+    vec_t* v = vec_clone(vecs[0]->val.vec);
+    for (int k = 1; k < n; ++k) {
+        vec_t* w = vecs[k]->val.vec;
+        for (int i = 0; i < w->len; ++i) {
+            atom_t* item = vec_at(w, i);
+            if (item_private(item))
+                ref(item->bindings);
+            vec_push(v, item);
+        }
+    }
+    return vec_obj(v);
+}
+
+/* Return a vector of list items, or NULL if some item can't be in a vector. */
+atom_t* vec_from(atom_t* lst) {
+    return vec_new(lst->val.list->items, list_len(lst));
+}
+
+/* Return a list of vector items. */
+atom_t* vec_list(atom_t* obj) {
+    vec_t* v = obj->val.vec;
+    atom_t* lst = list();
+    list_reserve(lst, v->len);
+    for (int i = 0; i < v->len; ++i)
+        list_add(lst, item_get(vec_at(v, i)));
+    return lst;
+}
+
+/*
+--------------------------------------
+vec_tostr
+
+    Make a string representing a vector.
+--------------------------------------
+*/
+char* vec_tostr(atom_t* obj, int depth) {
+    vec_t* v = obj->val.vec;
+    char* o;
+    char buf[1024];
+    strcpy(buf, "[");
+
+    for (int i = 0; i < v->len; ++i) {
+        o = atom_tostring(vec_at(v, i), depth ? depth - 1 : depth);
+        if (strlen(buf) + strlen(o) > 1000) {
+            safe_free(o);
+            strcat(buf, " ... ");
+            break;
+        }
+        strcat(buf, o);
+        safe_free(o);
+        if (i < v->len - 1)
+            strcat(buf, " ");
+    }
+
+    strcat(buf, "]");
+    o = malloc(strlen(buf) + 1);
+    strcpy(o, buf);
+    return o;
+}
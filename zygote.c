@@ -0,0 +1,78 @@
+/*
+Zygote.
+Runs a batch of scripts that share a prelude.  The prelude is evaluated once, then a
+process is forked for every script.  Children inherit the prelude environment
+copy-on-write, so they start instantly and don't copy it.
+
+For the pages to stay shared, objects of the prelude are marked shared before forking:
+binding bookkeeping skips them, and children never write to them unless the script
+changes them.  Children don't deallocate anything either, they exit right after the
+script.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "alisp.h"
+
+/* Wait for a child. Return 1 if it succeeded. */
+static int zygote_wait() {
+    int status;
+    while (wait(&status) < 0)
+        if (errno != EINTR)
+            return 0;
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+/*
+--------------------------------------
+zygote
+
+    Run scripts named on lines of standard input, each in a child process forked from
+    the context, at most `workers` at a time.  Return the number of failed scripts.
+--------------------------------------
+*/
+int zygote(alisp_ctx* ctx, int workers) {
+    atom_share(ctx->global_env, 1);
+    out_flush();  // children would write pending output again
+
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    int running = 0, failed = 0;
+
+    while ((n = getline(&line, &cap, stdin)) > 0) {
+        if (line[n - 1] == '\n')
+            line[--n] = '\0';
+        if (!n)
+            continue;
+
+        if (running == workers) {
+            failed += !zygote_wait();
+            --running;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            ++failed;
+            continue;
+        }
+        if (pid == 0) {
+            ctx->pool = NULL;  // parser threads are not inherited
+            int ok = script(ctx, line);
+            out_flush();
+            _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        ++running;
+    }
+
+    while (running--)
+        failed += !zygote_wait();
+    safe_free(line);
+    atom_share(ctx->global_env, 0);  // nothing changed here, counts are still right
+    return failed;
+}